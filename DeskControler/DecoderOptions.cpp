@@ -0,0 +1,45 @@
+#include "DecoderOptions.h"
+
+DecoderOptions& DecoderOptions::global()
+{
+	static DecoderOptions options;
+	return options;
+}
+
+void DecoderOptions::load(const QJsonObject& obj)
+{
+	const DecoderOptions defaults;
+	threadMode = obj["threadMode"].toString(defaults.threadMode).trimmed().toLower();
+	if (threadMode != "slice" && threadMode != "frame" && threadMode != "none") {
+		threadMode = defaults.threadMode;
+	}
+	threadCount = qBound(0, obj["threadCount"].toInt(defaults.threadCount), 32);
+	maxFrameDelay = qBound(0, obj["maxFrameDelay"].toInt(defaults.maxFrameDelay), 8);
+	decodePoolThreads = qBound(0, obj["decodePoolThreads"].toInt(defaults.decodePoolThreads), 64);
+	lowDelay = obj["lowDelay"].toBool(defaults.lowDelay);
+	fastDecode = obj["fastDecode"].toBool(defaults.fastDecode);
+	gpuConversion = obj["gpuConversion"].toBool(defaults.gpuConversion);
+	playoutBuffer = obj["playoutBuffer"].toBool(defaults.playoutBuffer);
+	maxPlayoutDelayMs = qBound(0, obj["maxPlayoutDelayMs"].toInt(defaults.maxPlayoutDelayMs), 2000);
+	catchUpMs = qBound(100, obj["catchUpMs"].toInt(defaults.catchUpMs), 10000);
+	statsInterval = qMax(10, obj["statsInterval"].toInt(defaults.statsInterval));
+	latencyTraceFile = obj["latencyTraceFile"].toString(defaults.latencyTraceFile).trimmed();
+}
+
+QJsonObject DecoderOptions::toJson() const
+{
+	QJsonObject obj;
+	obj["threadMode"] = threadMode;
+	obj["threadCount"] = threadCount;
+	obj["maxFrameDelay"] = maxFrameDelay;
+	obj["decodePoolThreads"] = decodePoolThreads;
+	obj["lowDelay"] = lowDelay;
+	obj["fastDecode"] = fastDecode;
+	obj["gpuConversion"] = gpuConversion;
+	obj["playoutBuffer"] = playoutBuffer;
+	obj["maxPlayoutDelayMs"] = maxPlayoutDelayMs;
+	obj["catchUpMs"] = catchUpMs;
+	obj["statsInterval"] = statsInterval;
+	obj["latencyTraceFile"] = latencyTraceFile;
+	return obj;
+}
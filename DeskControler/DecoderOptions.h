@@ -0,0 +1,48 @@
+#ifndef DECODEROPTIONS_H
+#define DECODEROPTIONS_H
+
+#include <QJsonObject>
+#include <QString>
+
+// 解码器运行参数，对应 DeskControler.json 中的 "decoder" 节点
+struct DecoderOptions
+{
+	// 多线程方式：slice（按 slice 并行，不增加延迟）/ frame（按帧并行）/ none（单线程）
+	// 服务端 x264 zerolatency 每帧编码为多个 slice，slice 线程即可并行
+	QString threadMode = "slice";
+	// 解码线程数，0 表示按 CPU 核数自动选择
+	int threadCount = 0;
+	// 帧线程每多一个线程输出就晚一帧，只有允许的延迟帧数大于 0 时才启用帧线程，
+	// 线程数不超过延迟帧数 + 1；服务端分片发送时需逐个 slice 送入解码器，此时退回 slice 线程
+	int maxFrameDelay = 0;
+	// 多个会话共享的解码线程池大小，0 表示按 CPU 核数，见 SessionScheduler
+	int decodePoolThreads = 0;
+
+	// AV_CODEC_FLAG_LOW_DELAY：不缓存重排帧，解码完成立即输出
+	bool lowDelay = true;
+	// AV_CODEC_FLAG2_FAST：允许不严格符合标准的加速（如跳过部分环路滤波精度）
+	bool fastDecode = false;
+
+	// 显示端支持时解码直接输出 YUV 平面，由着色器完成颜色转换和缩放；关闭时在解码线程转换为 RGBA
+	bool gpuConversion = true;
+
+	// 按采集时刻安排播放，吸收网络抖动，见 PlayoutBuffer
+	bool playoutBuffer = true;
+	// 播放缓冲的最大目标延迟
+	int maxPlayoutDelayMs = 200;
+	// 积压超过该时长时跳到缓冲中的关键帧，没有关键帧时向服务端请求
+	int catchUpMs = 500;
+
+	// 解码统计的窗口帧数
+	int statsInterval = 300;
+	// 非空时把每帧的逐段延迟持续追加到该 CSV 文件，见 LatencyTracer
+	QString latencyTraceFile;
+
+	// 全局配置，由 DeskControler::loadConfig 在启动时填充
+	static DecoderOptions& global();
+
+	void load(const QJsonObject& obj);
+	QJsonObject toJson() const;
+};
+
+#endif // DECODEROPTIONS_H
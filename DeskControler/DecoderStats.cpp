@@ -0,0 +1,37 @@
+#include "DecoderStats.h"
+
+DecoderStats::DecoderStats(int reportInterval)
+	: m_reportInterval(reportInterval)
+{
+}
+
+void DecoderStats::addFrame(qint64 decodeUs, qint64 convertUs)
+{
+	++m_frames;
+	m_decodeSumUs += decodeUs;
+	m_decodeMaxUs = qMax(m_decodeMaxUs, decodeUs);
+	m_convertSumUs += convertUs;
+	m_convertMaxUs = qMax(m_convertMaxUs, convertUs);
+}
+
+QString DecoderStats::summary(const QString& mode)
+{
+	QString text = QString("[Decoder-Stats] mode=%1 frames=%2 decode avg=%3 max=%4 ms, convert avg=%5 max=%6 ms")
+		.arg(mode)
+		.arg(m_frames)
+		.arg(m_frames ? m_decodeSumUs / 1000.0 / m_frames : 0.0, 0, 'f', 2)
+		.arg(m_decodeMaxUs / 1000.0, 0, 'f', 2)
+		.arg(m_frames ? m_convertSumUs / 1000.0 / m_frames : 0.0, 0, 'f', 2)
+		.arg(m_convertMaxUs / 1000.0, 0, 'f', 2);
+	reset();
+	return text;
+}
+
+void DecoderStats::reset()
+{
+	m_frames = 0;
+	m_decodeSumUs = 0;
+	m_decodeMaxUs = 0;
+	m_convertSumUs = 0;
+	m_convertMaxUs = 0;
+}
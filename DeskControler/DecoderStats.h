@@ -0,0 +1,29 @@
+#ifndef DECODERSTATS_H
+#define DECODERSTATS_H
+
+#include <QString>
+
+// 解码统计：按窗口累计每帧解码耗时和转换耗时，用于对比不同解码设置
+class DecoderStats
+{
+public:
+	explicit DecoderStats(int reportInterval = 300);
+
+	// 记录一帧：送入解码器到取出图像的耗时、YUV 转 RGBA 的耗时（微秒）
+	void addFrame(qint64 decodeUs, qint64 convertUs);
+
+	// 达到统计窗口时返回 true，调用方取 summary() 输出后自动开始新窗口
+	bool ready() const { return m_frames >= m_reportInterval; }
+	QString summary(const QString& mode);
+	void reset();
+
+private:
+	int m_reportInterval;
+	int m_frames = 0;
+	qint64 m_decodeSumUs = 0;
+	qint64 m_decodeMaxUs = 0;
+	qint64 m_convertSumUs = 0;
+	qint64 m_convertMaxUs = 0;
+};
+
+#endif // DECODERSTATS_H
@@ -1,15 +1,15 @@
 #include "DeskControler.h"
 #include <QScrollArea>
+#include <QApplication>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QFile>
 #include "VideoWidget.h"
 #include "LogWidget.h"
+#include "DecoderOptions.h"
 
 DeskControler::DeskControler(QWidget* parent)
-	: QWidget(parent),
-	 m_networkManager(nullptr),
-	 m_videoReceiver(nullptr)
+	: QWidget(parent)
 {
 	ui.setupUi(this);
 	// 将 LogWidget 放到界面上
@@ -19,10 +19,15 @@ DeskControler::DeskControler(QWidget* parent)
 	// 当点击按钮时，发起 TCP 连接并发送 PunchHoleRequest
 	connect(ui.pushButton, &QPushButton::clicked,
 		this, &DeskControler::onConnectClicked);
+	connect(qApp, &QApplication::focusChanged,
+		this, &DeskControler::onFocusChanged);
 }
 
 DeskControler::~DeskControler()
 {
+	while (!m_sessions.isEmpty()) {
+		destroyVideoSession(m_sessions.first());
+	}
 }
 
 
@@ -50,6 +55,7 @@ void DeskControler::loadConfig()
 			{"port", 21116}
 		};
 		config["uuid"] = "";
+		config["decoder"] = DecoderOptions().toJson();
 
 		if (file.open(QIODevice::WriteOnly)) {
 			QJsonDocument doc(config);
@@ -64,6 +70,7 @@ void DeskControler::loadConfig()
 	QString ip = serverObj["ip"].toString("127.0.0.1");
 	int port = serverObj["port"].toInt(21116);
 	QString uuid = config["uuid"].toString("");
+	DecoderOptions::global().load(config["decoder"].toObject());
 
 	// 设置 UI 控件
 	ui.ipLineEdit_->setText(ip);
@@ -79,6 +86,7 @@ void DeskControler::saveConfig()
 	serverObj["port"] = ui.portLineEdit_->text().toInt();
 	config["server"] = serverObj;
 	config["uuid"] = ui.lineEdit->text().trimmed();
+	config["decoder"] = DecoderOptions::global().toJson();
 
 	QJsonDocument doc(config);
 	QFile file("DeskControler.json");
@@ -99,44 +107,61 @@ void DeskControler::onConnectClicked()
 		return;
 	}
 
+	// 已经连接的被控端只切换到它的窗口
+	Session* existing = findSession(uuid);
+	if (existing) {
+		if (existing->window) {
+			existing->window->raise();
+			existing->window->activateWindow();
+		}
+		LogWidget::instance()->addLog(QString("Session %1 already open").arg(uuid), LogWidget::Info);
+		return;
+	}
+
 	saveConfig();
 	LogWidget::instance()->addLog(
 		QString("Attempting to connect to server at %1:%2 with UUID: %3").arg(ip).arg(port).arg(uuid),
 		LogWidget::Info
 	);
 
-	m_networkManager = new NetworkManager(this);
+	Session* session = new Session;
+	session->uuid = uuid;
+	session->networkManager = new NetworkManager(this);
 
 	// 当收到 NetworkManager 的 PunchHoleResponse 信号时调用本类槽
-	connect(m_networkManager, &NetworkManager::punchHoleResponseReceived,
+	connect(session->networkManager, &NetworkManager::punchHoleResponseReceived,
 		this, &DeskControler::onPunchHoleResponse);
 	// 网络出错
-	connect(m_networkManager, &NetworkManager::networkError,
+	connect(session->networkManager, &NetworkManager::networkError,
 		this, &DeskControler::onNetworkError);
 	// 连接断开
-	connect(m_networkManager, &NetworkManager::disconnected,
+	connect(session->networkManager, &NetworkManager::disconnected,
 		this, &DeskControler::onNetworkDisconnected);
 
-	if (!m_networkManager->connectToServer(ip, port)) {
-		m_networkManager->cleanup();
-		delete m_networkManager;
-		m_networkManager = nullptr;
+	if (!session->networkManager->connectToServer(ip, port)) {
+		session->networkManager->cleanup();
+		delete session->networkManager;
+		delete session;
 		return;
 	}
+	m_sessions.append(session);
 
-	ui.ipLineEdit_->setEnabled(false);
-	ui.portLineEdit_->setEnabled(false);
-	ui.lineEdit->setEnabled(false);
-	ui.pushButton->setEnabled(false);
+	// 等待本次打洞结果期间不再发起新连接，收到结果后可以继续连接其它被控端
+	setInputsEnabled(false);
 
 	LogWidget::instance()->addLog("Server connection established. Sending punch hole request.", LogWidget::Info);
 	// 连接成功后，发送 PunchHoleRequest
-	m_networkManager->sendPunchHoleRequest(uuid);
+	session->networkManager->sendPunchHoleRequest(uuid);
 
 }
 
 void DeskControler::onPunchHoleResponse(const QString& relayServer, int relayPort, int result)
 {
+	Session* session = findSession(sender());
+	if (!session || session->videoReceiver) {
+		return;
+	}
+
 	QString resultStr;
 	switch (result) {
 	case 0:
@@ -159,23 +184,21 @@ void DeskControler::onPunchHoleResponse(const QString& relayServer, int relayPor
 	LogWidget::LogLevel logLevel = (result == 0) ? LogWidget::Info : LogWidget::Error;
 
 	LogWidget::instance()->addLog(
-		QString("Punch hole response: %1 (Relay Server: %2, Port: %3)")
-		.arg(resultStr).arg(relayServer).arg(relayPort),
+		QString("Punch hole response for %1: %2 (Relay Server: %3, Port: %4)")
+		.arg(session->uuid).arg(resultStr).arg(relayServer).arg(relayPort),
 		logLevel
 	);
 
+	setInputsEnabled(true);
 	if (result != 0) {
-		ui.ipLineEdit_->setEnabled(true);
-		ui.portLineEdit_->setEnabled(true);
-		ui.lineEdit->setEnabled(true);
-		ui.pushButton->setEnabled(true);
+		destroyVideoSession(session);
 		return;
 	}
 
-	setupVideoSession(relayServer, relayPort, resultStr);
+	setupVideoSession(session, relayServer, relayPort, resultStr);
 }
 
-void DeskControler::setupVideoSession(const QString& relayServer, quint16 relayPort, const QString& status)
+void DeskControler::setupVideoSession(Session* session, const QString& relayServer, quint16 relayPort, const QString& status)
 {
 	LogWidget::instance()->addLog(
 		QString("Establishing video session via relay server %1:%2 - Status: %3").arg(relayServer).arg(relayPort).arg(status),
@@ -187,80 +210,199 @@ void DeskControler::setupVideoSession(const QString& relayServer, quint16 relayP
 
 	QScrollArea* scrollArea = new QScrollArea(this);
 	scrollArea->setWindowFlags(Qt::Window);
+	scrollArea->setWindowTitle(session->uuid);
 	scrollArea->setWidget(videoWidget);
+	// 画面按比例适应窗口，服务端按窗口大小编码，不再出现滚动条
+	scrollArea->setWidgetResizable(true);
 	scrollArea->setAttribute(Qt::WA_DeleteOnClose, true);
 
-	connect(scrollArea, &QObject::destroyed, this, [this]() {
-		destroyVideoSession();
+	session->window = scrollArea;
+	session->videoWidget = videoWidget;
+
+	connect(scrollArea, &QObject::destroyed, this, [this, session]() {
+		// 窗口已在析构，不能再访问
+		session->window = nullptr;
+		session->videoWidget = nullptr;
+		destroyVideoSession(session);
 		LogWidget::instance()->addLog("Video widget closed by user.", LogWidget::Info);
 		});
 
 	scrollArea->resize(QSize(1024, 768));
 	scrollArea->show();
 
-	m_videoReceiver = new VideoReceiver(this);
+	VideoReceiver* videoReceiver = new VideoReceiver(this);
+	session->videoReceiver = videoReceiver;
 
-	m_remoteClipboard = new RemoteClipboard(this);
-	m_remoteClipboard->setRemoteWindow(scrollArea);
-
-	if (m_remoteClipboard->start()) {
-		LogWidget::instance()->addLog("Global keyboard hook installed", LogWidget::Info);
-	}
-	else {
-		LogWidget::instance()->addLog("Failed to install global keyboard hook", LogWidget::Error);
+	if (!m_remoteClipboard) {
+		m_remoteClipboard = new RemoteClipboard(this);
+		if (m_remoteClipboard->start()) {
+			LogWidget::instance()->addLog("Global keyboard hook installed", LogWidget::Info);
+		}
+		else {
+			LogWidget::instance()->addLog("Failed to install global keyboard hook", LogWidget::Error);
+		}
+		// 本地 Ctrl+C 的剪贴板内容发给前台会话
+		connect(m_remoteClipboard, &RemoteClipboard::ctrlCPressed, this, [this](const ClipboardEvent& clipboardEvent) {
+			if (m_focusedSession && m_focusedSession->videoReceiver) {
+				m_focusedSession->videoReceiver->clipboardDataCaptured(clipboardEvent);
+			}
+			});
 	}
-	connect(m_remoteClipboard, &RemoteClipboard::ctrlCPressed,
-		m_videoReceiver, &VideoReceiver::clipboardDataCaptured);
 
 	connect(videoWidget, &VideoWidget::mouseEventCaptured,
-		m_videoReceiver, &VideoReceiver::mouseEventCaptured);
+		videoReceiver, &VideoReceiver::mouseEventCaptured);
 
 	QObject::connect(videoWidget, &VideoWidget::keyEventCaptured,
-		m_videoReceiver, &VideoReceiver::keyEventCaptured);
+		videoReceiver, &VideoReceiver::keyEventCaptured);
 
-	QObject::connect(m_videoReceiver, &VideoReceiver::onClipboardMessageReceived,
+	QObject::connect(videoReceiver, &VideoReceiver::onClipboardMessageReceived,
 		m_remoteClipboard, &RemoteClipboard::onClipboardMessageReceived);
+
+	connect(videoReceiver, &VideoReceiver::cursorEventReceived,
+		videoWidget, &VideoWidget::setCursorEvent);
+	connect(videoReceiver, &VideoReceiver::cursorShapeReceived,
+		videoWidget, &VideoWidget::addCursorShape);
 	
 
-	connect(m_videoReceiver, &VideoReceiver::frameReady, this, [videoWidget, scrollArea](const QImage& img) {
-		static bool firstFrame = true;
-		if (firstFrame && !img.isNull())
+	connect(videoWidget, &VideoWidget::viewportChanged,
+		videoReceiver, &VideoReceiver::viewportChanged);
+
+	// 解码帧经邮箱交给窗口，窗口重绘时取最新一帧
+	videoWidget->setFrameMailbox(videoReceiver->frameMailbox());
+	videoWidget->setLatencyTracer(videoReceiver->latencyTracer());
+	// 窗口的 YUV 着色器可用时，解码线程不再转换为 RGBA
+	connect(videoWidget, &VideoWidget::yuvSupportChanged,
+		videoReceiver, &VideoReceiver::setYuvOutput);
+	videoReceiver->setYuvOutput(videoWidget->supportsYuv());
+	// 每个会话各自记录第一帧
+	connect(videoReceiver, &VideoReceiver::frameAvailable, videoWidget, [videoWidget, uuid = session->uuid, firstFrame = true]() mutable {
+		if (firstFrame)
 		{
-			LogWidget::instance()->addLog("Video stream started and UI initialized.", LogWidget::Info);
-			QSize initialSize = img.size().expandedTo(QSize(800, 600));
-			scrollArea->resize(initialSize);
+			LogWidget::instance()->addLog(QString("Video stream started and UI initialized for %1.").arg(uuid), LogWidget::Info);
 			firstFrame = false;
 		}
-		videoWidget->setFrame(img);
+		videoWidget->update();
 		});
 
-	QString uuid = ui.lineEdit->text();
-	m_videoReceiver->startConnect(relayServer, static_cast<quint16>(relayPort), uuid);
+	// 新打开的会话在前台，其它会话转为后台缩略图
+	setFocusedSession(session);
+	videoReceiver->startConnect(relayServer, static_cast<quint16>(relayPort), session->uuid);
 }
 
-void DeskControler::destroyVideoSession()
+void DeskControler::destroyVideoSession(Session* session)
 {
-	if (m_remoteClipboard) {
+	if (!m_sessions.removeOne(session)) {
+		return;
+	}
+	if (m_focusedSession == session) {
+		m_focusedSession = nullptr;
+		if (m_remoteClipboard) {
+			m_remoteClipboard->setRemoteWindow(nullptr);
+		}
+	}
+
+	if (session->window) {
+		// 不再触发窗口关闭时的清理
+		disconnect(session->window, &QObject::destroyed, this, nullptr);
+		session->window->close();
+		session->window = nullptr;
+	}
+	if (session->videoReceiver) {
+		session->videoReceiver->stopReceiving();
+		delete session->videoReceiver;
+		session->videoReceiver = nullptr;
+	}
+	if (session->networkManager) {
+		// 打洞失败时在它自己的信号中调用，延后释放
+		session->networkManager->cleanup();
+		session->networkManager->deleteLater();
+		session->networkManager = nullptr;
+	}
+	delete session;
+
+	// 最后一个会话关闭后卸载全局键盘钩子
+	bool hasVideo = false;
+	for (Session* other : m_sessions) {
+		hasVideo = hasVideo || other->videoReceiver;
+	}
+	if (!hasVideo && m_remoteClipboard) {
 		m_remoteClipboard->stop();
 		delete m_remoteClipboard;
 		m_remoteClipboard = nullptr;
 	}
+}
+
+void DeskControler::setFocusedSession(Session* session)
+{
+	// 窗口显示时焦点可能先于接收端创建切换过来，总是重新下发一次
+	const bool changed = (session != m_focusedSession);
+	m_focusedSession = session;
+	for (Session* other : m_sessions) {
+		if (other->videoReceiver) {
+			other->videoReceiver->setFocused(other == session);
+		}
+	}
+	if (m_remoteClipboard) {
+		m_remoteClipboard->setRemoteWindow(session ? session->window : nullptr);
+	}
+	if (session && changed) {
+		LogWidget::instance()->addLog(QString("Session %1 is now in foreground").arg(session->uuid), LogWidget::Info);
+	}
+}
+
+void DeskControler::onFocusChanged(QWidget* old, QWidget* now)
+{
+	Q_UNUSED(old);
+	// 焦点离开所有会话窗口（切到主窗口或其它程序）时保持原前台会话
+	if (!now) {
+		return;
+	}
+	QWidget* window = now->window();
+	for (Session* session : m_sessions) {
+		if (session->window && session->window == window) {
+			setFocusedSession(session);
+			return;
+		}
+	}
+}
 
-	ui.pushButton->setEnabled(true);
-	ui.ipLineEdit_->setEnabled(true);
-	ui.portLineEdit_->setEnabled(true);
-	ui.lineEdit->setEnabled(true);
+DeskControler::Session* DeskControler::findSession(const QString& uuid) const
+{
+	for (Session* session : m_sessions) {
+		if (session->uuid == uuid) {
+			return session;
+		}
+	}
+	return nullptr;
+}
 
-	if (m_videoReceiver) {
-		m_videoReceiver->stopReceiving();
-		delete m_videoReceiver;
-		m_videoReceiver = nullptr;
+DeskControler::Session* DeskControler::findSession(const QObject* networkManager) const
+{
+	for (Session* session : m_sessions) {
+		if (session->networkManager == networkManager) {
+			return session;
+		}
 	}
-	if (m_networkManager) {
-		m_networkManager->cleanup();
-		delete m_networkManager;
-		m_networkManager = nullptr;
+	return nullptr;
+}
+
+void DeskControler::abandonPendingSession(const QObject* networkManager)
+{
+	Session* session = findSession(networkManager);
+	if (!session || session->videoReceiver) {
+		return;
 	}
+	LogWidget::instance()->addLog(QString("Connection request for %1 abandoned").arg(session->uuid), LogWidget::Warning);
+	destroyVideoSession(session);
+	setInputsEnabled(true);
+}
+
+void DeskControler::setInputsEnabled(bool enabled)
+{
+	ui.pushButton->setEnabled(enabled);
+	ui.ipLineEdit_->setEnabled(enabled);
+	ui.portLineEdit_->setEnabled(enabled);
+	ui.lineEdit->setEnabled(enabled);
 }
 
 
@@ -270,11 +412,11 @@ void DeskControler::onNetworkError(const QString& error)
 		QString("NetworkError %1").arg(error),
 		LogWidget::Warning
 	);
+	abandonPendingSession(sender());
 }
 
 void DeskControler::onNetworkDisconnected()
 {
 	LogWidget::instance()->addLog("Network connection disconnected.", LogWidget::Warning);
-	// 如果需要，恢复按钮可点击
-	ui.pushButton->setEnabled(true);
+	abandonPendingSession(sender());
 }
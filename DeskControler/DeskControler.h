@@ -1,12 +1,15 @@
 #pragma once
 
 #include <QtWidgets/QWidget>
+#include <QList>
 #include "NetworkManager.h"
 #include "VideoReceiver.h"
 #include "ui_DeskControler.h"
 #include "RemoteClipboard.h"
 
 class NetworkManager;
+class VideoWidget;
+class QScrollArea;
 
 class DeskControler : public QWidget
 {
@@ -21,16 +24,35 @@ private slots:
 	void onPunchHoleResponse(const QString& relayServer, int relayPort, int result);
 	void onNetworkError(const QString& error);
 	void onNetworkDisconnected();
+	// 输入焦点切换到某个会话窗口时，该会话成为前台会话
+	void onFocusChanged(QWidget* old, QWidget* now);
 
 private:
-	void setupVideoSession(const QString& relayServer, quint16 relayPort, const QString& status);
-	void destroyVideoSession();
+	// 一个被控端的连接，可以同时打开多个，共享网络 I/O 线程和解码线程池
+	struct Session
+	{
+		QString uuid;
+		NetworkManager* networkManager = nullptr;
+		VideoReceiver* videoReceiver = nullptr;
+		QScrollArea* window = nullptr;
+		VideoWidget* videoWidget = nullptr;
+	};
+
+	void setupVideoSession(Session* session, const QString& relayServer, quint16 relayPort, const QString& status);
+	void destroyVideoSession(Session* session);
+	void setFocusedSession(Session* session);
+	Session* findSession(const QString& uuid) const;
+	Session* findSession(const QObject* networkManager) const;
+	// 打洞结果到达前 ID 服务器连接出错或断开：丢弃这次连接，恢复输入
+	void abandonPendingSession(const QObject* networkManager);
+	void setInputsEnabled(bool enabled);
 
 	void loadConfig();
 	void saveConfig();
 private:
 	Ui::DeskControlerClass ui;
-	NetworkManager* m_networkManager;
-	VideoReceiver* m_videoReceiver;
+	QList<Session*> m_sessions;
+	Session* m_focusedSession = nullptr;
+	// 全局键盘钩子只有一个，所有会话共用，本地 Ctrl+C 发给前台会话
 	RemoteClipboard* m_remoteClipboard = nullptr;
 };
@@ -0,0 +1,112 @@
+#include "FrameBufferPool.h"
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+#define BUFFER_ALIGNMENT 64
+
+struct FrameBufferPool::Shared
+{
+	QMutex mutex;
+	QList<Buffer*> freeBuffers;
+	int maxFree = 0;
+	// 池已销毁，之后归还的缓冲区直接释放
+	bool closed = false;
+	Stats stats;
+};
+
+struct FrameBufferPool::Buffer
+{
+	// 持有共享状态，池销毁后仍在显示的缓冲区可以安全归还
+	QSharedPointer<Shared> shared;
+	uchar* data = nullptr;
+	qsizetype size = 0;
+};
+
+FrameBufferPool::FrameBufferPool(int maxFree)
+	: m_shared(new Shared)
+{
+	m_shared->maxFree = maxFree;
+}
+
+FrameBufferPool::~FrameBufferPool()
+{
+	QList<Buffer*> buffers;
+	{
+		QMutexLocker locker(&m_shared->mutex);
+		m_shared->closed = true;
+		buffers.swap(m_shared->freeBuffers);
+	}
+	for (Buffer* buffer : buffers) {
+		qFreeAligned(buffer->data);
+		delete buffer;
+	}
+}
+
+QImage FrameBufferPool::acquire(int width, int height, QImage::Format format)
+{
+	const qsizetype bytesPerLine = (static_cast<qsizetype>(width) * 4 + BUFFER_ALIGNMENT - 1) & ~qsizetype(BUFFER_ALIGNMENT - 1);
+	const qsizetype size = bytesPerLine * height;
+
+	Buffer* buffer = nullptr;
+	QList<Buffer*> stale;
+	{
+		QMutexLocker locker(&m_shared->mutex);
+		++m_shared->stats.acquired;
+		++m_shared->stats.outstanding;
+		while (!m_shared->freeBuffers.isEmpty()) {
+			Buffer* candidate = m_shared->freeBuffers.takeLast();
+			if (candidate->size == size) {
+				buffer = candidate;
+				break;
+			}
+			// 分辨率变化后旧尺寸的缓冲区不再使用
+			stale.append(candidate);
+		}
+		if (!buffer) {
+			++m_shared->stats.allocated;
+			m_shared->stats.allocatedBytes += size;
+		}
+	}
+	for (Buffer* candidate : stale) {
+		qFreeAligned(candidate->data);
+		delete candidate;
+	}
+	if (!buffer) {
+		buffer = new Buffer;
+		buffer->shared = m_shared;
+		buffer->data = static_cast<uchar*>(qMallocAligned(size, BUFFER_ALIGNMENT));
+		buffer->size = size;
+	}
+	return QImage(buffer->data, width, height, bytesPerLine, format, &FrameBufferPool::recycle, buffer);
+}
+
+void FrameBufferPool::recycle(void* info)
+{
+	Buffer* buffer = static_cast<Buffer*>(info);
+	// 先保留共享状态，释放 buffer 时不会连带释放互斥锁
+	QSharedPointer<Shared> shared = buffer->shared;
+	bool keep = false;
+	{
+		QMutexLocker locker(&shared->mutex);
+		--shared->stats.outstanding;
+		if (!shared->closed && shared->freeBuffers.size() < shared->maxFree) {
+			shared->freeBuffers.append(buffer);
+			keep = true;
+		}
+	}
+	if (!keep) {
+		qFreeAligned(buffer->data);
+		delete buffer;
+	}
+}
+
+FrameBufferPool::Stats FrameBufferPool::takeStats()
+{
+	QMutexLocker locker(&m_shared->mutex);
+	Stats stats = m_shared->stats;
+	m_shared->stats.acquired = 0;
+	m_shared->stats.allocated = 0;
+	m_shared->stats.allocatedBytes = 0;
+	return stats;
+}
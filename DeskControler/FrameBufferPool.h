@@ -0,0 +1,41 @@
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <QImage>
+#include <QSharedPointer>
+
+// 解码输出图像的缓冲池：按 64 字节对齐分配 RGBA 缓冲区，以 QImage 的形式交给显示端，
+// 最后一个引用释放时（显示端换到下一帧后）缓冲区回到池中，稳定状态下解码不再分配内存
+// acquire 只在解码线程调用，缓冲区可在任意线程归还
+class FrameBufferPool
+{
+public:
+	// maxFree 为池中保留的空闲缓冲区上限，需覆盖解码中、邮箱三个槽位和显示中的帧
+	explicit FrameBufferPool(int maxFree = 8);
+	~FrameBufferPool();
+
+	// 取一个 width x height 的图像，内容未初始化，每行按 64 字节对齐
+	QImage acquire(int width, int height, QImage::Format format = QImage::Format_RGBA8888);
+
+	// 统计窗口内的取用和新分配次数，用于对比内存分配情况
+	struct Stats
+	{
+		quint64 acquired = 0;
+		quint64 allocated = 0;
+		qint64 allocatedBytes = 0;
+		// 当前仍被解码端或显示端持有的缓冲区
+		int outstanding = 0;
+	};
+	// 取出统计并开始新窗口
+	Stats takeStats();
+
+private:
+	struct Shared;
+	struct Buffer;
+	// QImage 的 cleanupFunction，info 为 Buffer
+	static void recycle(void* info);
+
+	QSharedPointer<Shared> m_shared;
+};
+
+#endif // FRAMEBUFFERPOOL_H
@@ -0,0 +1,48 @@
+#include "FrameMailbox.h"
+
+bool FrameMailbox::publish(const QImage& image, const QRect& sourceRect, const QSize& screenSize, quint32 frameId)
+{
+	Frame& slot = m_slots[m_back];
+	slot.image = image;
+	slot.yuv.reset();
+	slot.sourceRect = sourceRect;
+	slot.screenSize = screenSize;
+	slot.frameId = frameId;
+	return commit();
+}
+
+bool FrameMailbox::publish(const QSharedPointer<AVFrame>& yuv, const QRect& sourceRect, const QSize& screenSize, quint32 frameId)
+{
+	Frame& slot = m_slots[m_back];
+	slot.image = QImage();
+	slot.yuv = yuv;
+	slot.sourceRect = sourceRect;
+	slot.screenSize = screenSize;
+	slot.frameId = frameId;
+	return commit();
+}
+
+bool FrameMailbox::commit()
+{
+	// 换回的槽位作为下一次写入的位置
+	const int previous = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel);
+	m_back = previous & ~FRESH;
+	m_published.fetch_add(1, std::memory_order_relaxed);
+	if (previous & FRESH) {
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+bool FrameMailbox::take(Frame& frame)
+{
+	if (!(m_middle.load(std::memory_order_acquire) & FRESH)) {
+		return false;
+	}
+	const int previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+	m_front = previous & ~FRESH;
+	// QImage 隐式共享，这里只增加引用计数；槽位之后被解码端覆盖时，显示端持有的图像不受影响
+	frame = m_slots[m_front];
+	return true;
+}
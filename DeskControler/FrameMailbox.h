@@ -0,0 +1,59 @@
+#ifndef FRAMEMAILBOX_H
+#define FRAMEMAILBOX_H
+
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QSharedPointer>
+#include <atomic>
+
+struct AVFrame;
+
+// 解码线程与显示线程之间的单槽邮箱（三缓冲，无锁）
+// 解码端总是写入最新一帧，显示端重绘时取走最新一帧，显示前被覆盖的帧直接丢弃，
+// 界面线程繁忙时不会在事件队列中堆积旧帧，显示延迟有上限
+class FrameMailbox
+{
+public:
+	struct Frame
+	{
+		// 解码线程已转换好的 RGBA 图像，或直接输出的 YUV420P 帧（引用解码器缓冲区，不拷贝），二者取其一
+		QImage image;
+		QSharedPointer<AVFrame> yuv;
+		// 画面对应的被控端屏幕区域和屏幕尺寸，旧版本服务端为空
+		QRect sourceRect;
+		QSize screenSize;
+		// 服务端帧序号，用于延迟统计
+		quint32 frameId = 0;
+	};
+
+	// 解码线程调用：写入最新一帧
+	// 返回 true 表示显示端已取走上一帧，需要通知显示端重绘；返回 false 表示上一帧未显示即被覆盖，通知已在途中
+	bool publish(const QImage& image, const QRect& sourceRect, const QSize& screenSize, quint32 frameId);
+	bool publish(const QSharedPointer<AVFrame>& yuv, const QRect& sourceRect, const QSize& screenSize, quint32 frameId);
+	// 显示线程调用：有新帧时取出并返回 true，否则 frame 不变
+	bool take(Frame& frame);
+
+	quint64 publishedFrames() const { return m_published.load(std::memory_order_relaxed); }
+	quint64 droppedFrames() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+	// 写好的槽位换到中间
+	bool commit();
+
+	// 中间槽位包含尚未取走的新帧
+	static const int FRESH = 0x4;
+
+	Frame m_slots[3];
+	// 写端独占的槽位
+	int m_back = 0;
+	// 读端独占的槽位
+	int m_front = 1;
+	// 两端交换的槽位下标，附带 FRESH 标记
+	std::atomic<int> m_middle{ 2 };
+
+	std::atomic<quint64> m_published{ 0 };
+	std::atomic<quint64> m_dropped{ 0 };
+};
+
+#endif // FRAMEMAILBOX_H
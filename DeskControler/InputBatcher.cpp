@@ -0,0 +1,57 @@
+#include "InputBatcher.h"
+
+// 与 VideoWidget.h 中的 MouseMove 相同
+#define MOUSE_MOVE_MASK 0x01
+
+bool InputBatcher::addMouseEvent(int x, int y, int mask)
+{
+	++m_received;
+	const bool move = (mask == MOUSE_MOVE_MASK);
+	if (move && m_lastIsMove) {
+		MouseEvent* last = m_pending.last().mutable_mouse_event();
+		last->set_x(x);
+		last->set_y(y);
+		++m_merged;
+		return false;
+	}
+
+	InputControlEvent event;
+	MouseEvent* mouseEvent = event.mutable_mouse_event();
+	mouseEvent->set_x(x);
+	mouseEvent->set_y(y);
+	mouseEvent->set_mask(mask);
+	m_pending.append(event);
+	m_lastIsMove = move;
+	return !move;
+}
+
+void InputBatcher::addKeyEvent(int key, bool pressed)
+{
+	++m_received;
+	InputControlEvent event;
+	KeyboardEvent* keyboardEvent = event.mutable_keyboard_event();
+	keyboardEvent->set_key(key);
+	keyboardEvent->set_pressed(pressed);
+	m_pending.append(event);
+	m_lastIsMove = false;
+}
+
+bool InputBatcher::takeMessage(RendezvousMessage& msg)
+{
+	if (m_pending.isEmpty()) {
+		return false;
+	}
+	if (m_pending.size() == 1) {
+		*msg.mutable_inputcontrolevent() = m_pending.first();
+	}
+	else {
+		InputEventBatch* batch = msg.mutable_inputcontrolevent()->mutable_batch();
+		for (const InputControlEvent& event : m_pending) {
+			*batch->add_events() = event;
+		}
+	}
+	m_pending.clear();
+	m_lastIsMove = false;
+	++m_sent;
+	return true;
+}
@@ -0,0 +1,37 @@
+#ifndef INPUTBATCHER_H
+#define INPUTBATCHER_H
+
+#include <QList>
+#include "rendezvous.pb.h"
+
+// 输入合并：同一发送间隔内连续的鼠标移动只保留最后一个位置，按键和按钮事件原样保留并保持顺序
+// 待发送的事件达到一条以上时打包为 InputEventBatch，一条时按原格式发送，兼容旧版本服务端
+// 只在网络线程中使用
+class InputBatcher
+{
+public:
+	// 加入鼠标事件。纯移动返回 false，可以等到发送间隔再发；按钮等其它事件返回 true，应立即发送
+	bool addMouseEvent(int x, int y, int mask);
+	// 加入键盘事件，总是应立即发送
+	void addKeyEvent(int key, bool pressed);
+
+	bool isEmpty() const { return m_pending.isEmpty(); }
+	// 取出待发送的事件填入 msg，没有事件时返回 false
+	bool takeMessage(RendezvousMessage& msg);
+
+	// 累计收到的事件数、被合并掉的移动数和实际发送的消息数
+	quint64 receivedEvents() const { return m_received; }
+	quint64 mergedMoves() const { return m_merged; }
+	quint64 sentMessages() const { return m_sent; }
+
+private:
+	QList<InputControlEvent> m_pending;
+	// 最后一个待发送事件是纯移动，新的移动可以直接覆盖它
+	bool m_lastIsMove = false;
+
+	quint64 m_received = 0;
+	quint64 m_merged = 0;
+	quint64 m_sent = 0;
+};
+
+#endif // INPUTBATCHER_H
@@ -0,0 +1,121 @@
+#include "InputRateLimiter.h"
+#include <algorithm>
+
+// 移动发送间隔的上下限：下限约 120 次/秒；画面静止时帧间隔很大，上限保证悬停反馈不会太迟
+#define MIN_MOVE_INTERVAL_MS 8
+#define MAX_FRAME_INTERVAL_MS 50
+// 帧间隔滑动平均系数
+#define FRAME_INTERVAL_ALPHA 0.1
+// 往返时间超过基线该值视为链路排队，放慢倍数翻倍，最多 4 倍；恢复后逐次减半
+#define RTT_QUEUING_US 30000
+#define MAX_BACKOFF 4
+#define RTT_SAMPLE_COUNT 30
+// 输入带宽预算（字节/秒），约 32 kbit/s，令牌桶容量为 250 ms 的预算
+#define INPUT_BUDGET_BYTES_PER_SEC 4000
+#define TOKEN_BUCKET_MS 250
+
+InputRateLimiter::InputRateLimiter()
+{
+	m_clock.start();
+	reset();
+}
+
+void InputRateLimiter::reset()
+{
+	m_lastMoveMs = -1;
+	m_lastCaptureUs = 0;
+	m_frameIntervalUs = 0.0;
+	m_rttSamples.clear();
+	m_backoff = 1;
+	m_tokens = INPUT_BUDGET_BYTES_PER_SEC * TOKEN_BUCKET_MS / 1000.0;
+	m_lastRefillMs = m_clock.elapsed();
+	m_window.start();
+	m_windowBytes = 0;
+	m_windowMessages = 0;
+}
+
+void InputRateLimiter::videoFrame(qint64 captureUs)
+{
+	// 参数集等没有采集时刻；分片、分块模式下同一帧的多个包采集时刻相同
+	if (captureUs <= 0 || captureUs == m_lastCaptureUs) {
+		return;
+	}
+	const qint64 delta = captureUs - m_lastCaptureUs;
+	m_lastCaptureUs = captureUs;
+	if (delta <= 0 || delta > MAX_FRAME_INTERVAL_MS * 1000 * 4) {
+		return;
+	}
+	if (m_frameIntervalUs <= 0.0)
+		m_frameIntervalUs = delta;
+	else
+		m_frameIntervalUs += FRAME_INTERVAL_ALPHA * (delta - m_frameIntervalUs);
+}
+
+void InputRateLimiter::rttSample(qint64 rttUs)
+{
+	if (rttUs <= 0) {
+		return;
+	}
+	m_rttSamples.append(rttUs);
+	while (m_rttSamples.size() > RTT_SAMPLE_COUNT) {
+		m_rttSamples.removeFirst();
+	}
+	const qint64 baseline = *std::min_element(m_rttSamples.cbegin(), m_rttSamples.cend());
+	if (rttUs - baseline > RTT_QUEUING_US)
+		m_backoff = qMin(m_backoff * 2, MAX_BACKOFF);
+	else
+		m_backoff = qMax(m_backoff / 2, 1);
+}
+
+int InputRateLimiter::moveIntervalMs() const
+{
+	const int frameMs = qBound(MIN_MOVE_INTERVAL_MS, static_cast<int>(m_frameIntervalUs / 1000.0), MAX_FRAME_INTERVAL_MS);
+	return frameMs * m_backoff;
+}
+
+void InputRateLimiter::refill()
+{
+	const qint64 now = m_clock.elapsed();
+	m_tokens = qMin(m_tokens + (now - m_lastRefillMs) * INPUT_BUDGET_BYTES_PER_SEC / 1000.0,
+		INPUT_BUDGET_BYTES_PER_SEC * TOKEN_BUCKET_MS / 1000.0);
+	m_lastRefillMs = now;
+}
+
+int InputRateLimiter::moveDelayMs()
+{
+	refill();
+	int delay = 0;
+	if (m_lastMoveMs >= 0) {
+		delay = qMax<qint64>(0, m_lastMoveMs + moveIntervalMs() - m_clock.elapsed());
+	}
+	// 预算不足时等到补足一条消息的令牌（按钮和按键可以让令牌变为负数）
+	if (m_tokens < 0.0) {
+		delay = qMax(delay, static_cast<int>(-m_tokens * 1000 / INPUT_BUDGET_BYTES_PER_SEC) + 1);
+	}
+	return delay;
+}
+
+void InputRateLimiter::messageSent(int bytes)
+{
+	refill();
+	m_tokens -= bytes;
+	m_lastMoveMs = m_clock.elapsed();
+	m_windowBytes += bytes;
+	++m_windowMessages;
+}
+
+QString InputRateLimiter::summary()
+{
+	const qint64 elapsedMs = qMax<qint64>(m_window.elapsed(), 1);
+	const QString text = QString("%1 msg/s, %2 B/s of %3 B/s budget, move interval %4 ms (frame %5 ms, backoff x%6)")
+		.arg(m_windowMessages * 1000.0 / elapsedMs, 0, 'f', 1)
+		.arg(m_windowBytes * 1000 / elapsedMs)
+		.arg(INPUT_BUDGET_BYTES_PER_SEC)
+		.arg(moveIntervalMs())
+		.arg(m_frameIntervalUs / 1000.0, 0, 'f', 1)
+		.arg(m_backoff);
+	m_window.restart();
+	m_windowBytes = 0;
+	m_windowMessages = 0;
+	return text;
+}
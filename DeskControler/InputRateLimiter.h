@@ -0,0 +1,57 @@
+#ifndef INPUTRATELIMITER_H
+#define INPUTRATELIMITER_H
+
+#include <QString>
+#include <QElapsedTimer>
+#include <QList>
+
+// 鼠标移动的发送节奏：间隔跟随视频帧间隔（指针位置只在下一帧画面中可见，发得更快没有意义），
+// 往返时间明显高于基线（链路排队）时成倍放慢，同时用令牌桶把输入占用限制在固定带宽预算内
+// 按钮和按键事件不受限制，但同样计入预算。只在网络线程中使用
+class InputRateLimiter
+{
+public:
+	InputRateLimiter();
+
+	// 收到一帧视频（采集时刻，微秒），更新帧间隔估计
+	void videoFrame(qint64 captureUs);
+	// 时钟同步得到的往返时间（微秒）
+	void rttSample(qint64 rttUs);
+	// 已发送一条输入消息（含长度头和估计的 TCP/IP 开销）
+	void messageSent(int bytes);
+
+	// 距离下一次允许发送移动还需等待的毫秒数
+	int moveDelayMs();
+	// 当前的移动发送间隔
+	int moveIntervalMs() const;
+	// 最近统计窗口内的输入占用和当前节奏，用于日志
+	QString summary();
+
+	void reset();
+
+private:
+	// 令牌按预算速率补充，上限为一小段时间的预算
+	void refill();
+
+	QElapsedTimer m_clock;
+	qint64 m_lastMoveMs = -1;
+
+	// 帧间隔的滑动平均（微秒）
+	qint64 m_lastCaptureUs = 0;
+	double m_frameIntervalUs = 0.0;
+
+	// 最近的往返时间样本，最小值作为无排队时的基线
+	QList<qint64> m_rttSamples;
+	// 排队时的放慢倍数
+	int m_backoff = 1;
+
+	double m_tokens = 0.0;
+	qint64 m_lastRefillMs = 0;
+
+	// 统计窗口
+	QElapsedTimer m_window;
+	qint64 m_windowBytes = 0;
+	int m_windowMessages = 0;
+};
+
+#endif // INPUTRATELIMITER_H
@@ -0,0 +1,366 @@
+#include "LatencyTracer.h"
+#include "DecoderOptions.h"
+#include "LogWidget.h"
+#include <QTextStream>
+#include <algorithm>
+#include <chrono>
+
+// 未显示的帧（被邮箱覆盖、追赶时跳过）超过该数量时清理最旧的
+#define MAX_IN_FLIGHT 300
+// 参与统计和导出的最近帧数
+#define COMPLETED_CAPACITY 600
+// 估计时钟差使用的最近同步样本数
+#define SYNC_SAMPLE_COUNT 10
+// 持续输出文件的刷新间隔（行）
+#define TRACE_FILE_FLUSH_ROWS 60
+
+LatencyTracer::LatencyTracer()
+{
+	m_completed.reserve(COMPLETED_CAPACITY);
+}
+
+LatencyTracer::~LatencyTracer()
+{
+	if (m_traceFile.isOpen()) {
+		m_traceFile.close();
+	}
+}
+
+qint64 LatencyTracer::nowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const QVector<double>& LatencyTracer::histogramBounds()
+{
+	static const QVector<double> bounds = { 2, 5, 10, 20, 50, 100, 200, 500 };
+	return bounds;
+}
+
+QString LatencyTracer::stageName(int stage)
+{
+	static const char* names[StageCount] = {
+		"Encode", "Send", "Uplink", "Downlink", "Buffer", "Decode", "Present", "Total"
+	};
+	return QString::fromLatin1(names[stage]);
+}
+
+void LatencyTracer::reset()
+{
+	QMutexLocker locker(&m_mutex);
+	m_inFlight.clear();
+	m_completed.clear();
+	m_completedNext = 0;
+	m_syncSamples.clear();
+	m_serverOffsetValid = false;
+	m_relayOffsetValid = false;
+}
+
+void LatencyTracer::frameReceived(const InpuVideoFrame& frame, qint64 relayUs, qint64 receiveUs)
+{
+	// 参数集等非画面包没有采集时刻
+	if (frame.capture_time_us() == 0) {
+		return;
+	}
+	QMutexLocker locker(&m_mutex);
+	Trace& trace = m_inFlight[frame.frame_id()];
+	if (trace.captureUs != static_cast<qint64>(frame.capture_time_us())) {
+		// 新的一帧，或服务端重连后序号重复
+		trace = Trace();
+		trace.frameId = frame.frame_id();
+		trace.captureUs = static_cast<qint64>(frame.capture_time_us());
+		trace.encodeDoneUs = static_cast<qint64>(frame.encode_done_us());
+		trace.sendUs = static_cast<qint64>(frame.send_time_us());
+	}
+	// 同一帧的后续 slice/tile：以最后一个包为准
+	trace.relayUs = relayUs;
+	trace.receiveUs = receiveUs;
+
+	if (m_inFlight.size() > MAX_IN_FLIGHT) {
+		// 清理最旧的一半，按采集时刻判断
+		QVector<qint64> captures;
+		captures.reserve(m_inFlight.size());
+		for (auto it = m_inFlight.cbegin(); it != m_inFlight.cend(); ++it) {
+			captures.append(it->captureUs);
+		}
+		std::nth_element(captures.begin(), captures.begin() + captures.size() / 2, captures.end());
+		const qint64 cutoff = captures[captures.size() / 2];
+		for (auto it = m_inFlight.begin(); it != m_inFlight.end();) {
+			if (it->captureUs < cutoff)
+				it = m_inFlight.erase(it);
+			else
+				++it;
+		}
+	}
+}
+
+void LatencyTracer::addTimeSync(const TimeSync& sync, qint64 relayResponseUs, qint64 receiveUs)
+{
+	// NTP 算法：t0 本端发送，t1/t2 被控端收发，t3 本端收到
+	const qint64 t0 = static_cast<qint64>(sync.client_send_us());
+	const qint64 t1 = static_cast<qint64>(sync.server_receive_us());
+	const qint64 t2 = static_cast<qint64>(sync.server_send_us());
+	const qint64 t3 = receiveUs;
+	if (t0 == 0 || t1 == 0 || t2 < t1 || t3 < t0) {
+		return;
+	}
+	SyncSample sample;
+	sample.rttUs = (t3 - t0) - (t2 - t1);
+	sample.serverOffsetUs = ((t1 - t0) + (t2 - t3)) / 2;
+	// 中继在请求和回复两个方向各打一次时间戳，同样按对称路径估计
+	const qint64 r1 = static_cast<qint64>(sync.relay_request_us());
+	const qint64 r2 = relayResponseUs;
+	if (r1 > 0 && r2 >= r1) {
+		sample.relayOffsetUs = ((r1 - t0) + (r2 - t3)) / 2;
+		sample.hasRelay = true;
+	}
+
+	QMutexLocker locker(&m_mutex);
+	m_syncSamples.append(sample);
+	while (m_syncSamples.size() > SYNC_SAMPLE_COUNT) {
+		m_syncSamples.removeFirst();
+	}
+	updateOffsets();
+}
+
+void LatencyTracer::updateOffsets()
+{
+	// 往返时间最小的样本排队最少，路径最接近对称
+	const SyncSample* best = nullptr;
+	for (const SyncSample& sample : m_syncSamples) {
+		if (!best || sample.rttUs < best->rttUs) {
+			best = &sample;
+		}
+	}
+	if (!best) {
+		return;
+	}
+	m_serverOffsetUs = best->serverOffsetUs;
+	m_serverOffsetValid = true;
+	m_syncRttUs = best->rttUs;
+	m_relayOffsetValid = best->hasRelay;
+	m_relayOffsetUs = best->relayOffsetUs;
+}
+
+void LatencyTracer::frameReleased(quint32 frameId)
+{
+	QMutexLocker locker(&m_mutex);
+	auto it = m_inFlight.find(frameId);
+	if (it != m_inFlight.end()) {
+		it->releasedUs = nowUs();
+	}
+}
+
+void LatencyTracer::frameDecoded(quint32 frameId)
+{
+	QMutexLocker locker(&m_mutex);
+	auto it = m_inFlight.find(frameId);
+	if (it != m_inFlight.end()) {
+		it->decodedUs = nowUs();
+	}
+}
+
+void LatencyTracer::framePresented(quint32 frameId)
+{
+	QMutexLocker locker(&m_mutex);
+	auto it = m_inFlight.find(frameId);
+	if (it == m_inFlight.end() || it->decodedUs == 0) {
+		return;
+	}
+	Trace trace = it.value();
+	m_inFlight.erase(it);
+	trace.presentedUs = nowUs();
+	trace.serverOffsetUs = m_serverOffsetUs;
+	trace.serverOffsetValid = m_serverOffsetValid;
+	trace.relayOffsetUs = m_relayOffsetUs;
+	trace.relayOffsetValid = m_relayOffsetValid && trace.relayUs > 0;
+	complete(trace);
+}
+
+void LatencyTracer::complete(Trace trace)
+{
+	if (m_completed.size() < COMPLETED_CAPACITY) {
+		m_completed.append(trace);
+	}
+	else {
+		m_completed[m_completedNext] = trace;
+	}
+	m_completedNext = (m_completedNext + 1) % COMPLETED_CAPACITY;
+
+	if (!DecoderOptions::global().latencyTraceFile.isEmpty()) {
+		appendToTraceFile(trace);
+	}
+}
+
+bool LatencyTracer::stageUs(const Trace& trace, int stage, qint64& us)
+{
+	// 换算到本端时钟
+	const qint64 serverSendUs = trace.sendUs - trace.serverOffsetUs;
+	const qint64 relayUs = trace.relayUs - trace.relayOffsetUs;
+	switch (stage) {
+	case StageEncode:
+		if (trace.encodeDoneUs == 0)
+			return false;
+		us = trace.encodeDoneUs - trace.captureUs;
+		return true;
+	case StageSend:
+		if (trace.encodeDoneUs == 0 || trace.sendUs == 0)
+			return false;
+		us = trace.sendUs - trace.encodeDoneUs;
+		return true;
+	case StageUplink:
+		if (!trace.serverOffsetValid || trace.sendUs == 0)
+			return false;
+		us = (trace.relayOffsetValid ? relayUs : trace.receiveUs) - serverSendUs;
+		return true;
+	case StageDownlink:
+		if (!trace.relayOffsetValid)
+			return false;
+		us = trace.receiveUs - relayUs;
+		return true;
+	case StageBuffer:
+		if (trace.releasedUs == 0)
+			return false;
+		us = trace.releasedUs - trace.receiveUs;
+		return true;
+	case StageDecode:
+		us = trace.decodedUs - (trace.releasedUs ? trace.releasedUs : trace.receiveUs);
+		return true;
+	case StagePresent:
+		us = trace.presentedUs - trace.decodedUs;
+		return true;
+	case StageTotal:
+		if (!trace.serverOffsetValid)
+			return false;
+		us = trace.presentedUs - (trace.captureUs - trace.serverOffsetUs);
+		return true;
+	default:
+		return false;
+	}
+}
+
+QVector<LatencyTracer::StageSummary> LatencyTracer::summarize()
+{
+	QMutexLocker locker(&m_mutex);
+	const QVector<double>& bounds = histogramBounds();
+	QVector<StageSummary> result(StageCount);
+	QVector<double> values;
+	values.reserve(m_completed.size());
+	for (int stage = 0; stage < StageCount; ++stage) {
+		StageSummary& summary = result[stage];
+		summary.name = stageName(stage);
+		summary.histogram.fill(0, bounds.size() + 1);
+		values.clear();
+		for (const Trace& trace : m_completed) {
+			qint64 us = 0;
+			if (!stageUs(trace, stage, us)) {
+				continue;
+			}
+			// 时钟差估计误差可能让很短的网络段略小于 0
+			const double ms = qMax<qint64>(us, 0) / 1000.0;
+			values.append(ms);
+			const int bucket = static_cast<int>(std::lower_bound(bounds.begin(), bounds.end(), ms) - bounds.begin());
+			++summary.histogram[bucket];
+		}
+		summary.samples = values.size();
+		if (values.isEmpty()) {
+			continue;
+		}
+		std::sort(values.begin(), values.end());
+		summary.p50Ms = values[values.size() / 2];
+		summary.p95Ms = values[qMin(values.size() - 1, values.size() * 95 / 100)];
+		summary.maxMs = values.last();
+	}
+	return result;
+}
+
+QString LatencyTracer::clockStatus()
+{
+	QMutexLocker locker(&m_mutex);
+	if (!m_serverOffsetValid) {
+		return "clock: not synchronized";
+	}
+	QString status = QString("clock: server %1 ms, rtt %2 ms")
+		.arg(m_serverOffsetUs / 1000.0, 0, 'f', 1)
+		.arg(m_syncRttUs / 1000.0, 0, 'f', 1);
+	if (m_relayOffsetValid) {
+		status += QString(", relay %1 ms").arg(m_relayOffsetUs / 1000.0, 0, 'f', 1);
+	}
+	return status;
+}
+
+QString LatencyTracer::csvHeader()
+{
+	QStringList columns = { "frame_id", "capture_us", "encode_done_us", "send_us", "relay_us",
+		"receive_us", "released_us", "decoded_us", "presented_us", "server_offset_us", "relay_offset_us" };
+	for (int stage = 0; stage < StageCount; ++stage) {
+		columns.append(stageName(stage).toLower() + "_ms");
+	}
+	return columns.join(',');
+}
+
+QString LatencyTracer::csvRow(const Trace& trace)
+{
+	// 原始时间戳保持各自的时钟，时钟差单独列出，未同步时为空
+	QStringList columns;
+	columns << QString::number(trace.frameId)
+		<< QString::number(trace.captureUs)
+		<< QString::number(trace.encodeDoneUs)
+		<< QString::number(trace.sendUs)
+		<< QString::number(trace.relayUs)
+		<< QString::number(trace.receiveUs)
+		<< QString::number(trace.releasedUs)
+		<< QString::number(trace.decodedUs)
+		<< QString::number(trace.presentedUs)
+		<< (trace.serverOffsetValid ? QString::number(trace.serverOffsetUs) : QString())
+		<< (trace.relayOffsetValid ? QString::number(trace.relayOffsetUs) : QString());
+	for (int stage = 0; stage < StageCount; ++stage) {
+		qint64 us = 0;
+		columns << (stageUs(trace, stage, us) ? QString::number(us / 1000.0, 'f', 3) : QString());
+	}
+	return columns.join(',');
+}
+
+bool LatencyTracer::exportCsv(const QString& path)
+{
+	QMutexLocker locker(&m_mutex);
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		return false;
+	}
+	QTextStream out(&file);
+	out << csvHeader() << '\n';
+	// 环形缓冲按时间顺序输出
+	const int count = m_completed.size();
+	const int start = (count < COMPLETED_CAPACITY) ? 0 : m_completedNext;
+	for (int i = 0; i < count; ++i) {
+		out << csvRow(m_completed[(start + i) % count]) << '\n';
+	}
+	return true;
+}
+
+void LatencyTracer::appendToTraceFile(const Trace& trace)
+{
+	if (m_traceFileFailed) {
+		return;
+	}
+	if (!m_traceFile.isOpen()) {
+		m_traceFile.setFileName(DecoderOptions::global().latencyTraceFile);
+		if (!m_traceFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+			m_traceFileFailed = true;
+			LogWidget::instance()->addLog(QString("[Latency] Cannot open trace file %1: %2")
+				.arg(m_traceFile.fileName(), m_traceFile.errorString()), LogWidget::Warning);
+			return;
+		}
+		if (m_traceFile.size() == 0) {
+			m_traceFile.write(csvHeader().toUtf8() + '\n');
+		}
+		LogWidget::instance()->addLog(QString("[Latency] Writing per-frame trace to %1").arg(m_traceFile.fileName()),
+			LogWidget::Info);
+	}
+	m_traceFile.write(csvRow(trace).toUtf8() + '\n');
+	if (++m_traceFileRows % TRACE_FILE_FLUSH_ROWS == 0) {
+		m_traceFile.flush();
+	}
+}
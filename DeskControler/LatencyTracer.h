@@ -0,0 +1,131 @@
+#ifndef LATENCYTRACER_H
+#define LATENCYTRACER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QFile>
+#include "rendezvous.pb.h"
+
+// 画面端到端延迟跟踪：按帧序号汇总被控端的采集、编码完成、发送时刻，中继转发时刻，
+// 以及本端的接收、出播放缓冲、解码完成、显示时刻，换算到本端时钟后分段统计
+// 被控端和中继的时钟差由 TimeSync 往返估计。网络、解码、显示线程都会调用，内部加锁
+class LatencyTracer
+{
+public:
+	// 分段，顺序即显示顺序
+	enum Stage
+	{
+		StageEncode = 0,  // 采集 -> 编码完成
+		StageSend,        // 编码完成 -> 交给网络发送
+		StageUplink,      // 被控端发送 -> 中继转发（无中继时间戳时为整段网络）
+		StageDownlink,    // 中继转发 -> 本端收到
+		StageBuffer,      // 收到 -> 出播放缓冲
+		StageDecode,      // 出播放缓冲 -> 解码完成
+		StagePresent,     // 解码完成 -> 显示
+		StageTotal,       // 采集 -> 显示
+		StageCount
+	};
+
+	struct StageSummary
+	{
+		QString name;
+		int samples = 0;
+		double p50Ms = 0.0;
+		double p95Ms = 0.0;
+		double maxMs = 0.0;
+		// 按 histogramBounds() 分桶的帧数，最后一桶为超过最大上界的部分
+		QVector<int> histogram;
+	};
+
+	LatencyTracer();
+	~LatencyTracer();
+
+	// 本端单调时钟（微秒），与被控端、中继使用同一种时钟，只有偏移不同
+	static qint64 nowUs();
+	// 直方图各桶的上界（毫秒）
+	static const QVector<double>& histogramBounds();
+
+	// 网络线程：收到带时间戳的视频包。relayUs 为中继追加的转发时刻，没有时为 0
+	// 分片、分块模式下同一帧的多个包以最后一个包的到达时刻为准
+	void frameReceived(const InpuVideoFrame& frame, qint64 relayUs, qint64 receiveUs);
+	// 网络线程：收到 TimeSync 回复，relayResponseUs 为回复经过中继时的时刻
+	void addTimeSync(const TimeSync& sync, qint64 relayResponseUs, qint64 receiveUs);
+	// 解码线程：帧离开播放缓冲、解码输出
+	void frameReleased(quint32 frameId);
+	void frameDecoded(quint32 frameId);
+	// 界面线程：帧已绘制
+	void framePresented(quint32 frameId);
+
+	// 最近若干帧的分段统计
+	QVector<StageSummary> summarize();
+	// 时钟同步状态，用于显示
+	QString clockStatus();
+	// 把最近若干帧的逐段数据写入 CSV
+	bool exportCsv(const QString& path);
+
+	void reset();
+
+private:
+	struct Trace
+	{
+		quint32 frameId = 0;
+		// 被控端时钟
+		qint64 captureUs = 0;
+		qint64 encodeDoneUs = 0;
+		qint64 sendUs = 0;
+		// 中继时钟
+		qint64 relayUs = 0;
+		// 本端时钟
+		qint64 receiveUs = 0;
+		qint64 releasedUs = 0;
+		qint64 decodedUs = 0;
+		qint64 presentedUs = 0;
+		// 完成时的时钟差（对端时钟 - 本端时钟），未同步时 valid 为 false
+		qint64 serverOffsetUs = 0;
+		qint64 relayOffsetUs = 0;
+		bool serverOffsetValid = false;
+		bool relayOffsetValid = false;
+	};
+
+	struct SyncSample
+	{
+		qint64 rttUs = 0;
+		qint64 serverOffsetUs = 0;
+		qint64 relayOffsetUs = 0;
+		bool hasRelay = false;
+	};
+
+	// 分段耗时（微秒），该段无法计算时返回 false
+	static bool stageUs(const Trace& trace, int stage, qint64& us);
+	static QString stageName(int stage);
+	static QString csvHeader();
+	static QString csvRow(const Trace& trace);
+	// 取最近样本中往返时间最小的一个作为当前时钟差
+	void updateOffsets();
+	void complete(Trace trace);
+	void appendToTraceFile(const Trace& trace);
+
+	QMutex m_mutex;
+	// 尚未显示的帧
+	QHash<quint32, Trace> m_inFlight;
+	// 已显示帧的环形缓冲
+	QVector<Trace> m_completed;
+	int m_completedNext = 0;
+
+	QList<SyncSample> m_syncSamples;
+	qint64 m_serverOffsetUs = 0;
+	qint64 m_relayOffsetUs = 0;
+	qint64 m_syncRttUs = 0;
+	bool m_serverOffsetValid = false;
+	bool m_relayOffsetValid = false;
+
+	// 持续输出的 CSV 文件，由 DecoderOptions::latencyTraceFile 指定
+	QFile m_traceFile;
+	bool m_traceFileFailed = false;
+	int m_traceFileRows = 0;
+};
+
+#endif // LATENCYTRACER_H
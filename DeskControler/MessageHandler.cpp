@@ -34,6 +34,7 @@ void MessageHandler::processReceivedData(const QByteArray& data)
 		emit parseError("Failed to parse RendezvousMessage");
 		return;
 	}
+	m_lastRelayTimeUs = static_cast<qint64>(msg.relay_time_us());
 
 	if (msg.has_punch_hole_response()) {
 		const PunchHoleResponse& response = msg.punch_hole_response();
@@ -43,13 +44,21 @@ void MessageHandler::processReceivedData(const QByteArray& data)
 		emit punchHoleResponseReceived(relayServer, relayPort, result);
 	}
 	else if (msg.has_inpuvideoframe()) {
-		const InpuVideoFrame& frame = msg.inpuvideoframe();
-		emit InpuVideoFrameReceived(QByteArray::fromStdString(frame.data()));
+		emit InpuVideoFrameReceived(msg.inpuvideoframe());
 	}
 	else if (msg.has_clipboardevent()) {
 		const ClipboardEvent& clipboardEvent = msg.clipboardevent();
 		emit onClipboardMessageReceived(clipboardEvent);
 	}
+	else if (msg.has_cursor_event()) {
+		emit cursorEventReceived(msg.cursor_event());
+	}
+	else if (msg.has_cursor_shape()) {
+		emit cursorShapeReceived(msg.cursor_shape());
+	}
+	else if (msg.has_time_sync()) {
+		emit timeSyncReceived(msg.time_sync());
+	}
 	else {
 		emit parseError("Received unknown message type");
 	}
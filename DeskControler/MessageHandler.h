@@ -3,26 +3,43 @@
 #include <QObject>
 #include "rendezvous.pb.h"
 
+Q_DECLARE_METATYPE(InpuVideoFrame)
+Q_DECLARE_METATYPE(CursorEvent)
+Q_DECLARE_METATYPE(CursorShape)
+
 class MessageHandler : public QObject {
 	Q_OBJECT
 public:
 	explicit MessageHandler(QObject* parent = nullptr);
 	~MessageHandler();
 
-	//  PunchHoleRequest Ϣuuid תΪ bytes
+	// 生成 PunchHoleRequest 消息，uuid 转为 bytes
 	QByteArray createPunchHoleRequestMessage(const QString& uuid);
 
-	// յݣ󷢳Ӧź
+	// 处理接收到的数据，解析后发出相应信号
 	void processReceivedData(const QByteArray& data);
 
+	// 当前正在处理的消息经过中继时追加的中继时刻，没有时为 0，在发出信号的槽中读取
+	qint64 lastRelayTimeUs() const { return m_lastRelayTimeUs; }
+
 signals:
-	// յ PunchHoleResponse ʱźţ relay_serverrelay_port ͽöֵ
+	// 当接收到 PunchHoleResponse 时发出信号，反馈 relay_server、relay_port 和结果（枚举值）
 	void punchHoleResponseReceived(const QString& relayServer, int relayPort, int result);
 
-	void InpuVideoFrameReceived(const QByteArray& packetData);
-	// Ϣ
+	// 视频帧（分片模式下为单个 slice），携带帧序号等信息
+	void InpuVideoFrameReceived(const InpuVideoFrame& frame);
+	// 消息解析错误
 	void parseError(const QString& error);
 
 	void onClipboardMessageReceived(const ClipboardEvent& clipboardEvent);
-	
+
+	// 被控端指针位置和形状，与视频分开传输
+	void cursorEventReceived(const CursorEvent& cursorEvent);
+	void cursorShapeReceived(const CursorShape& cursorShape);
+
+	// 时钟同步回复
+	void timeSyncReceived(const TimeSync& timeSync);
+
+private:
+	qint64 m_lastRelayTimeUs = 0;
 };
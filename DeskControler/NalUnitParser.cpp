@@ -0,0 +1,32 @@
+#include "NalUnitParser.h"
+
+QList<NalUnit> NalUnitParser::split(const uint8_t* data, int size, bool hevc)
+{
+	QList<NalUnit> units;
+	int start = -1;
+	int i = 0;
+	while (i + 3 <= size) {
+		// 查找起始码 00 00 01
+		if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+			// 四字节起始码时把前导 0 也算进当前 NAL
+			int codeStart = (i > 0 && data[i - 1] == 0) ? i - 1 : i;
+			if (start >= 0) {
+				units.last().size = codeStart - start;
+			}
+			NalUnit unit;
+			unit.data = data + codeStart;
+			if (i + 3 < size) {
+				unit.type = hevc ? ((data[i + 3] >> 1) & 0x3F) : (data[i + 3] & 0x1F);
+			}
+			units.append(unit);
+			start = codeStart;
+			i += 3;
+			continue;
+		}
+		++i;
+	}
+	if (start >= 0) {
+		units.last().size = size - start;
+	}
+	return units;
+}
@@ -7,11 +7,11 @@ NetworkManager::NetworkManager(QObject* parent)
 	: QObject(parent),
 	socket(new QTcpSocket(this))
 {
-	//  QTcpSocket ź
+	// 连接 QTcpSocket 信号
 	connect(socket, &QTcpSocket::readyRead, this, &NetworkManager::onReadyRead);
 	connect(socket, &QTcpSocket::disconnected, this, &NetworkManager::onSocketDisconnected);
 
-	//  MessageHandler ڲźתź
+	// 将 MessageHandler 内部信号转发到本类信号
 	connect(&messageHandler, &MessageHandler::punchHoleResponseReceived,
 		this, &NetworkManager::punchHoleResponseReceived);
 }
@@ -36,9 +36,9 @@ void NetworkManager::cleanup()
 
 bool NetworkManager::connectToServer(const QString& ip, quint16 port)
 {
-	// 룬֧ URL ʽ
+	// 解析输入，支持 URL 格式
 	QUrl url = QUrl::fromUserInput(ip);
-	//  URL ɹȡ hostʹԭʼַ
+	// 如果 URL 解析成功，则提取 host，否则使用原始字符串
 	QString host = url.host().isEmpty() ? ip : url.host();
 
 	QHostAddress resolvedAddress;
@@ -49,7 +49,7 @@ bool NetworkManager::connectToServer(const QString& ip, quint16 port)
 			LogWidget::instance()->addLog(error, LogWidget::Error);
 			return false;
 		}
-		// ַбɸѡ IPv4 ַ
+		// 遍历地址列表，筛选 IPv4 地址
 		bool foundIPv4 = false;
 		for (const QHostAddress& address : info.addresses()) {
 			if (address.protocol() == QAbstractSocket::IPv4Protocol) {
@@ -67,7 +67,7 @@ bool NetworkManager::connectToServer(const QString& ip, quint16 port)
 	else {
 		LogWidget::instance()->addLog(QString("Host address directly parsed: %1").arg(host), LogWidget::Info);
 	}
-	// ʹýĵַ
+	// 使用解析后的地址建立连接
 	socket->connectToHost(resolvedAddress, port);
 	if (!socket->waitForConnected(500)) {
 		QString error = QString("Connection to %1:%2 failed: %3")
@@ -13,17 +13,17 @@ public:
 
 	void cleanup();
 
-	//  TCP 
+	// 建立 TCP 连接
 	bool connectToServer(const QString& ip, quint16 port);
-	//  PunchHoleRequest Ϣڲ MessageHandler
+	// 发送 PunchHoleRequest 消息（内部调用 MessageHandler）
 	void sendPunchHoleRequest(const QString& uuid);
 
 signals:
-	// ֱӽڲ MessageHandler  PunchHoleResponse  UI 
+	// 直接将内部 MessageHandler 解析的 PunchHoleResponse 结果反馈给 UI 层
 	void punchHoleResponseReceived(const QString& relayServer, int relayPort, int result);
-	// Ϣ
+	// 网络或消息解析错误
 	void networkError(const QString& error);
-	// ӶϿ
+	// 连接断开
 	void disconnected();
 
 private slots:
@@ -32,6 +32,6 @@ private slots:
 
 private:
 	QTcpSocket* socket;
-	MessageHandler messageHandler;  // ڲϢ߼
+	MessageHandler messageHandler;  // 内部包含消息处理逻辑
 	QByteArray m_buffer;
 };
@@ -1,19 +1,53 @@
 #include "NetworkWorker.h"
 #include "LogWidget.h"
+#include "VideoDecoderWorker.h"
+#include "LatencyTracer.h"
 #include "rendezvous.pb.h"
 #include <QUrl>
 #include <QtNetwork/QHostInfo>
 #include <QtEndian>
 #include <QKeyEvent>
 
+// 时钟同步间隔，取最近若干次中往返时间最小的一次
+#define TIME_SYNC_INTERVAL_MS 2000
+#define INPUT_STATS_INTERVAL_MS 30000
+// 每条输入消息估计的 TCP/IP 头部开销，计入输入带宽预算
+#define TCP_IP_OVERHEAD_BYTES 40
+// 后台会话的缩略图尺寸和帧率上限
+#define BACKGROUND_THUMBNAIL_W 480
+#define BACKGROUND_THUMBNAIL_H 270
+#define BACKGROUND_MAX_FPS 5
+
 NetworkWorker::NetworkWorker(QObject* parent)
 	: QObject(parent)
 {
 	connect(&messageHandler, &MessageHandler::InpuVideoFrameReceived,
 		this, &NetworkWorker::packetReady);
+	connect(&messageHandler, &MessageHandler::InpuVideoFrameReceived,
+		this, &NetworkWorker::sendCodecCapabilities);
 
 	connect(&messageHandler, &MessageHandler::onClipboardMessageReceived,
 		this, &NetworkWorker::onClipboardMessageReceived);
+
+	connect(&messageHandler, &MessageHandler::cursorEventReceived,
+		this, &NetworkWorker::cursorEventReceived);
+	connect(&messageHandler, &MessageHandler::cursorShapeReceived,
+		this, &NetworkWorker::cursorShapeReceived);
+
+	m_timeSyncTimer = new QTimer(this);
+	connect(m_timeSyncTimer, &QTimer::timeout, this, &NetworkWorker::sendTimeSync);
+
+	m_inputTimer = new QTimer(this);
+	m_inputTimer->setSingleShot(true);
+	m_inputTimer->setTimerType(Qt::PreciseTimer);
+	connect(m_inputTimer, &QTimer::timeout, this, &NetworkWorker::flushInput);
+
+	// 移动的发送节奏跟随视频帧间隔和往返时间
+	connect(&messageHandler, &MessageHandler::InpuVideoFrameReceived, this, [this](const InpuVideoFrame& frame) {
+		m_inputRate.videoFrame(static_cast<qint64>(frame.capture_time_us()));
+		});
+	connect(&messageHandler, &MessageHandler::timeSyncReceived,
+		this, &NetworkWorker::onTimeSyncReceived);
 }
 
 NetworkWorker::~NetworkWorker()
@@ -22,8 +56,19 @@ NetworkWorker::~NetworkWorker()
 }
 
 
+void NetworkWorker::setLatencyTracer(const QSharedPointer<LatencyTracer>& tracer)
+{
+	m_latencyTracer = tracer;
+	if (m_latencyTracer) {
+		connect(&messageHandler, &MessageHandler::InpuVideoFrameReceived,
+			this, &NetworkWorker::traceVideoFrame);
+	}
+}
+
 void NetworkWorker::cleanup()
 {
+	m_timeSyncTimer->stop();
+	m_inputTimer->stop();
 	if (m_socket) {
 		m_socket->disconnect();
 		if (m_socket->state() != QAbstractSocket::UnconnectedState) {
@@ -38,9 +83,9 @@ void NetworkWorker::cleanup()
 void NetworkWorker::connectToServer(const QString& ip, quint16 port, const QString& uuid)
 {
 
-	// 룬֧ URL ʽ
+	// 解析输入，支持 URL 格式
 	QUrl url = QUrl::fromUserInput(ip);
-	//  URL ɹȡ hostʹԭʼַ
+	// 如果 URL 解析成功，则提取 host，否则使用原始字符串
 	QString host = url.host().isEmpty() ? ip : url.host();
 
 	LogWidget::instance()->addLog(QString("Connecting to host: %1, port: %2").arg(host).arg(port), LogWidget::Info);
@@ -53,7 +98,7 @@ void NetworkWorker::connectToServer(const QString& ip, quint16 port, const QStri
 			LogWidget::instance()->addLog(error, LogWidget::Error);
 			return;
 		}
-		// ַбɸѡ IPv4 ַ
+		// 遍历地址列表，筛选 IPv4 地址
 		bool foundIPv4 = false;
 		for (const QHostAddress& address : info.addresses()) {
 			if (address.protocol() == QAbstractSocket::IPv4Protocol) {
@@ -95,8 +140,10 @@ void NetworkWorker::onSocketConnected()
 	QString info = QString("Connected to server [%1:%2]").arg(m_socket->peerAddress().toString()).arg(m_socket->peerPort());
 	LogWidget::instance()->addLog(info, LogWidget::Info);
 	emit connectedToServer();
+	m_capabilitiesSent = false;
+	m_inputRate.reset();
 
-	// ӳɹ RequestRelay Ϣ
+	// 连接成功后发送 RequestRelay 消息
 	sendRequestRelay();
 }
 
@@ -136,8 +183,9 @@ void NetworkWorker::sendRequestRelay()
 void NetworkWorker::onSocketReadyRead()
 {
 	m_buffer.append(m_socket->readAll());
+	m_readUs = LatencyTracer::nowUs();
 
-	// Э飺 [4ֽڴ] + []
+	// 协议： [4字节大端序包长] + [包数据]
 	while (m_buffer.size() >= 4) {
 		quint32 packetSize;
 		memcpy(&packetSize, m_buffer.constData(), 4);
@@ -157,116 +205,205 @@ void NetworkWorker::onSocketReadyRead()
 
 void NetworkWorker::sendMouseEventToServer(int x, int y, int mask)
 {
-	MouseEvent mouseEvent;
-	mouseEvent.set_x(x);
-	mouseEvent.set_y(y);
-	mouseEvent.set_mask(mask);
+	// 移动按 InputRateLimiter 的节奏发送，等待期间只保留最新位置；按钮事件连同之前的移动立即发送
+	if (m_inputBatcher.addMouseEvent(x, y, mask)) {
+		flushInput();
+	}
+	else if (!m_inputTimer->isActive()) {
+		m_inputTimer->start(m_inputRate.moveDelayMs());
+	}
+}
 
-	InputControlEvent inputEvent;
-	*inputEvent.mutable_mouse_event() = mouseEvent;
+void NetworkWorker::sendKeyEventToServer(int key, bool pressed)
+{
+	m_inputBatcher.addKeyEvent(key, pressed);
+	flushInput();
+}
 
+void NetworkWorker::flushInput()
+{
+	m_inputTimer->stop();
 	RendezvousMessage msg;
-	*msg.mutable_inputcontrolevent() = inputEvent;
+	if (!m_inputBatcher.takeMessage(msg)) {
+		return;
+	}
+	if (sendMessage(msg)) {
+		m_inputRate.messageSent(static_cast<int>(msg.ByteSizeLong()) + 4 + TCP_IP_OVERHEAD_BYTES);
+	}
+
+	if (!m_inputStatsTimer.isValid()) {
+		m_inputStatsTimer.start();
+	}
+	else if (m_inputStatsTimer.elapsed() >= INPUT_STATS_INTERVAL_MS) {
+		LogWidget::instance()->addLog(QString("[Input] events=%1 messages=%2 merged moves=%3, %4")
+			.arg(m_inputBatcher.receivedEvents())
+			.arg(m_inputBatcher.sentMessages())
+			.arg(m_inputBatcher.mergedMoves())
+			.arg(m_inputRate.summary()), LogWidget::Info);
+		m_inputStatsTimer.restart();
+	}
+}
+
+void NetworkWorker::sendClipboardEventToServer(const ClipboardEvent& clipboardEvent)
+{
+	if (m_socket->state() != QAbstractSocket::ConnectedState) {
+		return;  // 如果没有连接上 RelayServer，就不发送
+	}
+
+	// 组装 ClipboardEvent 消息到 RendezvousMessage 中
+	RendezvousMessage msg;
+	*msg.mutable_clipboardevent() = clipboardEvent;
 
 	std::string serialized;
 	if (!msg.SerializeToString(&serialized)) {
-		LogWidget::instance()->addLog("Failed to serialize MouseEvent message", LogWidget::Error);
+		LogWidget::instance()->addLog("Failed to serialize ClipboardEvent message", LogWidget::Error);
 		return;
 	}
 
 	QByteArray protobufData(serialized.data(), serialized.size());
 
-	// 㳤ͷ
+	// 计算长度头（大端序）
 	quint32 len = static_cast<quint32>(protobufData.size());
-	quint32 len_be = qToBigEndian(len); // ת
+	quint32 len_be = qToBigEndian(len); // 大端序转换
 
-	// 
+	// 构造完整数据
 	QByteArray sendData;
 	sendData.append(reinterpret_cast<const char*>(&len_be), sizeof(len_be));
 	sendData.append(protobufData);
 
+	LogWidget::instance()->addLog("sendClipboardEventToServer", LogWidget::Error);
 	if (m_socket && m_socket->state() == QAbstractSocket::ConnectedState) {
 		m_socket->write(sendData);
 		m_socket->flush();
 	}
 }
 
-void NetworkWorker::sendKeyEventToServer(int key, bool pressed)
-{
-	if (m_socket->state() != QAbstractSocket::ConnectedState) {
-		return;  // û RelayServerͲ
-	}
-
-	// װ KeyboardEvent Protobuf Ϣ
-	KeyboardEvent keyboardEvent;
-	keyboardEvent.set_key(key);
-	keyboardEvent.set_pressed(pressed);
 
-	InputControlEvent inputEvent;
-	*inputEvent.mutable_keyboard_event() = keyboardEvent;
 
+void NetworkWorker::sendKeyframeRequestToServer(int reason)
+{
 	RendezvousMessage msg;
-	*msg.mutable_inputcontrolevent() = inputEvent;
+	msg.mutable_keyframe_request()->set_reason(static_cast<KeyframeRequest::Reason>(reason));
+	if (sendMessage(msg)) {
+		LogWidget::instance()->addLog(QString("Keyframe requested, reason %1").arg(reason), LogWidget::Info);
+	}
+}
 
-	std::string serialized;
-	if (!msg.SerializeToString(&serialized)) {
-		LogWidget::instance()->addLog("Failed to serialize MouseEvent message", LogWidget::Error);
+void NetworkWorker::sendCodecCapabilities()
+{
+	// RequestRelay 之后服务端可能尚未配对，收到第一帧说明对端已就绪
+	if (m_capabilitiesSent) {
 		return;
 	}
+	RendezvousMessage msg;
+	CodecCapabilities* capabilities = msg.mutable_codec_capabilities();
+	QStringList names;
+	for (int codec : VideoDecoderWorker::availableCodecs()) {
+		capabilities->add_decoders(static_cast<VideoCodec>(codec));
+		names.append(QString::fromStdString(VideoCodec_Name(static_cast<VideoCodec>(codec))));
+	}
+	if (sendMessage(msg)) {
+		m_capabilitiesSent = true;
+		LogWidget::instance()->addLog(QString("Sent codec capabilities: %1").arg(names.join(", ")), LogWidget::Info);
+		sendViewport();
+		sendTimeSync();
+		m_timeSyncTimer->start(TIME_SYNC_INTERVAL_MS);
+	}
+}
 
-	QByteArray protobufData(serialized.data(), serialized.size());
+void NetworkWorker::traceVideoFrame(const InpuVideoFrame& frame)
+{
+	m_latencyTracer->frameReceived(frame, messageHandler.lastRelayTimeUs(), m_readUs);
+}
 
-	// 㳤ͷ
-	quint32 len = static_cast<quint32>(protobufData.size());
-	quint32 len_be = qToBigEndian(len); // ת
+void NetworkWorker::sendTimeSync()
+{
+	RendezvousMessage msg;
+	msg.mutable_time_sync()->set_client_send_us(LatencyTracer::nowUs());
+	sendMessage(msg);
+}
 
-	// 
-	QByteArray sendData;
-	sendData.append(reinterpret_cast<const char*>(&len_be), sizeof(len_be));
-	sendData.append(protobufData);
+void NetworkWorker::onTimeSyncReceived(const TimeSync& timeSync)
+{
+	// 往返时间扣除被控端的处理时间
+	if (timeSync.client_send_us() > 0 && timeSync.server_send_us() >= timeSync.server_receive_us()) {
+		m_inputRate.rttSample((m_readUs - static_cast<qint64>(timeSync.client_send_us()))
+			- static_cast<qint64>(timeSync.server_send_us() - timeSync.server_receive_us()));
+	}
+	if (m_latencyTracer) {
+		m_latencyTracer->addTimeSync(timeSync, messageHandler.lastRelayTimeUs(), m_readUs);
+	}
+}
 
-	if (m_socket && m_socket->state() == QAbstractSocket::ConnectedState) {
-		m_socket->write(sendData);
-		m_socket->flush();
+void NetworkWorker::setViewport(const QSize& size, const QRectF& crop)
+{
+	m_viewportSize = size;
+	m_viewportCrop = crop;
+	if (m_capabilitiesSent) {
+		sendViewport();
 	}
 }
 
-void NetworkWorker::sendClipboardEventToServer(const ClipboardEvent& clipboardEvent)
+void NetworkWorker::setBackground(bool background)
 {
-	if (m_socket->state() != QAbstractSocket::ConnectedState) {
-		return;  // û RelayServerͲ
+	if (background == m_background) {
+		return;
+	}
+	m_background = background;
+	// 编码尺寸变化时服务端重建编码管线，下一帧即为新尺寸的关键帧
+	if (m_capabilitiesSent) {
+		sendViewport();
 	}
+}
 
-	// װ ClipboardEvent Ϣ RendezvousMessage 
+void NetworkWorker::sendViewport()
+{
+	QSize size = m_viewportSize;
+	if (m_background) {
+		// 后台会话按缩略图尺寸接收，窗口更小时按窗口尺寸
+		const QSize thumbnail(BACKGROUND_THUMBNAIL_W, BACKGROUND_THUMBNAIL_H);
+		if (size.isEmpty() || size.width() > thumbnail.width() || size.height() > thumbnail.height()) {
+			size = size.isEmpty() ? thumbnail : size.scaled(thumbnail, Qt::KeepAspectRatio);
+		}
+	}
+	if (size.isEmpty()) {
+		return;
+	}
 	RendezvousMessage msg;
-	*msg.mutable_clipboardevent() = clipboardEvent;
+	ViewportInfo* viewport = msg.mutable_viewport_info();
+	viewport->set_width(size.width());
+	viewport->set_height(size.height());
+	viewport->set_max_fps(m_background ? BACKGROUND_MAX_FPS : 0);
+	viewport->set_crop_x(static_cast<float>(m_viewportCrop.x()));
+	viewport->set_crop_y(static_cast<float>(m_viewportCrop.y()));
+	viewport->set_crop_width(static_cast<float>(m_viewportCrop.width()));
+	viewport->set_crop_height(static_cast<float>(m_viewportCrop.height()));
+	sendMessage(msg);
+}
+
+bool NetworkWorker::sendMessage(const RendezvousMessage& msg)
+{
+	if (!m_socket || m_socket->state() != QAbstractSocket::ConnectedState) {
+		return false;
+	}
 
 	std::string serialized;
 	if (!msg.SerializeToString(&serialized)) {
-		LogWidget::instance()->addLog("Failed to serialize ClipboardEvent message", LogWidget::Error);
-		return;
+		LogWidget::instance()->addLog("Failed to serialize RendezvousMessage", LogWidget::Error);
+		return false;
 	}
 
-	QByteArray protobufData(serialized.data(), serialized.size());
-
-	// 㳤ͷ
-	quint32 len = static_cast<quint32>(protobufData.size());
-	quint32 len_be = qToBigEndian(len); // ת
-
-	// 
+	quint32 len_be = qToBigEndian(static_cast<quint32>(serialized.size()));
 	QByteArray sendData;
+	sendData.reserve(sizeof(len_be) + static_cast<int>(serialized.size()));
 	sendData.append(reinterpret_cast<const char*>(&len_be), sizeof(len_be));
-	sendData.append(protobufData);
+	sendData.append(serialized.data(), static_cast<int>(serialized.size()));
 
-	LogWidget::instance()->addLog("sendClipboardEventToServer", LogWidget::Error);
-	if (m_socket && m_socket->state() == QAbstractSocket::ConnectedState) {
-		m_socket->write(sendData);
-		m_socket->flush();
-	}
+	m_socket->write(sendData);
+	m_socket->flush();
+	return true;
 }
 
-
-
 void NetworkWorker::onSocketError(QAbstractSocket::SocketError socketError)
 {
 	Q_UNUSED(socketError);
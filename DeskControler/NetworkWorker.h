@@ -4,7 +4,16 @@
 #include <QObject>
 #include <QtNetwork/QTcpSocket>
 #include <QByteArray>
+#include <QRectF>
+#include <QSize>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QElapsedTimer>
 #include "MessageHandler.h"
+#include "InputBatcher.h"
+#include "InputRateLimiter.h"
+
+class LatencyTracer;
 
 class NetworkWorker : public QObject
 {
@@ -13,31 +22,53 @@ public:
 	explicit NetworkWorker(QObject* parent = nullptr);
 	~NetworkWorker();
 
+	// 启动网络线程前设置，收到的视频帧和时钟同步回复交给 tracer 统计延迟
+	// 时钟同步不依赖 tracer，同步得到的往返时间也用于控制鼠标移动的发送节奏
+	void setLatencyTracer(const QSharedPointer<LatencyTracer>& tracer);
+
 public slots:
-	// ڹ߳ãӵָ
+	// 在工作线程里调用，连接到指定服务器并发送请求
 	void connectToServer(const QString& host, quint16 port, const QString& uuid);
 	void cleanup();
 	void sendMouseEventToServer(int x, int y, int mask);
 	void sendKeyEventToServer(int key, bool pressed);
 	void sendClipboardEventToServer(const ClipboardEvent& clipboardEvent);
+	void sendKeyframeRequestToServer(int reason);
+	// 记录显示区域，服务端已就绪时立即发送，否则在收到第一帧后发送
+	void setViewport(const QSize& size, const QRectF& crop);
+	// 后台会话只接收低帧率的缩略图，切回前台时恢复按显示区域接收
+	void setBackground(bool background);
 
 
 signals:
-	// һ֡ H264 ݺ󣬷źŸ߳
-	void packetReady(const QByteArray& packetData);
-	// Ͽźţ֪ͨ߳
+	// 当拆包出一帧 H264 数据后，发出信号给解码线程
+	void packetReady(const InpuVideoFrame& frame);
+	// 网络出错、断开等信号，可以通知主线程
 	void networkError(const QString& error);
 	void connectedToServer();
 	void onClipboardMessageReceived(const ClipboardEvent& clipboardEvent);
+	void cursorEventReceived(const CursorEvent& cursorEvent);
+	void cursorShapeReceived(const CursorShape& cursorShape);
 
 private slots:
 	void onSocketConnected();
 	void onSocketReadyRead();
 	void onSocketError(QAbstractSocket::SocketError socketError);
 	void onSocketDisconnected();
+	// 收到第一帧视频后上报本机可解码的格式
+	void sendCodecCapabilities();
+	// 延迟统计：记录视频包到达时刻，定期与被控端同步时钟
+	void traceVideoFrame(const InpuVideoFrame& frame);
+	void sendTimeSync();
+	void onTimeSyncReceived(const TimeSync& timeSync);
+	// 发送合并后的输入
+	void flushInput();
 
 private:
 	void sendRequestRelay();
+	// 序列化并加上 4 字节长度头后发送
+	bool sendMessage(const RendezvousMessage& msg);
+	void sendViewport();
 
 private:
 	QTcpSocket* m_socket = nullptr;
@@ -46,6 +77,18 @@ private:
 	QString m_host;
 	quint16 m_port;
 	MessageHandler messageHandler;
+	bool m_capabilitiesSent = false;
+	QSize m_viewportSize;
+	QRectF m_viewportCrop;
+	bool m_background = false;
+	QSharedPointer<LatencyTracer> m_latencyTracer;
+	QTimer* m_timeSyncTimer = nullptr;
+	InputBatcher m_inputBatcher;
+	InputRateLimiter m_inputRate;
+	QTimer* m_inputTimer = nullptr;
+	QElapsedTimer m_inputStatsTimer;
+	// 本次 readyRead 读到数据的时刻，作为其中各个包的到达时刻
+	qint64 m_readUs = 0;
 
 };
 
@@ -0,0 +1,187 @@
+#include "PlayoutBuffer.h"
+#include "DecoderOptions.h"
+#include "LogWidget.h"
+#include <algorithm>
+
+// 统计最小偏移和抖动的时间窗口
+#define JITTER_WINDOW_US 5000000
+// 目标延迟回落系数（每帧），约 50 帧的时间常数
+#define TARGET_DECAY 0.02
+// 采集时刻倒退超过该值认为服务端重新开始计时
+#define CAPTURE_CLOCK_RESET_US 1000000
+#define KEYFRAME_REQUEST_INTERVAL_MS 2000
+#define STATS_INTERVAL_MS 30000
+
+PlayoutBuffer::PlayoutBuffer(QObject* parent)
+	: QObject(parent)
+{
+	m_timer = new QTimer(this);
+	m_timer->setSingleShot(true);
+	m_timer->setTimerType(Qt::PreciseTimer);
+	connect(m_timer, &QTimer::timeout, this, &PlayoutBuffer::releaseDue);
+	m_clock.start();
+}
+
+void PlayoutBuffer::cleanup()
+{
+	m_timer->stop();
+	m_pending.clear();
+	resetTiming();
+}
+
+void PlayoutBuffer::resetTiming()
+{
+	m_samples.clear();
+	m_lastCaptureUs = 0;
+	m_baseOffsetUs = 0;
+	m_targetUs = 0;
+	m_jitterP95Us = 0;
+}
+
+void PlayoutBuffer::pushFrame(const InpuVideoFrame& frame)
+{
+	const DecoderOptions& options = DecoderOptions::global();
+	// 未启用或没有采集时刻（参数集、旧版本服务端）时直接解码
+	if (!options.playoutBuffer || frame.capture_time_us() == 0) {
+		emit packetReleased(frame, true);
+		return;
+	}
+
+	const qint64 arrivalUs = nowUs();
+	const qint64 captureUs = static_cast<qint64>(frame.capture_time_us());
+	if (captureUs != m_lastCaptureUs) {
+		if (captureUs < m_lastCaptureUs - CAPTURE_CLOCK_RESET_US) {
+			resetTiming();
+		}
+		m_lastCaptureUs = captureUs;
+		updateDelay(arrivalUs, arrivalUs - captureUs);
+	}
+
+	PendingPacket packet;
+	packet.frame = frame;
+	packet.playoutUs = captureUs + m_baseOffsetUs + m_targetUs;
+	m_pending.append(packet);
+	releaseDue();
+}
+
+void PlayoutBuffer::updateDelay(qint64 arrivalUs, qint64 offsetUs)
+{
+	m_samples.append(qMakePair(arrivalUs, offsetUs));
+	while (!m_samples.isEmpty() && m_samples.first().first < arrivalUs - JITTER_WINDOW_US) {
+		m_samples.removeFirst();
+	}
+
+	// 窗口内最小偏移视为无排队时的传输时间（同时吸收两端时钟的差值），超出部分为抖动
+	qint64 base = offsetUs;
+	for (const auto& sample : m_samples) {
+		base = qMin(base, sample.second);
+	}
+	QVector<qint64> jitter;
+	jitter.reserve(m_samples.size());
+	for (const auto& sample : m_samples) {
+		jitter.append(sample.second - base);
+	}
+	const int index = (jitter.size() - 1) * 95 / 100;
+	std::nth_element(jitter.begin(), jitter.begin() + index, jitter.end());
+	m_jitterP95Us = jitter[index];
+	m_baseOffsetUs = base;
+
+	const qint64 maxUs = static_cast<qint64>(DecoderOptions::global().maxPlayoutDelayMs) * 1000;
+	const qint64 wanted = qMin(m_jitterP95Us, maxUs);
+	if (wanted > m_targetUs) {
+		m_targetUs = wanted;
+	}
+	else {
+		m_targetUs -= static_cast<qint64>((m_targetUs - wanted) * TARGET_DECAY);
+	}
+	++m_frames;
+}
+
+void PlayoutBuffer::releaseDue()
+{
+	const qint64 now = nowUs();
+	int dueCount = 0;
+	while (dueCount < m_pending.size() && m_pending[dueCount].playoutUs <= now) {
+		++dueCount;
+	}
+	if (dueCount == 0) {
+		scheduleNext();
+		return;
+	}
+
+	const qint64 newestCaptureUs = static_cast<qint64>(m_pending[dueCount - 1].frame.capture_time_us());
+	const qint64 backlogUs = newestCaptureUs - static_cast<qint64>(m_pending[0].frame.capture_time_us());
+	const qint64 catchUpUs = static_cast<qint64>(DecoderOptions::global().catchUpMs) * 1000;
+	int first = 0;
+	if (backlogUs > catchUpUs) {
+		// 积压过多：到期的包中有关键帧时从最后一个关键帧开始解码，之前的帧不再需要
+		// 分块模式下各 tile 的关键帧互不相关，不跳帧
+		int keyIndex = -1;
+		for (int i = dueCount - 1; i > 0; --i) {
+			if (m_pending[i].frame.key_frame() && m_pending[i].frame.tile_count() <= 1) {
+				keyIndex = i;
+				break;
+			}
+		}
+		// 退到该关键帧的第一个 slice
+		while (keyIndex > 0 && m_pending[keyIndex - 1].frame.capture_time_us() == m_pending[keyIndex].frame.capture_time_us()) {
+			--keyIndex;
+		}
+		if (keyIndex > 0) {
+			int skipped = 0;
+			for (int i = 0; i < keyIndex; ++i) {
+				if (i == 0 || m_pending[i].frame.capture_time_us() != m_pending[i - 1].frame.capture_time_us()) {
+					++skipped;
+				}
+			}
+			m_skippedFrames += skipped;
+			first = keyIndex;
+			LogWidget::instance()->addLog(QString("[Playout] %1 ms behind, skipped %2 frames to keyframe")
+				.arg(backlogUs / 1000).arg(skipped), LogWidget::Info);
+		}
+		else if (!m_lastKeyframeRequest.isValid() || m_lastKeyframeRequest.elapsed() >= KEYFRAME_REQUEST_INTERVAL_MS) {
+			m_lastKeyframeRequest.start();
+			LogWidget::instance()->addLog(QString("[Playout] %1 ms behind without keyframe, requesting one")
+				.arg(backlogUs / 1000), LogWidget::Info);
+			emit keyframeNeeded(KeyframeRequest::CATCH_UP);
+		}
+	}
+
+	// 同时到期的多帧只显示最新的一帧，其余帧只解码以保持参考帧
+	const QList<PendingPacket> due = m_pending.mid(first, dueCount - first);
+	m_pending.remove(0, dueCount);
+	for (int i = 0; i < due.size(); ++i) {
+		const bool display = static_cast<qint64>(due[i].frame.capture_time_us()) == newestCaptureUs;
+		if (!display && (i == 0 || due[i].frame.capture_time_us() != due[i - 1].frame.capture_time_us())) {
+			++m_hiddenFrames;
+		}
+		emit packetReleased(due[i].frame, display);
+	}
+
+	if (!m_statsTimer.isValid()) {
+		m_statsTimer.start();
+	}
+	else if (m_statsTimer.elapsed() >= STATS_INTERVAL_MS) {
+		LogWidget::instance()->addLog(QString("[Playout] frames=%1 target=%2 ms jitter-p95=%3 ms hidden=%4 skipped=%5")
+			.arg(m_frames)
+			.arg(m_targetUs / 1000.0, 0, 'f', 1)
+			.arg(m_jitterP95Us / 1000.0, 0, 'f', 1)
+			.arg(m_hiddenFrames)
+			.arg(m_skippedFrames), LogWidget::Info);
+		m_frames = 0;
+		m_hiddenFrames = 0;
+		m_skippedFrames = 0;
+		m_statsTimer.restart();
+	}
+	scheduleNext();
+}
+
+void PlayoutBuffer::scheduleNext()
+{
+	if (m_pending.isEmpty()) {
+		m_timer->stop();
+		return;
+	}
+	const qint64 waitUs = m_pending.first().playoutUs - nowUs();
+	m_timer->start(static_cast<int>(qMax<qint64>(0, (waitUs + 999) / 1000)));
+}
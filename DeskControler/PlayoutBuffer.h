@@ -0,0 +1,65 @@
+#ifndef PLAYOUTBUFFER_H
+#define PLAYOUTBUFFER_H
+
+#include <QObject>
+#include <QList>
+#include <QPair>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "MessageHandler.h"
+
+// 自适应播放缓冲：按服务端的采集时刻安排每帧的解码时间，吸收网络抖动
+// 播放时刻 = 采集时刻 + 最小传输偏移 + 目标延迟，目标延迟取近期抖动的 95 分位，抖动变大时立即增大、变小时缓慢回落
+// 网络停顿后积压的多帧同时到期时只显示最新的一帧，其余帧只解码不显示；积压超过阈值时直接跳到缓冲中最后一个关键帧
+// 与解码器在同一线程
+class PlayoutBuffer : public QObject
+{
+	Q_OBJECT
+public:
+	explicit PlayoutBuffer(QObject* parent = nullptr);
+
+public slots:
+	void pushFrame(const InpuVideoFrame& frame);
+	void cleanup();
+
+signals:
+	// 到达播放时刻的包，display 为 false 时只解码不显示
+	void packetReleased(const InpuVideoFrame& frame, bool display);
+	// 积压过多且缓冲中没有关键帧
+	void keyframeNeeded(int reason);
+
+private slots:
+	void releaseDue();
+
+private:
+	qint64 nowUs() const { return m_clock.nsecsElapsed() / 1000; }
+	// 每帧更新一次最小传输偏移和目标延迟
+	void updateDelay(qint64 arrivalUs, qint64 offsetUs);
+	void resetTiming();
+	void scheduleNext();
+
+	struct PendingPacket
+	{
+		InpuVideoFrame frame;
+		qint64 playoutUs = 0;
+	};
+	QList<PendingPacket> m_pending;
+	QTimer* m_timer = nullptr;
+	QElapsedTimer m_clock;
+
+	// 最近一段时间内每帧的 (到达时刻, 到达时刻 - 采集时刻)
+	QList<QPair<qint64, qint64>> m_samples;
+	qint64 m_lastCaptureUs = 0;
+	qint64 m_baseOffsetUs = 0;
+	qint64 m_targetUs = 0;
+	qint64 m_jitterP95Us = 0;
+	QElapsedTimer m_lastKeyframeRequest;
+
+	// 统计
+	QElapsedTimer m_statsTimer;
+	int m_frames = 0;
+	int m_hiddenFrames = 0;
+	int m_skippedFrames = 0;
+};
+
+#endif // PLAYOUTBUFFER_H
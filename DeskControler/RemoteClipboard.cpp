@@ -57,24 +57,24 @@ void RemoteClipboard::onClipboardMessageReceived(const ClipboardEvent& clipboard
 	LogWidget::instance()->addLog("onClipboardMessageReceived", LogWidget::Error);
 	switch (clipboardEvent.event_case()) {
 	case ClipboardEvent::kText: {
-		// ı
+		// 处理文本数据
 		QString text = QString::fromStdString(clipboardEvent.text().text_data());
 		QApplication::clipboard()->setText(text);
 		LogWidget::instance()->addLog("RemoteClipboard: Updated clipboard with text data", LogWidget::Info);
 		break;
 	}
 	case ClipboardEvent::kFile: {
-		// ļ
+		// 处理文件数据
 		const FileContent& fileContent = clipboardEvent.file();
 		QString fileName = QString::fromStdString(fileContent.file_name());
-		// ļʱĿ¼
+		// 保存文件到临时目录
 		QString tempPath = QDir::tempPath() + "/" + fileName;
 		QFile file(tempPath);
 		if (file.open(QIODevice::WriteOnly)) {
 			file.write(QByteArray::fromStdString(fileContent.file_data()));
 			file.close();
 			LogWidget::instance()->addLog(QString("RemoteClipboard: File saved to %1").arg(tempPath), LogWidget::Info);
-			// ¼Ϊļ URLʹճԻȡļ
+			// 更新剪贴板为文件 URL，使得粘贴操作可以获取该文件
 			QMimeData* mimeData = new QMimeData;
 			QList<QUrl> urls;
 			urls.append(QUrl::fromLocalFile(tempPath));
@@ -104,22 +104,22 @@ LRESULT RemoteClipboard::handleKeyEvent(int nCode, WPARAM wParam, LPARAM lParam)
 {
 	if (nCode == HC_ACTION) {
 		KBDLLHOOKSTRUCT* pKeyboard = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
-		// ¼
+		// 仅处理按下事件
 		if (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN) {
 			bool ctrlPressed = (GetAsyncKeyState(VK_CONTROL) & 0x8000) != 0;
 			if (ctrlPressed && pKeyboard->vkCode == 'C') {
 				QWidget* activeWnd = QApplication::activeWindow();
 				if (m_remoteWindow && activeWnd == m_remoteWindow) {
-					// Զ棬򲻴 Ctrl+CԶ洦
+					// 如果激活窗口是远程桌面，则不处理 Ctrl+C，交由远程桌面处理
 					LogWidget::instance()->addLog("Remote window active, ignoring Ctrl+C on control side", LogWidget::Info);
 					return CallNextHookEx(s_hook, nCode, wParam, lParam);
 				}
-				// ȡݣ ClipboardEvent
+				// 读取剪贴板数据，并构造 ClipboardEvent
 				ClipboardEvent eventMsg;
 				QClipboard* clipboard = QApplication::clipboard();
 				const QMimeData* mimeData = clipboard->mimeData();
 				if (mimeData) {
-					// ļ URLȴļ
+					// 如果剪贴板包含文件 URL，则优先处理文件数据
 					if (mimeData->hasUrls() && !mimeData->urls().isEmpty()) {
 						QString filePath = mimeData->urls().first().toLocalFile();
 						QFile file(filePath);
@@ -136,7 +136,7 @@ LRESULT RemoteClipboard::handleKeyEvent(int nCode, WPARAM wParam, LPARAM lParam)
 							LogWidget::instance()->addLog(QString("RemoteClipboard: Failed to open file: %1").arg(filePath), LogWidget::Error);
 						}
 					}
-					// ı
+					// 否则处理文本数据
 					else if (mimeData->hasText()) {
 						TextContent* textContent = eventMsg.mutable_text();
 						textContent->set_text_data(mimeData->text().toStdString());
@@ -149,11 +149,11 @@ LRESULT RemoteClipboard::handleKeyEvent(int nCode, WPARAM wParam, LPARAM lParam)
 				else {
 					LogWidget::instance()->addLog("RemoteClipboard: Clipboard is empty", LogWidget::Warning);
 				}
-				// ʹ queued ʽźţȷ Qt ߳д
+				// 使用 queued 方式发射带参数的信号，确保在 Qt 主线程中处理
 				QMetaObject::invokeMethod(this, "ctrlCPressed", Qt::QueuedConnection,
 					Q_ARG(ClipboardEvent, eventMsg));
 				LogWidget::instance()->addLog("RemoteClipboard: Global Ctrl+C detected and clipboard data captured", LogWidget::Info);
-				// ѡش¼򷵻 CallNextHookEx 
+				// 可选择拦截此事件，或返回 CallNextHookEx 继续传递
 			}
 		}
 	}
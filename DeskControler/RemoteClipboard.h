@@ -22,7 +22,7 @@ signals:
 	void ctrlCPressed(const ClipboardEvent& clipboardEvent);
 
 public slots:
-	// Զ̴ ClipboardEvent Ϣϵͳ
+	// 接收远程传来的 ClipboardEvent 消息，并更新系统剪贴板数据
 	void onClipboardMessageReceived(const ClipboardEvent& clipboardEvent);
 
 private:
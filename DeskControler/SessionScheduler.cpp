@@ -0,0 +1,122 @@
+#include "SessionScheduler.h"
+#include "DecoderOptions.h"
+#include "LogWidget.h"
+#include <QCoreApplication>
+
+// 每次连续执行的任务数上限，之后重新排队
+#define STRAND_BATCH 8
+
+DecodeStrand::DecodeStrand(QThreadPool* pool)
+	: m_pool(pool)
+{
+}
+
+void DecodeStrand::post(std::function<void()> task)
+{
+	QMutexLocker locker(&m_mutex);
+	if (m_closed) {
+		return;
+	}
+	m_tasks.push_back(std::move(task));
+	if (!m_scheduled) {
+		m_scheduled = true;
+		QSharedPointer<DecodeStrand> self = sharedFromThis();
+		m_pool->start([self]() { self->runBatch(); }, m_priority);
+	}
+}
+
+void DecodeStrand::setPriority(int priority)
+{
+	QMutexLocker locker(&m_mutex);
+	// 已在排队的任务保持原优先级，下一次排队生效
+	m_priority = priority;
+}
+
+int DecodeStrand::pendingTasks()
+{
+	QMutexLocker locker(&m_mutex);
+	return static_cast<int>(m_tasks.size());
+}
+
+void DecodeStrand::runBatch()
+{
+	for (int i = 0; i < STRAND_BATCH; ++i) {
+		std::function<void()> task;
+		{
+			QMutexLocker locker(&m_mutex);
+			if (m_tasks.empty()) {
+				m_scheduled = false;
+				m_idle.wakeAll();
+				return;
+			}
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+		task();
+	}
+
+	QMutexLocker locker(&m_mutex);
+	if (m_tasks.empty()) {
+		m_scheduled = false;
+		m_idle.wakeAll();
+		return;
+	}
+	// 还有任务：重新排队，同优先级的其它会话先执行
+	QSharedPointer<DecodeStrand> self = sharedFromThis();
+	m_pool->start([self]() { self->runBatch(); }, m_priority);
+}
+
+void DecodeStrand::close()
+{
+	QMutexLocker locker(&m_mutex);
+	m_closed = true;
+	m_tasks.clear();
+	while (m_scheduled) {
+		m_idle.wait(&m_mutex);
+	}
+}
+
+void DecodeStrand::waitForIdle()
+{
+	QMutexLocker locker(&m_mutex);
+	while (m_scheduled) {
+		m_idle.wait(&m_mutex);
+	}
+}
+
+SessionScheduler* SessionScheduler::instance()
+{
+	// 随 QApplication 销毁，退出时停止共享线程
+	static SessionScheduler* scheduler = new SessionScheduler(QCoreApplication::instance());
+	return scheduler;
+}
+
+SessionScheduler::SessionScheduler(QObject* parent)
+	: QObject(parent)
+{
+	const int threads = DecoderOptions::global().decodePoolThreads > 0
+		? DecoderOptions::global().decodePoolThreads
+		: QThread::idealThreadCount();
+	m_decodePool.setMaxThreadCount(threads);
+	// 解码线程常驻，避免会话空闲后重新创建线程
+	m_decodePool.setExpiryTimeout(-1);
+
+	m_ioThread = new QThread(this);
+	m_ioThread->setObjectName("SessionIO");
+	m_ioThread->start();
+
+	LogWidget::instance()->addLog(QString("Session scheduler: shared I/O thread, %1 decode threads").arg(threads),
+		LogWidget::Info);
+}
+
+SessionScheduler::~SessionScheduler()
+{
+	m_decodePool.waitForDone();
+	m_ioThread->quit();
+	m_ioThread->wait();
+}
+
+QSharedPointer<DecodeStrand> SessionScheduler::createStrand()
+{
+	return QSharedPointer<DecodeStrand>::create(&m_decodePool);
+}
@@ -0,0 +1,73 @@
+#ifndef SESSIONSCHEDULER_H
+#define SESSIONSCHEDULER_H
+
+#include <QObject>
+#include <QThread>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QEnableSharedFromThis>
+#include <functional>
+#include <deque>
+
+// 一个会话的解码任务队列：任务按提交顺序在共享线程池中执行，同一时刻最多一个线程在执行，
+// 因此解码器状态不需要加锁。每次最多连续执行若干个任务后重新排队，让其它会话有机会执行
+class DecodeStrand : public QEnableSharedFromThis<DecodeStrand>
+{
+public:
+	explicit DecodeStrand(QThreadPool* pool);
+
+	// 任意线程调用：追加任务，关闭后提交的任务直接丢弃
+	void post(std::function<void()> task);
+	// 线程池排队优先级，数值大的先执行，前台会话使用较高的优先级
+	void setPriority(int priority);
+	// 丢弃尚未执行的任务并等待正在执行的任务结束，之后不再接受任务
+	void close();
+	// 等待已提交的任务全部执行完
+	void waitForIdle();
+
+	int pendingTasks();
+
+private:
+	void runBatch();
+
+	QThreadPool* m_pool;
+	QMutex m_mutex;
+	QWaitCondition m_idle;
+	std::deque<std::function<void()>> m_tasks;
+	// 已在线程池中排队或正在执行
+	bool m_scheduled = false;
+	bool m_closed = false;
+	int m_priority = 0;
+};
+
+// 所有会话共享的线程：网络收发和播放缓冲在同一个 I/O 线程（都是异步 socket 和定时器，不会阻塞），
+// 解码在线程数与 CPU 核数相同的线程池中按会话排队执行，空闲线程从共享队列中取下一个会话的任务
+// 只在主线程中创建和访问
+class SessionScheduler : public QObject
+{
+	Q_OBJECT
+public:
+	// 前台会话和后台会话在线程池中的优先级
+	enum Priority
+	{
+		BackgroundPriority = 0,
+		FocusedPriority = 10
+	};
+
+	static SessionScheduler* instance();
+
+	QThread* ioThread() const { return m_ioThread; }
+	// 为一个会话创建解码任务队列
+	QSharedPointer<DecodeStrand> createStrand();
+
+private:
+	explicit SessionScheduler(QObject* parent = nullptr);
+	~SessionScheduler();
+
+	QThread* m_ioThread = nullptr;
+	QThreadPool m_decodePool;
+};
+
+#endif // SESSIONSCHEDULER_H
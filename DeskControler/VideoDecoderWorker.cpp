@@ -1,54 +1,311 @@
 #include "VideoDecoderWorker.h"
+#include "NalUnitParser.h"
 #include "LogWidget.h"
+#include "DecoderOptions.h"
+#include <QPainter>
+#include <QThread>
+
+// 控制端发送关键帧请求的最小间隔，服务端另有限流
+#define KEYFRAME_REQUEST_MIN_INTERVAL_MS 300
+// 等待输出的帧最多保留数，超过帧线程延迟即可
+#define MAX_PENDING_FRAMES 32
+
+static AVCodecID toCodecId(VideoCodec videoCodec)
+{
+	switch (videoCodec) {
+	case VIDEO_CODEC_HEVC:
+		return AV_CODEC_ID_HEVC;
+	case VIDEO_CODEC_VP9:
+		return AV_CODEC_ID_VP9;
+	case VIDEO_CODEC_AV1:
+		return AV_CODEC_ID_AV1;
+	default:
+		return AV_CODEC_ID_H264;
+	}
+}
+
+// H264/HEVC 为 Annex B 码流，可按 NAL 检查参数集、按 slice 分块送入
+static bool isAnnexB(VideoCodec videoCodec)
+{
+	return videoCodec == VIDEO_CODEC_H264 || videoCodec == VIDEO_CODEC_HEVC;
+}
 
 VideoDecoderWorker::VideoDecoderWorker(QObject* parent)
-	: QObject(parent)
+	: QObject(parent),
+	m_stats(DecoderOptions::global().statsInterval)
+{
+	// FFmpeg 初始化，会话开始时服务端总是发送 H264
+	openDecoder(VIDEO_CODEC_H264);
+}
+
+VideoDecoderWorker::~VideoDecoderWorker()
+{
+	cleanup();
+}
+
+void VideoDecoderWorker::cleanup()
+{
+	qDeleteAll(m_tileDecoders);
+	m_tileDecoders.clear();
+	m_tileCount = 0;
+	m_tileCanvas = QImage();
+	if (swsCtx) {
+		sws_freeContext(swsCtx);
+		swsCtx = nullptr;
+	}
+	closeDecoder();
+}
+
+void VideoDecoderWorker::closeDecoder()
+{
+	m_pendingFrames.clear();
+	if (frame) {
+		av_frame_free(&frame);
+		frame = nullptr;
+	}
+	if (codecCtx) {
+		avcodec_free_context(&codecCtx);
+		codecCtx = nullptr;
+	}
+	codec = nullptr;
+}
+
+bool VideoDecoderWorker::openDecoder(VideoCodec videoCodec)
 {
-	// FFmpeg ʼ
-	codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+	closeDecoder();
+	m_codec = videoCodec;
+	// 新解码器没有参数集和参考帧，从下一个关键帧开始解码
+	m_hasSps = false;
+	m_hasPps = false;
+	m_hasParameterSets = false;
+	m_slicesReceived = 0;
+	m_pendingDecodeUs = 0;
+	m_stats.reset();
+
+	codec = avcodec_find_decoder(toCodecId(videoCodec));
 	if (!codec) {
-		LogWidget::instance()->addLog(QString("H264 decoder not found"), LogWidget::Error);
-		return;
+		LogWidget::instance()->addLog(QString("Decoder for codec %1 not found").arg(videoCodec), LogWidget::Error);
+		return false;
 	}
 	codecCtx = avcodec_alloc_context3(codec);
 	if (!codecCtx) {
 		LogWidget::instance()->addLog(QString("Could not allocate video codec context"), LogWidget::Error);
-		return;
+		return false;
+	}
+
+	const DecoderOptions& options = DecoderOptions::global();
+	m_frameThreads = false;
+	if (options.threadMode == "none") {
+		codecCtx->thread_count = 1;
+	}
+	else if (options.threadMode == "frame" && options.maxFrameDelay > 0 && !m_sliced) {
+		// 帧线程的输出延迟为线程数 - 1 帧，按允许的延迟帧数限制线程数
+		const int threads = options.threadCount > 0 ? options.threadCount : QThread::idealThreadCount();
+		codecCtx->thread_type = FF_THREAD_FRAME;
+		codecCtx->thread_count = qBound(1, threads, options.maxFrameDelay + 1);
+		m_frameThreads = codecCtx->thread_count > 1;
+	}
+	else {
+		codecCtx->thread_type = FF_THREAD_SLICE;
+		codecCtx->thread_count = options.threadCount;
+	}
+	// FFmpeg 在设置 LOW_DELAY 或 CHUNKS 时不启用帧线程，两者只用于非帧线程模式
+	if (!m_frameThreads) {
+		if (options.lowDelay) {
+			codecCtx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+		}
+		// 允许按 slice 分块送入，最后一个 slice 解码完成后立即输出整帧
+		if (isAnnexB(videoCodec)) {
+			codecCtx->flags2 |= AV_CODEC_FLAG2_CHUNKS;
+		}
+	}
+	if (options.fastDecode) {
+		codecCtx->flags2 |= AV_CODEC_FLAG2_FAST;
 	}
 	if (avcodec_open2(codecCtx, codec, nullptr) < 0) {
 		LogWidget::instance()->addLog(QString("Could not open codec"), LogWidget::Error);
-		return;
+		avcodec_free_context(&codecCtx);
+		return false;
 	}
 	frame = av_frame_alloc();
 	if (!frame) {
 		LogWidget::instance()->addLog(QString("Could not allocate video frame"), LogWidget::Error);
+		return false;
 	}
+	if (codecCtx->active_thread_type & FF_THREAD_FRAME) {
+		m_threadDesc = QString("frame-threads x%1").arg(codecCtx->thread_count);
+	}
+	else if (codecCtx->active_thread_type & FF_THREAD_SLICE) {
+		m_threadDesc = QString("slice-threads x%1").arg(codecCtx->thread_count);
+	}
+	else {
+		m_threadDesc = "single-thread";
+	}
+	if (codecCtx->flags & AV_CODEC_FLAG_LOW_DELAY) {
+		m_threadDesc += " low-delay";
+	}
+	if (codecCtx->flags2 & AV_CODEC_FLAG2_FAST) {
+		m_threadDesc += " fast";
+	}
+	LogWidget::instance()->addLog(QString("Video decoder opened: %1 (%2)").arg(codec->name, m_threadDesc), LogWidget::Info);
+	return true;
 }
 
-VideoDecoderWorker::~VideoDecoderWorker()
+QList<int> VideoDecoderWorker::availableCodecs()
 {
-	cleanup();
+	QList<int> codecs;
+	const VideoCodec candidates[] = { VIDEO_CODEC_H264, VIDEO_CODEC_HEVC, VIDEO_CODEC_VP9, VIDEO_CODEC_AV1 };
+	for (VideoCodec candidate : candidates) {
+		if (avcodec_find_decoder(toCodecId(candidate))) {
+			codecs.append(candidate);
+		}
+	}
+	return codecs;
 }
 
-void VideoDecoderWorker::cleanup()
+void VideoDecoderWorker::requestKeyframe(int reason)
 {
-	if (swsCtx) {
-		sws_freeContext(swsCtx);
-		swsCtx = nullptr;
+	if (m_lastKeyframeRequest.isValid() && m_lastKeyframeRequest.elapsed() < KEYFRAME_REQUEST_MIN_INTERVAL_MS) {
+		return;
 	}
-	if (frame) {
-		av_frame_free(&frame);
-		frame = nullptr;
+	m_lastKeyframeRequest.start();
+	emit keyframeNeeded(reason);
+}
+
+void VideoDecoderWorker::decodeVideoFrame(const InpuVideoFrame& videoFrame, bool display)
+{
+	m_display = display;
+	if (videoFrame.tile_count() > 1) {
+		decodeTile(videoFrame);
+		return;
 	}
-	if (codecCtx) {
-		avcodec_free_context(&codecCtx);
-		codecCtx = nullptr;
+	decodeFrameData(videoFrame);
+}
+
+void VideoDecoderWorker::decodeTile(const InpuVideoFrame& videoFrame)
+{
+	// 分块布局变化（服务端切换分块数或屏幕尺寸），旧的 tile 码流全部作废
+	if (videoFrame.tile_count() != m_tileCount) {
+		qDeleteAll(m_tileDecoders);
+		m_tileDecoders.clear();
+		m_tileCount = videoFrame.tile_count();
+	}
+
+	VideoDecoderWorker* tileDecoder = m_tileDecoders.value(videoFrame.tile_id());
+	if (!tileDecoder) {
+		// 解码在线程池中执行，不一定是本对象所在的线程：不设 parent（由 cleanup 释放），并且必须直连
+		tileDecoder = new VideoDecoderWorker();
+		connect(tileDecoder, &VideoDecoderWorker::frameDecoded, this, &VideoDecoderWorker::onTileDecoded, Qt::DirectConnection);
+		connect(tileDecoder, &VideoDecoderWorker::keyframeNeeded, this, &VideoDecoderWorker::requestKeyframe, Qt::DirectConnection);
+		m_tileDecoders.insert(videoFrame.tile_id(), tileDecoder);
+	}
+	tileDecoder->decodeFrameData(videoFrame);
+
+	// tile 解码器总是输出到拼合画面，只有拼合画面按 m_display 决定是否显示
+	if (videoFrame.last_tile() && !m_tileCanvas.isNull() && m_display) {
+		emit frameDecoded(m_tileCanvas, QRect(QPoint(0, 0), m_tileCanvas.size()), m_tileCanvas.size(), videoFrame.frame_id());
+	}
+}
+
+void VideoDecoderWorker::onTileDecoded(const QImage& image, const QRect& sourceRect, const QSize& screenSize)
+{
+	if (screenSize.isEmpty()) {
+		return;
 	}
+	if (m_tileCanvas.size() != screenSize) {
+		m_tileCanvas = QImage(screenSize, QImage::Format_RGBA8888);
+		m_tileCanvas.fill(Qt::black);
+	}
+	QPainter painter(&m_tileCanvas);
+	painter.setCompositionMode(QPainter::CompositionMode_Source);
+	painter.drawImage(sourceRect.topLeft(), image);
 }
 
-void VideoDecoderWorker::decodePacket(const QByteArray& packetData)
+void VideoDecoderWorker::decodeFrameData(const InpuVideoFrame& videoFrame)
 {
-	//  packetData  AVPacket
+	// 服务端完成编码格式协商后切换格式，按帧中的格式重新打开解码器
+	// 分片帧需要逐个 slice 送入（CHUNKS），与帧线程不兼容：收到分片帧时按 slice 线程重新打开，
+	// 服务端关闭分片后再按配置恢复帧线程
+	const bool sliced = videoFrame.slice_count() > 1;
+	bool reopen = (videoFrame.codec() != m_codec || !codecCtx);
+	if (sliced != m_sliced) {
+		m_sliced = sliced;
+		reopen = reopen || m_frameThreads || (!sliced && DecoderOptions::global().threadMode == "frame");
+	}
+	if (reopen) {
+		if (!openDecoder(videoFrame.codec())) {
+			return;
+		}
+	}
+
+	// 旧版本服务端不带区域时沿用上一次的值
+	if (videoFrame.source_width() > 0 && videoFrame.source_height() > 0) {
+		m_sourceRect = QRect(videoFrame.source_x(), videoFrame.source_y(), videoFrame.source_width(), videoFrame.source_height());
+		m_screenSize = QSize(videoFrame.screen_width(), videoFrame.screen_height());
+	}
+	m_frameId = videoFrame.frame_id();
+	PendingFrame& pending = m_pendingFrames[m_frameId];
+	pending.sourceRect = m_sourceRect;
+	pending.screenSize = m_screenSize;
+	pending.display = m_display;
+	// 解码失败的帧不会输出，只保留最近的若干帧
+	while (m_pendingFrames.size() > MAX_PENDING_FRAMES) {
+		m_pendingFrames.erase(m_pendingFrames.begin());
+	}
+
+	QByteArray data = QByteArray::fromStdString(videoFrame.data());
+	if (videoFrame.slice_count() <= 1) {
+		decodePacket(data, videoFrame.key_frame());
+		return;
+	}
+
+	// 新帧开始时检查上一帧是否收齐
+	if (videoFrame.slice_index() == 0 || videoFrame.frame_id() != m_sliceFrameId) {
+		if (m_slicesReceived > 0 && videoFrame.frame_id() != m_sliceFrameId) {
+			LogWidget::instance()->addLog(QString("Frame %1 incomplete, %2 slices received")
+				.arg(m_sliceFrameId).arg(m_slicesReceived), LogWidget::Warning);
+		}
+		m_sliceFrameId = videoFrame.frame_id();
+		m_slicesReceived = 0;
+	}
+	++m_slicesReceived;
+	if (m_slicesReceived >= static_cast<int>(videoFrame.slice_count())) {
+		m_slicesReceived = 0;
+	}
+
+	// 不等整帧到齐，逐个 slice 送入解码器，与后续 slice 的网络传输重叠
+	decodePacket(data, videoFrame.key_frame());
+}
+
+void VideoDecoderWorker::setYuvOutput(bool enabled)
+{
+	if (enabled != m_yuvOutput) {
+		m_yuvOutput = enabled;
+		LogWidget::instance()->addLog(QString("Video decoder output: %1").arg(enabled ? "YUV planes (GPU conversion)" : "RGBA (CPU conversion)"), LogWidget::Info);
+	}
+}
+
+void VideoDecoderWorker::reportStats(qint64 decodeUs, qint64 convertUs, const char* output)
+{
+	m_stats.addFrame(decodeUs, convertUs);
+	if (!m_stats.ready()) {
+		return;
+	}
+	const FrameBufferPool::Stats pool = m_bufferPool.takeStats();
+	LogWidget::instance()->addLog(m_stats.summary(QString("%1 %2x%3 %4 %5")
+		.arg(codec->name).arg(frame->width).arg(frame->height).arg(m_threadDesc, output))
+		+ QString(", buffers allocated=%1/%2 frames (%3 MB), in use=%4")
+		.arg(pool.allocated).arg(pool.acquired)
+		.arg(pool.allocatedBytes / (1024.0 * 1024.0), 0, 'f', 1)
+		.arg(pool.outstanding), LogWidget::Info);
+}
+
+void VideoDecoderWorker::decodePacket(const QByteArray& packetData, bool keyFrame)
+{
+	if (!codecCtx || !frame) {
+		return;
+	}
+	// 将 packetData 拷贝到 AVPacket
 	AVPacket* pkt = av_packet_alloc();
 	if (!pkt) {
 		LogWidget::instance()->addLog(QString("Could not allocate AVPacket"), LogWidget::Warning);
@@ -56,18 +313,48 @@ void VideoDecoderWorker::decodePacket(const QByteArray& packetData)
 	}
 	pkt->data = reinterpret_cast<uint8_t*>(const_cast<char*>(packetData.data()));
 	pkt->size = packetData.size();
+	// 帧序号作为 pts 随帧经过解码器，同一帧的各个 slice 相同
+	pkt->pts = m_frameId;
+
+	// 收到 SPS/PPS 之前的数据无法解码（中途加入或重连），丢弃并请求关键帧
+	// VP9/AV1 的序列头随关键帧发送，等到第一个关键帧
+	if (!m_hasParameterSets) {
+		if (isAnnexB(m_codec)) {
+			const bool hevc = (m_codec == VIDEO_CODEC_HEVC);
+			const QList<NalUnit> units = NalUnitParser::split(pkt->data, pkt->size, hevc);
+			for (const NalUnit& unit : units) {
+				if (unit.type == (hevc ? NalUnitParser::NalHevcSps : NalUnitParser::NalSps))
+					m_hasSps = true;
+				else if (unit.type == (hevc ? NalUnitParser::NalHevcPps : NalUnitParser::NalPps))
+					m_hasPps = true;
+			}
+			m_hasParameterSets = m_hasSps && m_hasPps;
+		}
+		else {
+			m_hasParameterSets = keyFrame;
+		}
+		if (!m_hasParameterSets) {
+			requestKeyframe(KeyframeRequest::MISSING_PARAMETER_SETS);
+			av_packet_free(&pkt);
+			return;
+		}
+	}
 
+	// 解码耗时：send_packet 与 receive_frame 之和，分片模式下累计同一帧各个 slice 的耗时
+	QElapsedTimer decodeTimer;
+	decodeTimer.start();
 	int ret = avcodec_send_packet(codecCtx, pkt);
 	if (ret < 0) {
 		char errbuf[AV_ERROR_MAX_STRING_SIZE];
 		av_strerror(ret, errbuf, sizeof(errbuf));
-		// ֡Ļ ߵĻᱨ ʱȥ־
+		// 不是完整帧的话 这边的会报错， 暂时先去掉日志
 		// LogWidget::instance()->addLog(QString("Error sending packet for decoding: %1").arg(errbuf), LogWidget::Warning);
+		requestKeyframe(KeyframeRequest::DECODE_ERROR);
 		av_packet_free(&pkt);
 		return;
 	}
 
-	// Խн֡
+	// 尝试接收所有解码出的帧
 	while (true) {
 		ret = avcodec_receive_frame(codecCtx, frame);
 		if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
@@ -75,39 +362,76 @@ void VideoDecoderWorker::decodePacket(const QByteArray& packetData)
 		}
 		else if (ret < 0) {
 			LogWidget::instance()->addLog(QString("Error during decoding"), LogWidget::Warning);
+			requestKeyframe(KeyframeRequest::DECODE_ERROR);
 			break;
 		}
-		// õ֡YUV420P
+		// 参考帧丢失等错误会以隐藏错误的方式输出，同样需要关键帧恢复
+		if (frame->decode_error_flags) {
+			requestKeyframe(KeyframeRequest::DECODE_ERROR);
+		}
+		// 得到解码帧（YUV420P）
+		const qint64 decodeUs = m_pendingDecodeUs + decodeTimer.nsecsElapsed() / 1000;
+		m_pendingDecodeUs = 0;
 
-		// ʼתģû
-		if (!swsCtx) {
-			swsCtx = sws_getContext(frame->width, frame->height, codecCtx->pix_fmt,
-				frame->width, frame->height, AV_PIX_FMT_RGBA,
-				SWS_BILINEAR, nullptr, nullptr, nullptr);
+		// 取回输出帧自己的区域和序号，更早送入但没有输出的帧一并丢弃
+		const quint32 frameId = (frame->pts != AV_NOPTS_VALUE) ? static_cast<quint32>(frame->pts) : m_frameId;
+		PendingFrame output;
+		output.sourceRect = m_sourceRect;
+		output.screenSize = m_screenSize;
+		output.display = m_display;
+		auto it = m_pendingFrames.find(frameId);
+		if (it != m_pendingFrames.end()) {
+			output = it.value();
+			m_pendingFrames.erase(m_pendingFrames.cbegin(), std::next(it));
 		}
-		// Ŀ껺С
-		int numBytes = av_image_get_buffer_size(AV_PIX_FMT_RGBA, frame->width, frame->height, 1);
-		QByteArray imgBuffer(numBytes, 0);
 
-		uint8_t* destData[4] = {
-			reinterpret_cast<uint8_t*>(imgBuffer.data()),
-			nullptr, nullptr, nullptr
-		};
-		int destLinesize[4] = { 4 * frame->width, 0, 0, 0 };
+		// 追赶积压时只解码不显示，省去颜色转换和显示
+		if (!output.display) {
+			reportStats(decodeUs, 0, "hidden");
+			decodeTimer.restart();
+			continue;
+		}
+
+		// 显示端可以直接绘制 YUV420P：只增加解码帧缓冲区的引用交给显示端，不做颜色转换
+		if (m_yuvOutput && (frame->format == AV_PIX_FMT_YUV420P || frame->format == AV_PIX_FMT_YUVJ420P)) {
+			AVFrame* ref = av_frame_clone(frame);
+			if (ref) {
+				emit yuvFrameDecoded(QSharedPointer<AVFrame>(ref, [](AVFrame* f) { av_frame_free(&f); }),
+					output.sourceRect, output.screenSize, frameId);
+				reportStats(decodeUs, 0, "yuv");
+				decodeTimer.restart();
+				continue;
+			}
+		}
+
+		QElapsedTimer convertTimer;
+		convertTimer.start();
+
+		// 初始化转换上下文，服务端切换分辨率后按新尺寸重建，尺寸不变时直接复用
+		swsCtx = sws_getCachedContext(swsCtx, frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+			frame->width, frame->height, AV_PIX_FMT_RGBA,
+			SWS_BILINEAR, nullptr, nullptr, nullptr);
+		if (!swsCtx) {
+			LogWidget::instance()->addLog("Could not initialize the conversion context", LogWidget::Warning);
+			continue;
+		}
+		// 从池中取缓冲区，sws_scale 直接写入，不再另外拷贝
+		// 图像交给显示端，显示端换到下一帧后缓冲区自动回到池中
+		QImage image = m_bufferPool.acquire(frame->width, frame->height, QImage::Format_RGBA8888);
+		uint8_t* destData[4] = { image.bits(), nullptr, nullptr, nullptr };
+		int destLinesize[4] = { static_cast<int>(image.bytesPerLine()), 0, 0, 0 };
 
-		// תΪ RGBA
+		// 转换为 RGBA
 		sws_scale(swsCtx, frame->data, frame->linesize, 0, frame->height,
 			destData, destLinesize);
 
-		//  QImage
-		QImage image(reinterpret_cast<const uchar*>(imgBuffer.constData()),
-			frame->width, frame->height, QImage::Format_RGBA8888);
-		// һݣֹݱ
-		QImage finalImage = image.copy();
+		// 发射信号，通知外部有帧已解码
+		emit frameDecoded(image, output.sourceRect, output.screenSize, frameId);
 
-		// źţ֪ͨⲿ֡ѽ
-		emit frameDecoded(finalImage);
+		reportStats(decodeUs, convertTimer.nsecsElapsed() / 1000, "rgba");
+		decodeTimer.restart();
 	}
+	m_pendingDecodeUs += decodeTimer.nsecsElapsed() / 1000;
 
 	av_packet_free(&pkt);
 }
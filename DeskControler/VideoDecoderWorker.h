@@ -4,8 +4,15 @@
 #include <QObject>
 #include <QByteArray>
 #include <QImage>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QSharedPointer>
+#include "MessageHandler.h"
+#include "DecoderStats.h"
+#include "FrameBufferPool.h"
 
-// FFmpeg ͷļ
+// FFmpeg 相关头文件
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavutil/imgutils.h>
@@ -20,17 +27,87 @@ public:
 	~VideoDecoderWorker();
 	void cleanup();
 
+	// 本机 FFmpeg 可用的解码格式（VideoCodec 枚举值），连接后上报给服务端协商编码格式
+	static QList<int> availableCodecs();
+
 public slots:
-	void decodePacket(const QByteArray& packetData);
+	// 接收一帧或一个 slice，分片模式下每个 slice 到达即送入解码器
+	// display 为 false 时只解码不输出（播放缓冲追赶积压时）
+	void decodeVideoFrame(const InpuVideoFrame& videoFrame, bool display = true);
+	// keyFrame 用于 VP9/AV1 的起始判断，H264/HEVC 按参数集判断
+	void decodePacket(const QByteArray& packetData, bool keyFrame = false);
+	// 显示端能否直接绘制 YUV420P，可以时 YUV420P 帧不再转换为 RGBA，改为发出 yuvFrameDecoded
+	void setYuvOutput(bool enabled);
 
 signals:
-	void frameDecoded(const QImage& image);
+	// sourceRect/screenSize 为该帧对应的被控端屏幕区域和屏幕尺寸，旧版本服务端为空
+	// frameId 为服务端帧序号，用于延迟统计
+	void frameDecoded(const QImage& image, const QRect& sourceRect, const QSize& screenSize, quint32 frameId);
+	// 开启 YUV 输出时代替 frameDecoded，帧引用解码器的缓冲区，只能以直连方式接收
+	void yuvFrameDecoded(const QSharedPointer<AVFrame>& frame, const QRect& sourceRect, const QSize& screenSize, quint32 frameId);
+	// 需要服务端立即发送关键帧，reason 取值见 KeyframeRequest::Reason
+	void keyframeNeeded(int reason);
+
+private slots:
+	// tile 解码完成，画到拼合画面上
+	void onTileDecoded(const QImage& image, const QRect& sourceRect, const QSize& screenSize);
+
+private:
+	void requestKeyframe(int reason);
+	// 累计解码统计，达到窗口时输出
+	void reportStats(qint64 decodeUs, qint64 convertUs, const char* output);
+	// 解码一路码流中的一帧，不区分是否分块
+	void decodeFrameData(const InpuVideoFrame& videoFrame);
+	// 分块模式：按 tile_id 交给各自的解码器，last_tile 到达时输出拼合画面
+	void decodeTile(const InpuVideoFrame& videoFrame);
+	// 按格式打开解码器，服务端切换编码格式或分片方式时重新打开，线程方式见 DecoderOptions
+	bool openDecoder(VideoCodec videoCodec);
+	void closeDecoder();
 
 private:
 	const AVCodec* codec = nullptr;
 	AVCodecContext* codecCtx = nullptr;
 	AVFrame* frame = nullptr;
 	SwsContext* swsCtx = nullptr;
+	VideoCodec m_codec = VIDEO_CODEC_H264;
+	// 服务端是否分片发送，分片时不能使用帧线程
+	bool m_sliced = false;
+	bool m_frameThreads = false;
+	// 解码器实际的线程方式，用于统计输出
+	QString m_threadDesc;
+	// 当前帧已送入解码器但尚未输出的 slice 累计解码耗时
+	qint64 m_pendingDecodeUs = 0;
+	DecoderStats m_stats;
+	// 输出图像的缓冲区，显示端释放后复用
+	FrameBufferPool m_bufferPool;
+	bool m_yuvOutput = false;
+	// 当前送入的帧解码后是否输出
+	bool m_display = true;
+	// 最近送入解码器的帧对应的屏幕区域
+	QRect m_sourceRect;
+	QSize m_screenSize;
+	quint32 m_frameId = 0;
+	// 已送入解码器、尚未输出的帧，按帧序号（即送入的 pts）索引
+	// 帧线程下输出滞后若干帧，输出帧的区域、序号和是否显示按 frame->pts 取回，不能用最近送入的值
+	struct PendingFrame
+	{
+		QRect sourceRect;
+		QSize screenSize;
+		bool display = true;
+	};
+	QMap<quint32, PendingFrame> m_pendingFrames;
+	// 分片模式下当前正在接收的帧
+	quint32 m_sliceFrameId = 0;
+	int m_slicesReceived = 0;
+	// 是否已收到 SPS/PPS（VP9/AV1 为第一个关键帧），之前的数据直接丢弃
+	bool m_hasSps = false;
+	bool m_hasPps = false;
+	bool m_hasParameterSets = false;
+	QElapsedTimer m_lastKeyframeRequest;
+	// 分块模式下每个 tile 一个解码器，在本对象的解码任务中同步调用
+	QHash<quint32, VideoDecoderWorker*> m_tileDecoders;
+	quint32 m_tileCount = 0;
+	QImage m_tileCanvas;
 };
 
 #endif // VIDEODECODERWORKER_H
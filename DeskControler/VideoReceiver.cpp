@@ -1,67 +1,117 @@
 #include "VideoReceiver.h"
 #include "NetworkWorker.h"
 #include "VideoDecoderWorker.h"
+#include "PlayoutBuffer.h"
+#include "SessionScheduler.h"
 #include "LogWidget.h"
 
+// 丢帧统计的输出间隔
+#define DROP_STATS_INTERVAL_MS 10000
+
 VideoReceiver::VideoReceiver(QObject* parent)
-    : QObject(parent)
+    : QObject(parent),
+    m_stopped(true),
+    m_frameMailbox(new FrameMailbox),
+    m_latencyTracer(new LatencyTracer)
 {
-    // 1) 创建线程
-    m_networkThread = new QThread(this);
-    m_decodeThread = new QThread(this);
+    SessionScheduler* scheduler = SessionScheduler::instance();
 
-    // 2) 创建两个 Worker，但不指定 parent（后面 moveToThread）
+    // 1) 创建 Worker，但不指定 parent（后面 moveToThread）
     m_netWorker = new NetworkWorker();        // 负责 TCP 网络收包
-    m_decoderWorker = new VideoDecoderWorker();  // 负责解码
-
-    // 3) 移动到各自的线程
-    m_netWorker->moveToThread(m_networkThread);
-    m_decoderWorker->moveToThread(m_decodeThread);
+    m_decoderWorker = new VideoDecoderWorker();  // 负责解码，只在解码任务队列中调用
+    m_playoutBuffer = new PlayoutBuffer();       // 按采集时刻安排解码
+    m_decodeStrand = scheduler->createStrand();
 
-    // 4) 线程结束时自动清理 Worker
-    connect(m_networkThread, &QThread::finished, m_netWorker, &QObject::deleteLater);
-    connect(m_decodeThread, &QThread::finished, m_decoderWorker, &QObject::deleteLater);
+    // 2) 网络和播放缓冲移动到共享 I/O 线程，解码器不移动，所有调用都经过解码任务队列
+    m_netWorker->moveToThread(scheduler->ioThread());
+    m_playoutBuffer->moveToThread(scheduler->ioThread());
+    m_netWorker->setLatencyTracer(m_latencyTracer);
 
-    // 5) 信号槽连接
-    // 当网络线程拆完一包数据，就发给解码线程
+    // 3) 信号槽连接
+    // 网络拆完一包数据后交给播放缓冲（同一线程），到达播放时刻后提交解码
     connect(m_netWorker, &NetworkWorker::packetReady,
-        m_decoderWorker, &VideoDecoderWorker::decodePacket,
+        m_playoutBuffer, &PlayoutBuffer::pushFrame,
+        Qt::QueuedConnection);
+    // 先记录出缓冲时刻，再把包放进本会话的解码队列，同一会话的包按顺序解码
+    QSharedPointer<LatencyTracer> tracer = m_latencyTracer;
+    QSharedPointer<DecodeStrand> strand = m_decodeStrand;
+    VideoDecoderWorker* decoder = m_decoderWorker;
+    connect(m_playoutBuffer, &PlayoutBuffer::packetReleased, this,
+        [tracer, strand, decoder](const InpuVideoFrame& frame, bool display) {
+            tracer->frameReleased(frame.frame_id());
+            strand->post([decoder, frame, display]() {
+                decoder->decodeVideoFrame(frame, display);
+            });
+        },
+        Qt::DirectConnection);
+    connect(m_playoutBuffer, &PlayoutBuffer::keyframeNeeded,
+        m_netWorker, &NetworkWorker::sendKeyframeRequestToServer,
         Qt::QueuedConnection);
 
 	connect(m_netWorker, &NetworkWorker::onClipboardMessageReceived,
         this, &VideoReceiver::onClipboardMessageReceived,
 		Qt::QueuedConnection);
 
-    // 解码完成后回到主线程
-    connect(m_decoderWorker, &VideoDecoderWorker::frameDecoded,
-        this, &VideoReceiver::onFrameDecoded,
+    connect(m_netWorker, &NetworkWorker::cursorEventReceived,
+        this, &VideoReceiver::cursorEventReceived,
+        Qt::QueuedConnection);
+    connect(m_netWorker, &NetworkWorker::cursorShapeReceived,
+        this, &VideoReceiver::cursorShapeReceived,
+        Qt::QueuedConnection);
+
+    // 解码出错或缺少参数集时，由网络线程向服务端请求关键帧
+    connect(m_decoderWorker, &VideoDecoderWorker::keyframeNeeded,
+        m_netWorker, &NetworkWorker::sendKeyframeRequestToServer,
         Qt::QueuedConnection);
 
+    // 解码完成后在线程池中直接写入邮箱，图像不经过事件队列
+    // 只有显示端已取走上一帧时才通知主线程，界面繁忙时旧帧被覆盖而不是排队
+    QSharedPointer<FrameMailbox> mailbox = m_frameMailbox;
+    connect(m_decoderWorker, &VideoDecoderWorker::frameDecoded, this,
+        [this, mailbox, tracer](const QImage& img, const QRect& sourceRect, const QSize& screenSize, quint32 frameId) {
+            tracer->frameDecoded(frameId);
+            if (mailbox->publish(img, sourceRect, screenSize, frameId)) {
+                QMetaObject::invokeMethod(this, "onFrameAvailable", Qt::QueuedConnection);
+            }
+        },
+        Qt::DirectConnection);
+    connect(m_decoderWorker, &VideoDecoderWorker::yuvFrameDecoded, this,
+        [this, mailbox, tracer](const QSharedPointer<AVFrame>& frame, const QRect& sourceRect, const QSize& screenSize, quint32 frameId) {
+            tracer->frameDecoded(frameId);
+            if (mailbox->publish(frame, sourceRect, screenSize, frameId)) {
+                QMetaObject::invokeMethod(this, "onFrameAvailable", Qt::QueuedConnection);
+            }
+        },
+        Qt::DirectConnection);
+
     // 网络出错 -> 通知本类
     connect(m_netWorker, &NetworkWorker::networkError,
         this, &VideoReceiver::onNetworkError,
         Qt::QueuedConnection);
-
-    // 启动线程，让它们的事件循环开始工作
-    m_networkThread->start();
-    m_decodeThread->start();
 }
 
 VideoReceiver::~VideoReceiver()
 {
     stopReceiving();
+    // I/O 线程由其它会话共用，不能等线程结束，交给 I/O 线程释放
+    m_netWorker->deleteLater();
+    m_playoutBuffer->deleteLater();
+    // 关闭后提交的解码任务直接丢弃，等待正在执行的任务结束后释放解码器
+    m_decodeStrand->close();
+    delete m_decoderWorker;
+    m_decoderWorker = nullptr;
 }
 
 void VideoReceiver::stopReceiving()
 {
 	if (m_stopped)
 		return;
-	QMetaObject::invokeMethod(m_netWorker, "cleanup", Qt::QueuedConnection);
-	QMetaObject::invokeMethod(m_decoderWorker, "cleanup", Qt::QueuedConnection);
-	m_networkThread->quit();
-	m_decodeThread->quit();
-	m_networkThread->wait();
-	m_decodeThread->wait();
+	// 阻塞到网络和播放缓冲清理完成，之后不会再提交解码任务
+	QMetaObject::invokeMethod(m_netWorker, "cleanup", Qt::BlockingQueuedConnection);
+	QMetaObject::invokeMethod(m_playoutBuffer, "cleanup", Qt::BlockingQueuedConnection);
+	VideoDecoderWorker* decoder = m_decoderWorker;
+	m_decodeStrand->post([decoder]() { decoder->cleanup(); });
+	m_decodeStrand->waitForIdle();
     m_stopped = true;
 }
 
@@ -76,11 +126,55 @@ void VideoReceiver::startConnect(const QString& host, quint16 port, const QStrin
         Q_ARG(quint16, port),
         Q_ARG(QString, uuid));
     m_stopped = false;
+    m_latencyTracer->reset();
+    m_waitingFirstFrame = true;
+    m_connectTimer.start();
+}
+
+void VideoReceiver::onFrameAvailable()
+{
+    if (m_waitingFirstFrame)
+    {
+        m_waitingFirstFrame = false;
+        LogWidget::instance()->addLog(
+            QString("VideoReceiver: Time to first frame %1 ms").arg(m_connectTimer.elapsed()),
+            LogWidget::Info);
+        m_dropStatsTimer.start();
+    }
+    else if (m_dropStatsTimer.elapsed() >= DROP_STATS_INTERVAL_MS)
+    {
+        const quint64 published = m_frameMailbox->publishedFrames();
+        const quint64 dropped = m_frameMailbox->droppedFrames();
+        if (dropped > m_lastDropped)
+        {
+            LogWidget::instance()->addLog(
+                QString("[Frame-Mailbox] decoded=%1 dropped=%2 in last %3 s (total dropped %4)")
+                    .arg(published - m_lastPublished)
+                    .arg(dropped - m_lastDropped)
+                    .arg(m_dropStatsTimer.elapsed() / 1000)
+                    .arg(dropped),
+                LogWidget::Info);
+        }
+        m_lastPublished = published;
+        m_lastDropped = dropped;
+        m_dropStatsTimer.restart();
+    }
+    emit frameAvailable();
 }
 
-void VideoReceiver::onFrameDecoded(const QImage& img)
+void VideoReceiver::setYuvOutput(bool enabled)
 {
-    emit frameReady(img);
+    VideoDecoderWorker* decoder = m_decoderWorker;
+    m_decodeStrand->post([decoder, enabled]() { decoder->setYuvOutput(enabled); });
+}
+
+void VideoReceiver::setFocused(bool focused)
+{
+    m_decodeStrand->setPriority(focused ? SessionScheduler::FocusedPriority : SessionScheduler::BackgroundPriority);
+    QMetaObject::invokeMethod(m_netWorker,
+        "setBackground",
+        Qt::QueuedConnection,
+        Q_ARG(bool, !focused));
 }
 
 void VideoReceiver::onNetworkError(const QString& err)
@@ -108,6 +202,15 @@ void VideoReceiver::keyEventCaptured(int key, bool pressed)
 		Q_ARG(bool, pressed));
 }
 
+void VideoReceiver::viewportChanged(const QSize& size, const QRectF& crop)
+{
+	QMetaObject::invokeMethod(m_netWorker,
+		"setViewport",
+		Qt::QueuedConnection,
+		Q_ARG(QSize, size),
+		Q_ARG(QRectF, crop));
+}
+
 void VideoReceiver::clipboardDataCaptured(const ClipboardEvent& clipboardEvent)
 {
 	QMetaObject::invokeMethod(m_netWorker,
@@ -4,10 +4,16 @@
 #include <QObject>
 #include <QThread>
 #include <QImage>
+#include <QElapsedTimer>
+#include <QSharedPointer>
 #include "rendezvous.pb.h"
+#include "FrameMailbox.h"
+#include "LatencyTracer.h"
 
 class NetworkWorker;
 class VideoDecoderWorker;
+class PlayoutBuffer;
+class DecodeStrand;
 
 
 class VideoReceiver : public QObject
@@ -20,31 +26,58 @@ public:
 	// 主线程调用，用于发起连接
 	void startConnect(const QString& host, quint16 port, const QString& uuid);
 	void stopReceiving();
+	// 显示端支持 YUV 绘制时由解码线程直接输出 YUV 平面
+	void setYuvOutput(bool enabled);
+	// 前台会话优先解码并按显示区域接收，后台会话只接收低帧率缩略图
+	void setFocused(bool focused);
+
+	// 解码线程写入、显示端读取的最新帧
+	QSharedPointer<FrameMailbox> frameMailbox() const { return m_frameMailbox; }
+	// 解码后未显示即被新帧覆盖的帧数
+	quint64 droppedFrames() const { return m_frameMailbox->droppedFrames(); }
+	// 逐段延迟统计，显示端在绘制后记录显示时刻
+	QSharedPointer<LatencyTracer> latencyTracer() const { return m_latencyTracer; }
 
 signals:
-	// 当成功解码一帧时，把图像发给外层（比如给 VideoWidget 显示）
-	void frameReady(const QImage& image);
+	// 邮箱中有新帧，显示端应重绘并从 frameMailbox() 取帧
+	// 显示端取走之前到达的后续帧不再通知，只覆盖邮箱中的帧
+	void frameAvailable();
 	// 可以把 NetworkWorker 的错误转发出去
 	void networkError(const QString& error);
 	void onClipboardMessageReceived(const ClipboardEvent& clipboardEvent);
+	// 指针位置和形状直接从网络线程转发，不经过解码线程
+	void cursorEventReceived(const CursorEvent& cursorEvent);
+	void cursorShapeReceived(const CursorShape& cursorShape);
 
 public slots:
 	void mouseEventCaptured(int x, int y, int mask);
 	void keyEventCaptured(int key, bool pressed);
 	void clipboardDataCaptured(const ClipboardEvent& clipboardEvent);
+	// 显示区域或缩放变化，转发给服务端按显示尺寸编码
+	void viewportChanged(const QSize& size, const QRectF& crop);
 
 private slots:
-	// 当解码线程发出 frameDecoded 时调用
-	void onFrameDecoded(const QImage& img);
+	// 解码线程写入邮箱后通知，在主线程执行
+	void onFrameAvailable();
 	// 当 NetworkWorker 报错时
 	void onNetworkError(const QString& err);
 
 private:
-	QThread* m_networkThread = nullptr;
-	QThread* m_decodeThread = nullptr;
+	// 网络收发和播放缓冲在所有会话共享的 I/O 线程，解码器只通过 m_decodeStrand 在共享线程池中调用
 	NetworkWorker* m_netWorker = nullptr;
 	VideoDecoderWorker* m_decoderWorker = nullptr;
+	PlayoutBuffer* m_playoutBuffer = nullptr;
+	QSharedPointer<DecodeStrand> m_decodeStrand;
 	bool m_stopped;
+	// 从发起连接到显示第一帧的耗时
+	QElapsedTimer m_connectTimer;
+	bool m_waitingFirstFrame = false;
+	QSharedPointer<FrameMailbox> m_frameMailbox;
+	QSharedPointer<LatencyTracer> m_latencyTracer;
+	// 丢帧统计的输出窗口
+	QElapsedTimer m_dropStatsTimer;
+	quint64 m_lastPublished = 0;
+	quint64 m_lastDropped = 0;
 };
 
 #endif // VIDEORECEIVER_H
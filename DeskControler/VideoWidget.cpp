@@ -2,6 +2,65 @@
 #include <QPainter>
 #include <QKeyEvent>
 #include "LogWidget.h"
+#include "DecoderOptions.h"
+#include <QtMath>
+#include <QOpenGLContext>
+#include <QGenericMatrix>
+#include <QVector3D>
+#include <QDateTime>
+#include <QDir>
+#include <QPixmap>
+#include <QCursor>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+// 服务端输入坐标的参考尺寸（被控端按 FIXED_W x FIXED_H 换算到实际屏幕）
+#define REMOTE_INPUT_W 1920
+#define REMOTE_INPUT_H 1080
+#define MAX_ZOOM 8.0
+// 窗口拖动时合并显示区域变化，避免服务端频繁切换编码尺寸
+#define VIEWPORT_UPDATE_DELAY_MS 200
+// 延迟叠加层的统计刷新间隔
+#define LATENCY_REFRESH_MS 500
+// 核对被控端指针位置时保留的本地位置时长和数量
+#define LOCAL_POSITION_HISTORY_MS 1000
+#define LOCAL_POSITION_HISTORY_MAX 256
+// 被控端上报位置与本地位置相差在该范围内（被控端屏幕像素，另加输入坐标取整误差）视为一致
+#define CURSOR_MATCH_TOLERANCE 3.0
+
+// 只用 GLSL 1.00 / GL 2.0 的特性（attribute/varying、LUMINANCE 纹理），
+// 桌面 GL 兼容模式、OpenGL ES 2 和 Mesa llvmpipe 软件渲染都可以运行
+static const char* YUV_VERTEX_SHADER =
+	"attribute vec2 position;\n"
+	"attribute vec2 texCoord;\n"
+	"varying vec2 v_texCoord;\n"
+	"void main() {\n"
+	"    v_texCoord = texCoord;\n"
+	"    gl_Position = vec4(position, 0.0, 1.0);\n"
+	"}\n";
+
+static const char* YUV_FRAGMENT_SHADER =
+	"#ifdef GL_ES\n"
+	"precision mediump float;\n"
+	"#endif\n"
+	"varying vec2 v_texCoord;\n"
+	"uniform sampler2D texY;\n"
+	"uniform sampler2D texU;\n"
+	"uniform sampler2D texV;\n"
+	// 纹理按行宽（含对齐填充）上传，有效宽度占比
+	"uniform float scaleY;\n"
+	"uniform float scaleUV;\n"
+	"uniform vec3 offset;\n"
+	"uniform mat3 yuvToRgb;\n"
+	"void main() {\n"
+	"    vec3 yuv = vec3(texture2D(texY, vec2(v_texCoord.x * scaleY, v_texCoord.y)).r,\n"
+	"                    texture2D(texU, vec2(v_texCoord.x * scaleUV, v_texCoord.y)).r,\n"
+	"                    texture2D(texV, vec2(v_texCoord.x * scaleUV, v_texCoord.y)).r);\n"
+	"    gl_FragColor = vec4(clamp(yuvToRgb * (yuv - offset), 0.0, 1.0), 1.0);\n"
+	"}\n";
 
 VideoWidget::VideoWidget(QWidget* parent)
 	: QOpenGLWidget(parent)
@@ -9,32 +68,541 @@ VideoWidget::VideoWidget(QWidget* parent)
 	setWindowFlags(Qt::Window);
 	setFocusPolicy(Qt::StrongFocus);
 	setMouseTracking(true);
+
+	m_viewportTimer = new QTimer(this);
+	m_viewportTimer->setSingleShot(true);
+	m_viewportTimer->setInterval(VIEWPORT_UPDATE_DELAY_MS);
+	connect(m_viewportTimer, &QTimer::timeout, this, [this]() {
+		emit viewportChanged((QSizeF(size()) * devicePixelRatioF()).toSize(), m_crop);
+		});
+
+	// 画面静止时没有新帧触发重绘，叠加层按间隔自行刷新
+	m_latencyTimer = new QTimer(this);
+	m_latencyTimer->setInterval(LATENCY_REFRESH_MS);
+	connect(m_latencyTimer, &QTimer::timeout, this, QOverload<>::of(&VideoWidget::update));
+}
+
+VideoWidget::~VideoWidget()
+{
+	cleanupGL();
+}
+
+void VideoWidget::setFrameMailbox(const QSharedPointer<FrameMailbox>& mailbox)
+{
+	m_frameMailbox = mailbox;
+	update();
+}
+
+void VideoWidget::setLatencyTracer(const QSharedPointer<LatencyTracer>& tracer)
+{
+	m_latencyTracer = tracer;
 }
 
-void VideoWidget::setFrame(const QImage& image)
+QRectF VideoWidget::displayRect() const
 {
-	currentFrame = image;
+	if (m_frameSize.isEmpty()) {
+		return QRectF(rect());
+	}
+	// 保持宽高比适应窗口，居中显示
+	QSizeF fitted = QSizeF(m_frameSize).scaled(QSizeF(size()), Qt::KeepAspectRatio);
+	return QRectF(QPointF((width() - fitted.width()) / 2.0, (height() - fitted.height()) / 2.0), fitted);
+}
 
-	// 首帧时设置固定尺寸（用于滚动区域）
-	if (m_firstFrame && !currentFrame.isNull()) {
-		setMinimumSize(currentFrame.size());
-		resize(currentFrame.size());
-		m_firstFrame = false;
+bool VideoWidget::mapToRemoteScreen(const QPointF& pos, QPointF& screenPos) const
+{
+	const QRectF display = displayRect();
+	if (display.isEmpty() || m_sourceRect.isEmpty() || m_screenSize.isEmpty()) {
+		return false;
+	}
+	const qreal u = qBound(0.0, (pos.x() - display.x()) / display.width(), 1.0);
+	const qreal v = qBound(0.0, (pos.y() - display.y()) / display.height(), 1.0);
+	screenPos = QPointF(m_sourceRect.x() + u * m_sourceRect.width(), m_sourceRect.y() + v * m_sourceRect.height());
+	return true;
+}
 
+QPoint VideoWidget::mapToRemote(const QPointF& pos) const
+{
+	const QRectF display = displayRect();
+	if (display.isEmpty()) {
+		return pos.toPoint();
+	}
+	// 在画面中的归一化位置
+	const qreal u = qBound(0.0, (pos.x() - display.x()) / display.width(), 1.0);
+	const qreal v = qBound(0.0, (pos.y() - display.y()) / display.height(), 1.0);
+	if (m_sourceRect.isEmpty() || m_screenSize.isEmpty()) {
+		// 服务端未上报画面区域时按画面像素坐标
+		return QPoint(qRound(u * m_frameSize.width()), qRound(v * m_frameSize.height()));
 	}
+	// 画面 -> 被控端屏幕像素 -> 输入参考坐标
+	const QSize reference = m_screenSize.width() >= m_screenSize.height()
+		? QSize(REMOTE_INPUT_W, REMOTE_INPUT_H) : QSize(REMOTE_INPUT_H, REMOTE_INPUT_W);
+	const qreal screenX = m_sourceRect.x() + u * m_sourceRect.width();
+	const qreal screenY = m_sourceRect.y() + v * m_sourceRect.height();
+	return QPoint(qRound(screenX * reference.width() / m_screenSize.width()),
+		qRound(screenY * reference.height() / m_screenSize.height()));
+}
+
+void VideoWidget::scheduleViewportUpdate()
+{
+	m_viewportTimer->start();
+}
+
+void VideoWidget::resizeEvent(QResizeEvent* event)
+{
+	QOpenGLWidget::resizeEvent(event);
+	scheduleViewportUpdate();
+}
+
+void VideoWidget::enterEvent(QEnterEvent* event)
+{
+	QOpenGLWidget::enterEvent(event);
+	m_pointerInside = displayRect().contains(event->position());
+	updateLocalCursor();
+	update();
+}
 
+void VideoWidget::leaveEvent(QEvent* event)
+{
+	QOpenGLWidget::leaveEvent(event);
+	// 指针离开窗口后恢复在画面中绘制被控端指针
+	m_pointerInside = false;
+	updateLocalCursor();
 	update();
 }
 
-void VideoWidget::paintEvent(QPaintEvent* event)
+void VideoWidget::wheelEvent(QWheelEvent* event)
+{
+	if (!(event->modifiers() & Qt::ControlModifier)) {
+		QOpenGLWidget::wheelEvent(event);
+		return;
+	}
+	event->accept();
+	const QRectF display = displayRect();
+	if (display.isEmpty()) {
+		return;
+	}
+	const qreal zoom = qBound(1.0, m_zoom * qPow(1.25, event->angleDelta().y() / 120.0), MAX_ZOOM);
+	if (qFuzzyCompare(zoom, m_zoom)) {
+		return;
+	}
+
+	// 保持鼠标下的屏幕位置不动
+	const QPointF pos = event->position();
+	const qreal u = qBound(0.0, (pos.x() - display.x()) / display.width(), 1.0);
+	const qreal v = qBound(0.0, (pos.y() - display.y()) / display.height(), 1.0);
+	const QPointF anchor(m_crop.x() + u * m_crop.width(), m_crop.y() + v * m_crop.height());
+	const qreal side = 1.0 / zoom;
+	m_crop = QRectF(qBound(0.0, anchor.x() - u * side, 1.0 - side),
+		qBound(0.0, anchor.y() - v * side, 1.0 - side), side, side);
+	m_zoom = zoom;
+	scheduleViewportUpdate();
+}
+
+void VideoWidget::initializeGL()
+{
+	initializeOpenGLFunctions();
+	// 窗口移到其他顶层窗口等情况下上下文会重建，旧上下文销毁前释放纹理
+	connect(context(), &QOpenGLContext::aboutToBeDestroyed, this, &VideoWidget::cleanupGL, Qt::UniqueConnection);
+
+	const bool ready = DecoderOptions::global().gpuConversion && initYuvRenderer();
+	LogWidget::instance()->addLog(QString("VideoWidget: OpenGL %1 (%2), YUV shader %3")
+		.arg(reinterpret_cast<const char*>(glGetString(GL_VERSION)),
+			reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+			ready ? "enabled" : "disabled, using RGBA"), LogWidget::Info);
+	if (ready != m_yuvReady) {
+		m_yuvReady = ready;
+		emit yuvSupportChanged(ready);
+	}
+}
+
+bool VideoWidget::initYuvRenderer()
+{
+	m_yuvProgram = new QOpenGLShaderProgram(this);
+	if (!m_yuvProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, YUV_VERTEX_SHADER) ||
+		!m_yuvProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, YUV_FRAGMENT_SHADER)) {
+		LogWidget::instance()->addLog("VideoWidget: YUV shader compile failed: " + m_yuvProgram->log(), LogWidget::Warning);
+		delete m_yuvProgram;
+		m_yuvProgram = nullptr;
+		return false;
+	}
+	m_yuvProgram->bindAttributeLocation("position", 0);
+	m_yuvProgram->bindAttributeLocation("texCoord", 1);
+	if (!m_yuvProgram->link()) {
+		LogWidget::instance()->addLog("VideoWidget: YUV shader link failed: " + m_yuvProgram->log(), LogWidget::Warning);
+		delete m_yuvProgram;
+		m_yuvProgram = nullptr;
+		return false;
+	}
+
+	glGenTextures(3, m_yuvTextures);
+	for (GLuint texture : m_yuvTextures) {
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	for (QSize& size : m_textureSizes) {
+		size = QSize();
+	}
+	// 新纹理为空，当前帧需要重新上传
+	m_yuvDirty = true;
+	return true;
+}
+
+void VideoWidget::cleanupGL()
+{
+	if (!m_yuvProgram) {
+		return;
+	}
+	makeCurrent();
+	glDeleteTextures(3, m_yuvTextures);
+	for (GLuint& texture : m_yuvTextures) {
+		texture = 0;
+	}
+	delete m_yuvProgram;
+	m_yuvProgram = nullptr;
+	doneCurrent();
+	if (m_yuvReady) {
+		m_yuvReady = false;
+		emit yuvSupportChanged(false);
+	}
+}
+
+void VideoWidget::drawYuvFrame(const QRectF& display)
 {
-	Q_UNUSED(event);
+	const AVFrame* yuv = m_yuvFrame.data();
+	const int chromaWidth = (yuv->width + 1) / 2;
+	const int chromaHeight = (yuv->height + 1) / 2;
+
+	// 每个平面按行宽整行上传，避免 GLES 2 不支持 GL_UNPACK_ROW_LENGTH 时逐行拷贝，着色器中只采样有效宽度
+	if (m_yuvDirty) {
+		const QSize planeSizes[3] = {
+			QSize(yuv->linesize[0], yuv->height),
+			QSize(yuv->linesize[1], chromaHeight),
+			QSize(yuv->linesize[2], chromaHeight)
+		};
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (int i = 0; i < 3; ++i) {
+			glBindTexture(GL_TEXTURE_2D, m_yuvTextures[i]);
+			if (planeSizes[i] != m_textureSizes[i]) {
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, planeSizes[i].width(), planeSizes[i].height(), 0,
+					GL_LUMINANCE, GL_UNSIGNED_BYTE, yuv->data[i]);
+				m_textureSizes[i] = planeSizes[i];
+			}
+			else {
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, planeSizes[i].width(), planeSizes[i].height(),
+					GL_LUMINANCE, GL_UNSIGNED_BYTE, yuv->data[i]);
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		m_yuvDirty = false;
+	}
+
+	// 服务端按 BT.601 有限范围编码，帧中标明 BT.709 或全范围时按帧的参数转换
+	const bool fullRange = yuv->color_range == AVCOL_RANGE_JPEG || yuv->format == AV_PIX_FMT_YUVJ420P;
+	const bool bt709 = yuv->colorspace == AVCOL_SPC_BT709;
+	const float ys = fullRange ? 1.0f : 255.0f / 219.0f;
+	const float cs = fullRange ? 1.0f : 255.0f / 224.0f;
+	const float rv = bt709 ? 1.5748f : 1.402f;
+	const float gu = bt709 ? -0.187324f : -0.344136f;
+	const float gv = bt709 ? -0.468124f : -0.714136f;
+	const float bu = bt709 ? 1.8556f : 1.772f;
+	// QMatrix3x3 按行给出，结果为 rgb = M * (yuv - offset)
+	const float matrix[9] = {
+		ys, 0.0f, rv * cs,
+		ys, gu * cs, gv * cs,
+		ys, bu * cs, 0.0f
+	};
+
+	// 显示区域换算为标准化设备坐标，纹理第一行为画面顶部
+	const GLfloat left = display.left() / width() * 2.0 - 1.0;
+	const GLfloat right = display.right() / width() * 2.0 - 1.0;
+	const GLfloat top = 1.0 - display.top() / height() * 2.0;
+	const GLfloat bottom = 1.0 - display.bottom() / height() * 2.0;
+	const GLfloat positions[8] = { left, bottom, right, bottom, left, top, right, top };
+	const GLfloat texCoords[8] = { 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+
+	m_yuvProgram->bind();
+	for (int i = 0; i < 3; ++i) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, m_yuvTextures[i]);
+	}
+	m_yuvProgram->setUniformValue("texY", 0);
+	m_yuvProgram->setUniformValue("texU", 1);
+	m_yuvProgram->setUniformValue("texV", 2);
+	m_yuvProgram->setUniformValue("scaleY", GLfloat(yuv->width) / yuv->linesize[0]);
+	m_yuvProgram->setUniformValue("scaleUV", GLfloat(chromaWidth) / yuv->linesize[1]);
+	m_yuvProgram->setUniformValue("offset", QVector3D(fullRange ? 0.0f : 16.0f / 255.0f, 128.0f / 255.0f, 128.0f / 255.0f));
+	m_yuvProgram->setUniformValue("yuvToRgb", QMatrix3x3(matrix));
+	m_yuvProgram->enableAttributeArray(0);
+	m_yuvProgram->enableAttributeArray(1);
+	m_yuvProgram->setAttributeArray(0, GL_FLOAT, positions, 2);
+	m_yuvProgram->setAttributeArray(1, GL_FLOAT, texCoords, 2);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	m_yuvProgram->disableAttributeArray(0);
+	m_yuvProgram->disableAttributeArray(1);
+	m_yuvProgram->release();
+
+	for (int i = 2; i >= 0; --i) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
+
+void VideoWidget::paintGL()
+{
+	// 重绘时才取帧，两次重绘之间到达的多帧只显示最新的一帧
+	FrameMailbox::Frame frame;
+	const bool newFrame = m_frameMailbox && m_frameMailbox->take(frame);
+	if (newFrame) {
+		if (frame.yuv) {
+			m_yuvFrame = frame.yuv;
+			m_yuvDirty = true;
+			currentFrame = QImage();
+			m_frameSize = QSize(frame.yuv->width, frame.yuv->height);
+		}
+		else {
+			currentFrame = frame.image;
+			m_yuvFrame.reset();
+			m_frameSize = currentFrame.size();
+		}
+		m_sourceRect = frame.sourceRect;
+		m_screenSize = frame.screenSize;
+	}
+
 	QPainter painter(this);
-	if (!currentFrame.isNull()) {
-		painter.drawImage(rect(), currentFrame);
+	painter.fillRect(rect(), Qt::black);
+	const QRectF display = displayRect();
+	if (m_yuvFrame && m_yuvProgram) {
+		// 颜色转换和缩放都在着色器中完成
+		painter.beginNativePainting();
+		drawYuvFrame(display);
+		painter.endNativePainting();
+	}
+	else if (!currentFrame.isNull()) {
+		painter.drawImage(display, currentFrame);
+	}
+
+	// 叠加被控端指针，位置和大小按画面对应的屏幕区域换算到显示区域
+	// 指针在画面内时由本地光标显示，只有被控端位置与本地不一致时才另外绘制
+	const bool localCursor = m_pointerInside && m_localCursorSet && !m_localCursorBlank;
+	if (m_cursorVisible && !m_cursorScreenSize.isEmpty() && (!localCursor || m_remoteDiverged)) {
+		auto it = m_cursorShapes.constFind(m_cursorShapeId);
+		if (it != m_cursorShapes.constEnd()) {
+			const QRectF source = m_sourceRect.isEmpty() ? QRectF(QPointF(0, 0), QSizeF(m_cursorScreenSize)) : QRectF(m_sourceRect);
+			const qreal sx = display.width() / source.width();
+			const qreal sy = display.height() / source.height();
+			QRectF target(display.x() + (m_cursorPos.x() - it->hotspot.x() - source.x()) * sx,
+				display.y() + (m_cursorPos.y() - it->hotspot.y() - source.y()) * sy,
+				it->image.width() * sx,
+				it->image.height() * sy);
+			painter.setClipRect(display);
+			painter.drawImage(target, it->image);
+			painter.setClipping(false);
+		}
+	}
+
+	if (newFrame && m_latencyTracer) {
+		m_latencyTracer->framePresented(frame.frameId);
 	}
-	else {
-		painter.fillRect(rect(), Qt::black);
+	// 缩放或窗口大小变化后按新的显示比例更新本地光标
+	updateLocalCursor();
+	if (m_latencyOverlay) {
+		drawLatencyOverlay(painter);
+	}
+}
+
+void VideoWidget::drawLatencyOverlay(QPainter& painter)
+{
+	if (!m_latencyTracer) {
+		return;
+	}
+	if (!m_latencyRefresh.isValid() || m_latencyRefresh.elapsed() >= LATENCY_REFRESH_MS) {
+		m_latencySummary = m_latencyTracer->summarize();
+		m_latencyClock = m_latencyTracer->clockStatus();
+		m_latencyRefresh.start();
+	}
+
+	QFont font("Consolas");
+	font.setStyleHint(QFont::Monospace);
+	font.setPixelSize(12);
+	painter.setFont(font);
+	const QFontMetrics metrics(font);
+	const int lineHeight = metrics.height() + 2;
+	const int textWidth = metrics.horizontalAdvance(QString(40, QLatin1Char('0')));
+	const int bucketWidth = 6;
+	const int histogramWidth = (LatencyTracer::histogramBounds().size() + 1) * bucketWidth;
+	const int padding = 8;
+	const QRect panel(padding, padding, textWidth + histogramWidth + padding * 3,
+		lineHeight * (m_latencySummary.size() + 2) + padding * 2);
+
+	painter.setRenderHint(QPainter::Antialiasing, false);
+	painter.fillRect(panel, QColor(0, 0, 0, 180));
+	int y = panel.top() + padding;
+	const int x = panel.left() + padding;
+	painter.setPen(QColor(200, 200, 200));
+	painter.drawText(QRect(x, y, textWidth, lineHeight), Qt::AlignLeft | Qt::AlignVCenter,
+		QString("%1 %2 %3 %4").arg(QString("stage"), -9).arg(QString("p50"), 8).arg(QString("p95"), 8).arg(QString("max(ms)"), 10));
+	y += lineHeight;
+
+	for (const LatencyTracer::StageSummary& stage : m_latencySummary) {
+		painter.setPen(Qt::white);
+		const QString line = stage.samples == 0
+			? QString("%1 %2").arg(stage.name, -9).arg(QString("n/a"), 8)
+			: QString("%1 %2 %3 %4").arg(stage.name, -9)
+				.arg(stage.p50Ms, 8, 'f', 1).arg(stage.p95Ms, 8, 'f', 1).arg(stage.maxMs, 10, 'f', 1);
+		painter.drawText(QRect(x, y, textWidth, lineHeight), Qt::AlignLeft | Qt::AlignVCenter, line);
+
+		// 分布：每桶一列，高度按该段最多的桶归一化，桶边界见 histogramBounds()
+		int peak = 0;
+		for (int count : stage.histogram) {
+			peak = qMax(peak, count);
+		}
+		if (peak > 0) {
+			const int barLeft = x + textWidth + padding;
+			const int barBottom = y + lineHeight - 2;
+			const int barMax = lineHeight - 4;
+			for (int i = 0; i < stage.histogram.size(); ++i) {
+				const int h = qMax(stage.histogram[i] > 0 ? 1 : 0, stage.histogram[i] * barMax / peak);
+				painter.fillRect(barLeft + i * bucketWidth, barBottom - h, bucketWidth - 1, h, QColor(80, 200, 120));
+			}
+		}
+		y += lineHeight;
+	}
+
+	painter.setPen(QColor(200, 200, 200));
+	painter.drawText(QRect(x, y, panel.width() - padding * 2, lineHeight), Qt::AlignLeft | Qt::AlignVCenter,
+		m_latencyClock);
+}
+
+bool VideoWidget::handleLatencyHotkey(QKeyEvent* event)
+{
+	if (event->key() != Qt::Key_F12 || !(event->modifiers() & Qt::ControlModifier) || !m_latencyTracer) {
+		return false;
+	}
+	if (event->type() != QEvent::KeyPress || event->isAutoRepeat()) {
+		return true;
+	}
+	if (event->modifiers() & Qt::ShiftModifier) {
+		const QString path = QDir::current().absoluteFilePath(
+			QString("latency_%1.csv").arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss")));
+		if (m_latencyTracer->exportCsv(path))
+			LogWidget::instance()->addLog(QString("[Latency] Exported to %1").arg(path), LogWidget::Info);
+		else
+			LogWidget::instance()->addLog(QString("[Latency] Failed to write %1").arg(path), LogWidget::Warning);
+		return true;
+	}
+	m_latencyOverlay = !m_latencyOverlay;
+	m_latencyRefresh.invalidate();
+	if (m_latencyOverlay)
+		m_latencyTimer->start();
+	else
+		m_latencyTimer->stop();
+	update();
+	return true;
+}
+
+void VideoWidget::setCursorEvent(const CursorEvent& cursorEvent)
+{
+	m_cursorPos = QPoint(cursorEvent.x(), cursorEvent.y());
+	m_cursorScreenSize = QSize(static_cast<int>(cursorEvent.screen_width()), static_cast<int>(cursorEvent.screen_height()));
+	m_cursorVisible = cursorEvent.visible();
+	m_cursorShapeId = cursorEvent.shape_id();
+	reconcileRemoteCursor();
+	updateLocalCursor();
+	update();
+}
+
+void VideoWidget::reconcileRemoteCursor()
+{
+	if (!m_pointerClock.isValid()) {
+		m_remoteDiverged = true;
+		return;
+	}
+	// 过期的位置不再参与核对，但保留最后一个：本地停止移动后被控端上报的仍应是这个位置
+	const qint64 now = m_pointerClock.elapsed();
+	while (m_localPositions.size() > 1 && m_localPositions.first().timeMs < now - LOCAL_POSITION_HISTORY_MS) {
+		m_localPositions.removeFirst();
+	}
+	// 输入坐标是 REMOTE_INPUT_W x REMOTE_INPUT_H 的整数，换算回屏幕像素有取整误差
+	const qreal tolerance = CURSOR_MATCH_TOLERANCE
+		+ qMax<qreal>(1.0, static_cast<qreal>(m_cursorScreenSize.width()) / REMOTE_INPUT_W);
+	const QPointF remote(m_cursorPos);
+	bool matched = false;
+	for (const LocalPosition& local : m_localPositions) {
+		if (qAbs(local.screenPos.x() - remote.x()) <= tolerance && qAbs(local.screenPos.y() - remote.y()) <= tolerance) {
+			matched = true;
+			break;
+		}
+	}
+	m_remoteDiverged = !matched;
+}
+
+void VideoWidget::updateLocalCursor()
+{
+	if (!m_pointerInside) {
+		if (m_localCursorSet) {
+			unsetCursor();
+			m_localCursorSet = false;
+		}
+		return;
+	}
+	// 被控端隐藏了指针（全屏视频、游戏等），本地同样隐藏
+	if (!m_cursorScreenSize.isEmpty() && !m_cursorVisible) {
+		if (!m_localCursorSet || !m_localCursorBlank) {
+			setCursor(Qt::BlankCursor);
+			m_localCursorSet = true;
+			m_localCursorBlank = true;
+		}
+		return;
+	}
+	auto it = m_cursorShapes.constFind(m_cursorShapeId);
+	const QRectF source = m_sourceRect.isEmpty() ? QRectF(QPointF(0, 0), QSizeF(m_cursorScreenSize)) : QRectF(m_sourceRect);
+	const QRectF display = displayRect();
+	if (it == m_cursorShapes.constEnd() || source.isEmpty() || display.isEmpty()) {
+		// 还没有收到形状，使用系统默认光标
+		if (m_localCursorSet) {
+			unsetCursor();
+			m_localCursorSet = false;
+		}
+		return;
+	}
+	const qreal scale = display.width() / source.width();
+	if (m_localCursorSet && !m_localCursorBlank && m_localShapeId == m_cursorShapeId && qFuzzyCompare(scale, m_localShapeScale)) {
+		return;
+	}
+	// 按画面的显示比例缩放，与画面中的指针大小一致
+	const qreal dpr = devicePixelRatioF();
+	const QSize size = (QSizeF(it->image.size()) * scale * dpr).toSize().expandedTo(QSize(1, 1));
+	QPixmap pixmap = QPixmap::fromImage(it->image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+	pixmap.setDevicePixelRatio(dpr);
+	setCursor(QCursor(pixmap, qRound(it->hotspot.x() * scale), qRound(it->hotspot.y() * scale)));
+	m_localShapeId = m_cursorShapeId;
+	m_localShapeScale = scale;
+	m_localCursorBlank = false;
+	m_localCursorSet = true;
+}
+
+void VideoWidget::addCursorShape(const CursorShape& cursorShape)
+{
+	const int w = static_cast<int>(cursorShape.width());
+	const int h = static_cast<int>(cursorShape.height());
+	if (w <= 0 || h <= 0 || cursorShape.rgba().size() < static_cast<size_t>(w) * h * 4) {
+		LogWidget::instance()->addLog("Invalid cursor shape received", LogWidget::Warning);
+		return;
+	}
+	RemoteCursor cursor;
+	cursor.image = QImage(reinterpret_cast<const uchar*>(cursorShape.rgba().data()), w, h, w * 4,
+		QImage::Format_RGBA8888).copy();
+	cursor.hotspot = QPoint(static_cast<int>(cursorShape.hotspot_x()), static_cast<int>(cursorShape.hotspot_y()));
+	m_cursorShapes.insert(cursorShape.shape_id(), cursor);
+	if (cursorShape.shape_id() == m_cursorShapeId) {
+		// 同一 shape_id 的形状可能更新，强制重建本地光标
+		m_localShapeScale = 0.0;
+		updateLocalCursor();
+		update();
 	}
 }
 
@@ -49,8 +617,8 @@ void VideoWidget::mousePressEvent(QMouseEvent* event)
 	else if (event->button() == Qt::MiddleButton)
 		mask = MouseMiddleClick;
 
-	QPointF pos = event->position();
-	emit mouseEventCaptured(static_cast<int>(pos.x()), static_cast<int>(pos.y()), mask);
+	const QPoint remote = mapToRemote(event->position());
+	emit mouseEventCaptured(remote.x(), remote.y(), mask);
 }
 
 void VideoWidget::mouseReleaseEvent(QMouseEvent* event)
@@ -59,28 +627,59 @@ void VideoWidget::mouseReleaseEvent(QMouseEvent* event)
 	if (event->button() == Qt::LeftButton)
 		mask = MouseLeftUp;
 
-	QPointF pos = event->position();
-	emit mouseEventCaptured(static_cast<int>(pos.x()), static_cast<int>(pos.y()), mask);
+	const QPoint remote = mapToRemote(event->position());
+	emit mouseEventCaptured(remote.x(), remote.y(), mask);
 }
 
 void VideoWidget::mouseDoubleClickEvent(QMouseEvent* event)
 {
 	int mask = MouseDoubleClick;
-	const QPointF pos = event->position();
-	emit mouseEventCaptured(static_cast<int>(pos.x()), static_cast<int>(pos.y()), mask);
+	const QPoint remote = mapToRemote(event->position());
+	emit mouseEventCaptured(remote.x(), remote.y(), mask);
 }
 
 void VideoWidget::mouseMoveEvent(QMouseEvent* event)
 {
-	if (event->buttons() & Qt::LeftButton) {
-		QPointF pos = event->position();
-		emit mouseEventCaptured(static_cast<int>(pos.x()), static_cast<int>(pos.y()), MouseMove);
+	const bool inside = displayRect().contains(event->position());
+	if (inside != m_pointerInside) {
+		m_pointerInside = inside;
+		updateLocalCursor();
+		update();
+	}
+	// 没有按键时也跟踪指针，被控端的悬停效果和提示才能出现；发送频率由网络线程限制
+	// 悬停只在画面内发送，映射后位置不变的移动不发送
+	if (event->buttons() == Qt::NoButton && !inside) {
+		return;
+	}
+
+	// 记录本地位置用于核对；本地有移动时以本地为准，发出的位置很快会覆盖被控端的指针
+	QPointF screenPos;
+	if (mapToRemoteScreen(event->position(), screenPos)) {
+		if (!m_pointerClock.isValid()) {
+			m_pointerClock.start();
+		}
+		m_localPositions.append({ screenPos, m_pointerClock.elapsed() });
+		if (m_localPositions.size() > LOCAL_POSITION_HISTORY_MAX) {
+			m_localPositions.removeFirst();
+		}
+		if (m_remoteDiverged) {
+			m_remoteDiverged = false;
+			update();
+		}
+	}
+
+	const QPoint remote = mapToRemote(event->position());
+	if (remote == m_lastMoveRemote) {
+		return;
 	}
+	m_lastMoveRemote = remote;
+	emit mouseEventCaptured(remote.x(), remote.y(), MouseMove);
 }
 
 
 void VideoWidget::keyPressEvent(QKeyEvent* event)
 {
+	if (handleLatencyHotkey(event)) return;
 	if (event->isAutoRepeat()) return;
 	LogWidget::instance()->addLog("keyPressEvent ", LogWidget::Warning);
 	emit keyEventCaptured(event->key(), true);
@@ -88,7 +687,8 @@ void VideoWidget::keyPressEvent(QKeyEvent* event)
 
 void VideoWidget::keyReleaseEvent(QKeyEvent* event)
 {
+	if (handleLatencyHotkey(event)) return;
 	LogWidget::instance()->addLog("keyReleaseEvent ", LogWidget::Warning);
 	if (event->isAutoRepeat()) return;
 	emit keyEventCaptured(event->key(), false);
-}
\ No newline at end of file
+}
\ No newline at end of file
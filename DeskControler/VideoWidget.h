@@ -2,46 +2,150 @@
 #define VIDEOWIDGET_H
 
 #include <QtOpenGLWidgets/QOpenGLWidget>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
 #include <QImage>
 #include <QMouseEvent>
 #include <QKeyEvent>
+#include <QEnterEvent>
+#include <QHash>
+#include <QTimer>
+#include <QWheelEvent>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include "rendezvous.pb.h"
+#include "FrameMailbox.h"
+#include "LatencyTracer.h"
 
 
 enum MouseMask {
-	MouseMove = 0x01, // ƶ
-	MouseLeftDown = 0x02, // 
-	MouseLeftUp = 0x04, // ͷ
-	MouseDoubleClick = 0x08, // ˫
-	MouseRightClick = 0x10, // Ҽ
-	MouseMiddleClick = 0x20  // м
+	MouseMove = 0x01, // 鼠标移动
+	MouseLeftDown = 0x02, // 鼠标左键按下
+	MouseLeftUp = 0x04, // 鼠标左键释放
+	MouseDoubleClick = 0x08, // 鼠标左键双击
+	MouseRightClick = 0x10, // 鼠标右键单击
+	MouseMiddleClick = 0x20  // 鼠标中键单击
 };
 
-class VideoWidget : public QOpenGLWidget {
+class VideoWidget : public QOpenGLWidget, protected QOpenGLFunctions {
 	Q_OBJECT
 public:
 	explicit VideoWidget(QWidget* parent = nullptr);
+	~VideoWidget();
+	// 解码帧的来源，重绘时取最新一帧，新帧到达时由外部调用 update()
+	void setFrameMailbox(const QSharedPointer<FrameMailbox>& mailbox);
+	// YUV 着色器可用，解码端可以直接输出 YUV 平面
+	bool supportsYuv() const { return m_yuvReady; }
+	// 绘制后记录帧的显示时刻；Ctrl+F12 显示/隐藏逐段延迟，Ctrl+Shift+F12 导出 CSV
+	void setLatencyTracer(const QSharedPointer<LatencyTracer>& tracer);
 
 signals:
 	void mouseEventCaptured(int x, int y, int mask);
 	void keyEventCaptured(int key, bool pressed);
+	// 显示区域（物理像素）或缩放区域变化，crop 为归一化的被控端屏幕区域，整屏时为 (0,0,1,1)
+	void viewportChanged(const QSize& size, const QRectF& crop);
+	// GL 初始化或上下文销毁后 YUV 绘制能力变化
+	void yuvSupportChanged(bool supported);
 
 public slots:
-	void setFrame(const QImage& image);
+	// 被控端指针：位置变化时只重绘，不等待视频帧
+	void setCursorEvent(const CursorEvent& cursorEvent);
+	void addCursorShape(const CursorShape& cursorShape);
 
 protected:
-	void paintEvent(QPaintEvent* event) override;
+	void initializeGL() override;
+	void paintGL() override;
 	void mousePressEvent(QMouseEvent* event) override;
 	void mouseDoubleClickEvent(QMouseEvent* event) override;
 	void mouseMoveEvent(QMouseEvent* event) override;
 	void mouseReleaseEvent(QMouseEvent* event)	 override;
+	// Ctrl+滚轮以鼠标位置为中心缩放
+	void wheelEvent(QWheelEvent* event) override;
+	void resizeEvent(QResizeEvent* event) override;
+	void enterEvent(QEnterEvent* event) override;
+	void leaveEvent(QEvent* event) override;
 
 	void keyPressEvent(QKeyEvent* event) override;
 	void keyReleaseEvent(QKeyEvent* event) override;
 
 
 private:
+	// 画面按比例适应窗口后的显示区域
+	QRectF displayRect() const;
+	// 窗口坐标换算为发给服务端的输入坐标
+	QPoint mapToRemote(const QPointF& pos) const;
+	// 窗口坐标换算为被控端屏幕像素坐标，服务端未上报画面区域时返回 false
+	bool mapToRemoteScreen(const QPointF& pos, QPointF& screenPos) const;
+	// 指针在画面内时用被控端的指针形状作为本地光标，由系统直接绘制，不等待往返
+	void updateLocalCursor();
+	// 被控端上报的指针位置与本地最近的位置不符（被控端程序移动了指针）时，在画面中另外绘制被控端指针
+	void reconcileRemoteCursor();
+	// 合并短时间内的多次变化后发出 viewportChanged
+	void scheduleViewportUpdate();
+	// 编译 YUV 转 RGB 着色器并创建三个平面纹理，失败时退回绘制 RGBA 图像
+	bool initYuvRenderer();
+	// 上传新帧的 Y/U/V 平面并在 display 区域绘制，需在 beginNativePainting 之后调用
+	void drawYuvFrame(const QRectF& display);
+	void cleanupGL();
+	// 左上角叠加各段延迟的 p50/p95/max 和分布
+	void drawLatencyOverlay(QPainter& painter);
+	// 延迟快捷键在本地处理，不转发给被控端
+	bool handleLatencyHotkey(QKeyEvent* event);
+
+private:
+	QSharedPointer<FrameMailbox> m_frameMailbox;
 	QImage currentFrame;
-	bool m_firstFrame = true;
+	// 当前显示的 YUV 帧，m_yuvDirty 表示尚未上传到纹理
+	QSharedPointer<AVFrame> m_yuvFrame;
+	bool m_yuvDirty = false;
+	QSize m_frameSize;
+	QOpenGLShaderProgram* m_yuvProgram = nullptr;
+	GLuint m_yuvTextures[3] = { 0, 0, 0 };
+	QSize m_textureSizes[3];
+	bool m_yuvReady = false;
+	// sourceRect/screenSize 为画面对应的被控端屏幕区域，为空时按整屏处理
+	QRect m_sourceRect;
+	QSize m_screenSize;
+	// 缩放倍数（1 为整屏）及对应的归一化屏幕区域
+	qreal m_zoom = 1.0;
+	QRectF m_crop = QRectF(0, 0, 1, 1);
+	QTimer* m_viewportTimer = nullptr;
+	// 最近一次发送的移动位置（输入参考坐标）
+	QPoint m_lastMoveRemote = QPoint(-1, -1);
+
+	// 被控端指针形状缓存，按 shape_id 索引
+	struct RemoteCursor {
+		QImage image;
+		QPoint hotspot;
+	};
+	QHash<quint64, RemoteCursor> m_cursorShapes;
+	// 本地光标：指针是否在画面内，当前设置的形状和缩放，避免重复创建 QCursor
+	bool m_pointerInside = false;
+	quint64 m_localShapeId = 0;
+	qreal m_localShapeScale = 0.0;
+	bool m_localCursorBlank = false;
+	bool m_localCursorSet = false;
+	// 最近的本地指针位置（被控端屏幕坐标），用于核对被控端上报的位置
+	struct LocalPosition {
+		QPointF screenPos;
+		qint64 timeMs;
+	};
+	QList<LocalPosition> m_localPositions;
+	QElapsedTimer m_pointerClock;
+	bool m_remoteDiverged = false;
+	// 指针位置为被控端屏幕像素坐标
+	QPoint m_cursorPos;
+	QSize m_cursorScreenSize;
+	bool m_cursorVisible = false;
+	quint64 m_cursorShapeId = 0;
+
+	QSharedPointer<LatencyTracer> m_latencyTracer;
+	bool m_latencyOverlay = false;
+	// 统计结果按间隔刷新，避免每次重绘都排序
+	QVector<LatencyTracer::StageSummary> m_latencySummary;
+	QString m_latencyClock;
+	QElapsedTimer m_latencyRefresh;
+	QTimer* m_latencyTimer = nullptr;
 };
 
 #endif // VIDEOWIDGET_H
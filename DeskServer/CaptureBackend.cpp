@@ -0,0 +1,18 @@
+#include "CaptureBackend.h"
+
+#if defined(Q_OS_WIN)
+#include "DxgiCaptureBackend.h"
+#elif defined(Q_OS_LINUX)
+#include "X11ShmCaptureBackend.h"
+#endif
+
+CaptureBackend* CaptureBackend::create()
+{
+#if defined(Q_OS_WIN)
+    return new DxgiCaptureBackend();
+#elif defined(Q_OS_LINUX)
+    return new X11ShmCaptureBackend();
+#else
+    return nullptr;
+#endif
+}
@@ -0,0 +1,47 @@
+#ifndef CAPTUREBACKEND_H
+#define CAPTUREBACKEND_H
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QList>
+#include <QRect>
+
+// 一次采集的结果
+struct CaptureFrame
+{
+    QImage image;
+    // 相对上一次采集发生变化的区域，为空表示画面没有变化。不支持变化检测的后端总是给出整屏
+    QList<QRect> dirtyRects;
+};
+
+// 屏幕采集后端接口，ScreenCaptureEncoder 通过它取帧，不直接依赖具体平台的采集 API
+class CaptureBackend
+{
+public:
+    virtual ~CaptureBackend() = default;
+
+    // 初始化采集设备，失败时返回 false
+    virtual bool init() = 0;
+
+    // 抓取一帧 Format_RGB32（内存布局 BGRA）图像。没有新画面或抓取失败时返回上一帧
+    // 返回的图像可能直接引用后端内部缓冲，只保证在下一次 grab() 之前有效
+    virtual CaptureFrame grab() = 0;
+
+    // 画面变化通知（如 X11 XDamage）。支持时 damageHandle() 返回一个可监听的描述符，
+    // 可读即表示有新的变化，此时调用 grab() 会在 dirtyRects 中带回变化区域
+    virtual bool supportsDamage() const { return false; }
+    virtual int damageHandle() const { return -1; }
+    // 是否还有已到达但未被 grab() 取走的变化（可能已被 Xlib 读入内部队列，描述符不会再次可读）
+    virtual bool hasPendingDamage() { return false; }
+
+    // 采集源尺寸
+    virtual QSize size() const = 0;
+
+    virtual QString name() const = 0;
+
+    // 按平台创建默认后端：Windows 为 DXGI 桌面复制，Linux 为 X11 MIT-SHM
+    static CaptureBackend* create();
+};
+
+#endif // CAPTUREBACKEND_H
@@ -0,0 +1,154 @@
+#include "ContentClassifier.h"
+
+// 滑动平均系数，约 10 帧的记忆
+#define EMA_ALPHA 0.2
+// 变化分块比例超过该值且边缘密度低于阈值时判为运动画面
+// 滚动文字同样大面积变化，但边缘密度高，仍按文字处理
+#define MOTION_DIRTY_RATIO 0.10
+#define MOTION_EDGE_DENSITY 0.12
+// 相邻像素亮度差超过该值计为边缘
+#define EDGE_LUMA_DELTA 40
+// 迟滞：切到运动需持续 1 秒，切回文字需持续 3 秒，避免在两种配置之间来回切换
+#define MOTION_ENTER_MS 1000
+#define MOTION_LEAVE_MS 3000
+// 采样步长：每 4 行取一行，每行每 2 个像素取一个
+#define SAMPLE_ROW_STEP 4
+#define SAMPLE_COL_STEP 2
+
+static inline int luma(quint32 pixel)
+{
+    // 近似 0.25R + 0.625G + 0.125B
+    return ((((pixel >> 16) & 0xFF) * 2) + (((pixel >> 8) & 0xFF) * 5) + (pixel & 0xFF)) >> 3;
+}
+
+const ContentProfile& ContentClassifier::profile(ContentType type)
+{
+    static const ContentProfile profiles[] = {
+        { "text", "superfast", 10, 32, 10 },
+        { "motion", "ultrafast", 18, 45, 30 },
+    };
+    return profiles[type == ContentMotion ? 1 : 0];
+}
+
+void ContentClassifier::reset()
+{
+    m_imageSize = QSize();
+    m_tileHashes.clear();
+    m_changedRects.clear();
+    m_dirtyRatio = 0.0;
+    m_edgeDensity = 0.0;
+    m_current = ContentText;
+    m_candidateSince.invalidate();
+}
+
+int ContentClassifier::sampleTiles(const QImage& image, int& edgeSamples, int& edgeHits)
+{
+    int changedTiles = 0;
+    m_changedRects.clear();
+    for (int ty = 0; ty < m_tilesY; ++ty)
+    {
+        const int y0 = ty * TILE_SIZE;
+        const int y1 = qMin(y0 + TILE_SIZE, image.height());
+        // 本行正在合并的变化分块起点，-1 表示没有
+        int runStart = -1;
+        for (int tx = 0; tx < m_tilesX; ++tx)
+        {
+            const int x0 = tx * TILE_SIZE;
+            const int x1 = qMin(x0 + TILE_SIZE, image.width()) - 1;
+            quint32 hash = 2166136261u;
+            int samples = 0;
+            int hits = 0;
+            for (int y = y0; y < y1; y += SAMPLE_ROW_STEP)
+            {
+                const quint32* line = reinterpret_cast<const quint32*>(image.constScanLine(y));
+                for (int x = x0; x < x1; x += SAMPLE_COL_STEP)
+                {
+                    hash = (hash ^ (line[x] & 0x00FFFFFF)) * 16777619u;
+                    ++samples;
+                    if (qAbs(luma(line[x]) - luma(line[x + 1])) > EDGE_LUMA_DELTA)
+                    {
+                        ++hits;
+                    }
+                }
+            }
+
+            quint32& previous = m_tileHashes[ty * m_tilesX + tx];
+            if (previous != hash)
+            {
+                previous = hash;
+                ++changedTiles;
+                // 边缘密度只统计变化的分块，反映正在更新的内容
+                edgeSamples += samples;
+                edgeHits += hits;
+                if (runStart < 0)
+                {
+                    runStart = x0;
+                }
+            }
+            else if (runStart >= 0)
+            {
+                m_changedRects.append(QRect(runStart, y0, x0 - runStart, y1 - y0));
+                runStart = -1;
+            }
+        }
+        if (runStart >= 0)
+        {
+            m_changedRects.append(QRect(runStart, y0, image.width() - runStart, y1 - y0));
+        }
+    }
+    return changedTiles;
+}
+
+ContentClassifier::ContentType ContentClassifier::analyze(const QImage& image)
+{
+    if (image.isNull() || image.depth() != 32 || image.width() < 2)
+    {
+        return m_current;
+    }
+
+    if (image.size() != m_imageSize)
+    {
+        // 尺寸变化后重新建立分块，第一帧只记录哈希
+        m_imageSize = image.size();
+        m_tilesX = (image.width() + TILE_SIZE - 1) / TILE_SIZE;
+        m_tilesY = (image.height() + TILE_SIZE - 1) / TILE_SIZE;
+        m_tileHashes.fill(0, m_tilesX * m_tilesY);
+        int samples = 0;
+        int hits = 0;
+        sampleTiles(image, samples, hits);
+        m_changedRects.clear();
+        return m_current;
+    }
+
+    int edgeSamples = 0;
+    int edgeHits = 0;
+    const int changedTiles = sampleTiles(image, edgeSamples, edgeHits);
+
+    const double dirty = static_cast<double>(changedTiles) / (m_tilesX * m_tilesY);
+    m_dirtyRatio += EMA_ALPHA * (dirty - m_dirtyRatio);
+    if (edgeSamples > 0)
+    {
+        m_edgeDensity += EMA_ALPHA * (static_cast<double>(edgeHits) / edgeSamples - m_edgeDensity);
+    }
+
+    const ContentType wanted = (m_dirtyRatio > MOTION_DIRTY_RATIO && m_edgeDensity < MOTION_EDGE_DENSITY)
+                                   ? ContentMotion
+                                   : ContentText;
+    if (wanted == m_current)
+    {
+        m_candidateSince.invalidate();
+        return m_current;
+    }
+    if (!m_candidateSince.isValid())
+    {
+        m_candidateSince.start();
+        return m_current;
+    }
+    const int holdMs = (wanted == ContentMotion) ? MOTION_ENTER_MS : MOTION_LEAVE_MS;
+    if (m_candidateSince.elapsed() >= holdMs)
+    {
+        m_current = wanted;
+        m_candidateSince.invalidate();
+    }
+    return m_current;
+}
@@ -0,0 +1,65 @@
+#ifndef CONTENTCLASSIFIER_H
+#define CONTENTCLASSIFIER_H
+
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <QVector>
+#include <QElapsedTimer>
+
+// 一种内容对应的编码参数，码率相同，在画质和帧率之间取舍
+struct ContentProfile
+{
+    const char* name;
+    const char* preset; // x264/x265 preset
+    int qmin;
+    int qmax;
+    int maxFps;
+};
+
+// 屏幕内容分类：按分块统计变化比例和边缘密度，区分文字/界面和视频/动画
+// 只在采集线程中使用
+class ContentClassifier
+{
+public:
+    enum ContentType
+    {
+        ContentText = 0,   // 文字、办公、终端：低帧率、低 QP，文字清晰
+        ContentMotion = 1  // 视频、动画：高帧率、放宽 QP
+    };
+
+    static const ContentProfile& profile(ContentType type);
+
+    // 分析一帧 Format_RGB32 图像，返回经过迟滞处理的当前内容类型
+    ContentType analyze(const QImage& image);
+
+    ContentType current() const { return m_current; }
+    double dirtyRatio() const { return m_dirtyRatio; }
+    double edgeDensity() const { return m_edgeDensity; }
+    // 最近一帧中变化的分块，同一行相邻的分块合并为一个矩形（采集图像坐标）
+    const QList<QRect>& changedRects() const { return m_changedRects; }
+
+    void reset();
+
+private:
+    // 采样的分块哈希和边缘计数，返回变化分块数
+    int sampleTiles(const QImage& image, int& edgeSamples, int& edgeHits);
+
+    static const int TILE_SIZE = 64;
+
+    QSize m_imageSize;
+    int m_tilesX = 0;
+    int m_tilesY = 0;
+    QVector<quint32> m_tileHashes;
+    QList<QRect> m_changedRects;
+
+    // 指数滑动平均
+    double m_dirtyRatio = 0.0;
+    double m_edgeDensity = 0.0;
+
+    ContentType m_current = ContentText;
+    // 另一类型持续满足条件的起始时间，达到迟滞时长才切换
+    QElapsedTimer m_candidateSince;
+};
+
+#endif // CONTENTCLASSIFIER_H
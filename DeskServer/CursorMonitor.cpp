@@ -0,0 +1,283 @@
+#include "CursorMonitor.h"
+#include "LogWidget.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_LINUX)
+#include <X11/Xlib.h>
+#include <X11/extensions/Xfixes.h>
+#endif
+
+CursorMonitor::CursorMonitor(QObject* parent)
+    : QObject(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &CursorMonitor::poll);
+
+#ifdef Q_OS_LINUX
+    m_display = XOpenDisplay(nullptr);
+    if (!m_display)
+    {
+        LogWidget::instance()->addLog("CursorMonitor: Cannot open X display", LogWidget::Error);
+    }
+    else
+    {
+        // 订阅形状变化通知，轮询时只用 XQueryPointer 取位置，不必每次拷贝整幅指针图像
+        int errorBase = 0;
+        int major = 0;
+        int minor = 0;
+        if (XFixesQueryExtension(m_display, &m_xfixesEventBase, &errorBase) &&
+            XFixesQueryVersion(m_display, &major, &minor) && major >= 2)
+        {
+            XFixesSelectCursorInput(m_display, DefaultRootWindow(m_display), XFixesDisplayCursorNotifyMask);
+        }
+        else
+        {
+            m_xfixesEventBase = -1;
+            LogWidget::instance()->addLog("CursorMonitor: XFixes cursor notify unavailable, polling cursor image", LogWidget::Warning);
+        }
+    }
+#endif
+}
+
+CursorMonitor::~CursorMonitor()
+{
+    stop();
+#ifdef Q_OS_LINUX
+    if (m_display)
+    {
+        XCloseDisplay(m_display);
+        m_display = nullptr;
+    }
+#endif
+}
+
+void CursorMonitor::start()
+{
+    m_sentShapes.clear();
+    m_hasLast = false;
+    poll();
+    m_timer->start(POLL_INTERVAL_MS);
+}
+
+void CursorMonitor::stop()
+{
+    m_timer->stop();
+}
+
+void CursorMonitor::poll()
+{
+    QPoint pos;
+    bool visible = false;
+    quint64 handle = 0;
+    if (!readCursor(pos, visible, handle))
+    {
+        return;
+    }
+
+    // 形状句柄变化时读取图像并计算哈希，相同形状在不同句柄下得到同一个 shape_id
+    quint64 shapeId = m_lastShapeId;
+    if (!m_hasLast || handle != m_lastHandle)
+    {
+        auto it = m_handleShapes.constFind(handle);
+        QImage image;
+        QPoint hotspot;
+        if (it != m_handleShapes.constEnd() && m_sentShapes.contains(it.value()))
+        {
+            shapeId = it.value();
+        }
+        else if (readShape(image, hotspot))
+        {
+            shapeId = shapeHash(image, hotspot);
+            m_handleShapes.insert(handle, shapeId);
+            if (!m_sentShapes.contains(shapeId))
+            {
+                CursorShape shape;
+                shape.set_shape_id(shapeId);
+                shape.set_width(image.width());
+                shape.set_height(image.height());
+                shape.set_hotspot_x(hotspot.x());
+                shape.set_hotspot_y(hotspot.y());
+                for (int y = 0; y < image.height(); ++y)
+                {
+                    shape.mutable_rgba()->append(reinterpret_cast<const char*>(image.constScanLine(y)), image.width() * 4);
+                }
+                m_sentShapes.insert(shapeId);
+                emit cursorShapeReady(shape);
+            }
+        }
+        m_lastHandle = handle;
+    }
+
+    if (m_hasLast && pos == m_lastPos && visible == m_lastVisible && shapeId == m_lastShapeId)
+    {
+        return;
+    }
+    m_hasLast = true;
+    m_lastPos = pos;
+    m_lastVisible = visible;
+    m_lastShapeId = shapeId;
+
+    const QSize screen = screenSize();
+    CursorEvent event;
+    event.set_x(pos.x());
+    event.set_y(pos.y());
+    event.set_screen_width(screen.width());
+    event.set_screen_height(screen.height());
+    event.set_visible(visible);
+    event.set_shape_id(shapeId);
+    emit cursorEventReady(event);
+}
+
+quint64 CursorMonitor::shapeHash(const QImage& image, const QPoint& hotspot)
+{
+    quint64 hash = qHashBits(image.constBits(), static_cast<size_t>(image.sizeInBytes()));
+    hash = hash * 31 + static_cast<quint64>(image.width());
+    hash = hash * 31 + static_cast<quint64>(image.height());
+    hash = hash * 31 + static_cast<quint64>(hotspot.x());
+    hash = hash * 31 + static_cast<quint64>(hotspot.y());
+    // 0 保留为“无形状”
+    return hash ? hash : 1;
+}
+
+#if defined(Q_OS_WIN)
+
+bool CursorMonitor::readCursor(QPoint& pos, bool& visible, quint64& handle)
+{
+    CURSORINFO info = {};
+    info.cbSize = sizeof(info);
+    if (!GetCursorInfo(&info))
+    {
+        return false;
+    }
+    pos = QPoint(info.ptScreenPos.x, info.ptScreenPos.y);
+    visible = (info.flags & CURSOR_SHOWING) != 0 && info.hCursor != nullptr;
+    handle = reinterpret_cast<quint64>(info.hCursor);
+    return true;
+}
+
+bool CursorMonitor::readShape(QImage& image, QPoint& hotspot)
+{
+    CURSORINFO info = {};
+    info.cbSize = sizeof(info);
+    if (!GetCursorInfo(&info) || !info.hCursor)
+    {
+        return false;
+    }
+
+    ICONINFO iconInfo = {};
+    if (!GetIconInfo(info.hCursor, &iconInfo))
+    {
+        return false;
+    }
+    hotspot = QPoint(static_cast<int>(iconInfo.xHotspot), static_cast<int>(iconInfo.yHotspot));
+    if (iconInfo.hbmColor)
+    {
+        DeleteObject(iconInfo.hbmColor);
+    }
+    if (iconInfo.hbmMask)
+    {
+        DeleteObject(iconInfo.hbmMask);
+    }
+
+    // fromHICON 会处理单色指针的与/异或掩码
+    image = QImage::fromHICON(info.hCursor).convertToFormat(QImage::Format_RGBA8888);
+    return !image.isNull();
+}
+
+QSize CursorMonitor::screenSize() const
+{
+    return QSize(GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN));
+}
+
+#elif defined(Q_OS_LINUX)
+
+bool CursorMonitor::readCursor(QPoint& pos, bool& visible, quint64& handle)
+{
+    if (!m_display)
+    {
+        return false;
+    }
+    // 取走形状变化通知，序号变化时才读取指针图像更新序号和可见性
+    while (XPending(m_display) > 0)
+    {
+        XEvent event;
+        XNextEvent(m_display, &event);
+        if (m_xfixesEventBase >= 0 && event.type == m_xfixesEventBase + XFixesCursorNotify)
+        {
+            const XFixesCursorNotifyEvent* notify = reinterpret_cast<const XFixesCursorNotifyEvent*>(&event);
+            if (notify->cursor_serial != m_cursorSerial)
+            {
+                m_cursorDirty = true;
+            }
+        }
+    }
+    if (m_cursorDirty || m_xfixesEventBase < 0)
+    {
+        XFixesCursorImage* cursor = XFixesGetCursorImage(m_display);
+        if (!cursor)
+        {
+            return false;
+        }
+        m_cursorSerial = cursor->cursor_serial;
+        m_cursorVisible = cursor->width > 0 && cursor->height > 0;
+        m_cursorDirty = false;
+        XFree(cursor);
+    }
+
+    Window root = 0;
+    Window child = 0;
+    int rootX = 0;
+    int rootY = 0;
+    int winX = 0;
+    int winY = 0;
+    unsigned int mask = 0;
+    if (!XQueryPointer(m_display, DefaultRootWindow(m_display), &root, &child, &rootX, &rootY, &winX, &winY, &mask))
+    {
+        return false;
+    }
+    pos = QPoint(rootX, rootY);
+    visible = m_cursorVisible;
+    handle = m_cursorSerial;
+    return true;
+}
+
+bool CursorMonitor::readShape(QImage& image, QPoint& hotspot)
+{
+    if (!m_display)
+    {
+        return false;
+    }
+    XFixesCursorImage* cursor = XFixesGetCursorImage(m_display);
+    if (!cursor)
+    {
+        return false;
+    }
+    hotspot = QPoint(cursor->xhot, cursor->yhot);
+    // XFixes 以 unsigned long 存放预乘 ARGB，每像素一个
+    image = QImage(cursor->width, cursor->height, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < cursor->height; ++y)
+    {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < cursor->width; ++x)
+        {
+            line[x] = static_cast<QRgb>(cursor->pixels[y * cursor->width + x]);
+        }
+    }
+    XFree(cursor);
+    image = image.convertToFormat(QImage::Format_RGBA8888);
+    return !image.isNull();
+}
+
+QSize CursorMonitor::screenSize() const
+{
+    if (!m_display)
+    {
+        return QSize();
+    }
+    int screen = DefaultScreen(m_display);
+    return QSize(DisplayWidth(m_display, screen), DisplayHeight(m_display, screen));
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef CURSORMONITOR_H
+#define CURSORMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QPoint>
+#include <QSize>
+#include <QSet>
+#include <QHash>
+#include <QImage>
+#include "rendezvous.pb.h"
+
+#ifdef Q_OS_LINUX
+struct _XDisplay;
+#endif
+
+// 鼠标指针监视：以较高频率采样指针位置和形状，变化时发出 CursorEvent，
+// 新形状第一次出现时先发出 CursorShape。指针不进入视频编码，由控制端本地叠加
+class CursorMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CursorMonitor(QObject* parent = nullptr);
+    ~CursorMonitor();
+
+public slots:
+    // 会话开始：清空已发送形状记录，立即发送一次当前指针
+    void start();
+    void stop();
+
+signals:
+    void cursorEventReady(const CursorEvent& event);
+    void cursorShapeReady(const CursorShape& shape);
+
+private slots:
+    void poll();
+
+private:
+    // 平台相关：读取当前指针位置、可见性和形状句柄（形状变化时句柄改变）
+    bool readCursor(QPoint& pos, bool& visible, quint64& handle);
+    // 平台相关：读取当前指针图像（RGBA8888）和热点
+    bool readShape(QImage& image, QPoint& hotspot);
+    QSize screenSize() const;
+
+    static quint64 shapeHash(const QImage& image, const QPoint& hotspot);
+
+    // 采样间隔（毫秒）
+    static const int POLL_INTERVAL_MS = 8;
+
+    QTimer* m_timer;
+    QPoint m_lastPos;
+    bool m_lastVisible = false;
+    quint64 m_lastShapeId = 0;
+    quint64 m_lastHandle = 0;
+    bool m_hasLast = false;
+    // 形状句柄 -> 形状哈希，句柄不变时不重复读取图像
+    QHash<quint64, quint64> m_handleShapes;
+    // 本次会话已发送给控制端的形状
+    QSet<quint64> m_sentShapes;
+
+#ifdef Q_OS_LINUX
+    _XDisplay* m_display = nullptr;
+    // XFixes 形状变化通知的事件号基数，扩展不可用时为 -1，每次都重新读取形状序号
+    int m_xfixesEventBase = -1;
+    // 最近一次读取的形状序号和可见性，收到形状变化通知后才重新读取
+    unsigned long m_cursorSerial = 0;
+    bool m_cursorVisible = false;
+    bool m_cursorDirty = true;
+#endif
+};
+
+#endif // CURSORMONITOR_H
@@ -5,6 +5,9 @@
 
 #include <QObject>
 #include <QList>
+#include <QRect>
+#include <QSize>
+#include <chrono>
 
 enum MouseMask
 {
@@ -58,4 +61,51 @@ struct DeskTouchEvent
 };
 Q_DECLARE_METATYPE(DeskTouchEvent)
 
+// 一条鼠标或键盘输入，批量注入时使用
+struct DeskInputEvent
+{
+    enum Type
+    {
+        Mouse,
+        Keyboard
+    };
+    Type type = Mouse;
+    // 鼠标：服务端输入坐标、MouseMask 和滚轮值
+    int x = 0;
+    int y = 0;
+    int mask = 0;
+    int value = 0;
+    // 键盘：Qt 键值
+    int key = 0;
+    bool pressed = false;
+};
+Q_DECLARE_METATYPE(DeskInputEvent)
+
+// 进程内统一的单调时钟（微秒），采集、编码、发送时刻和时钟同步都使用该时钟
+inline qint64 deskClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 编码输出包的描述信息，随 encodedPacketReady 一起发出
+struct VideoPacketInfo
+{
+    quint32 frameId = 0;
+    int sliceIndex = 0;  // 分片模式下的 slice 序号
+    int sliceCount = 1;  // 本帧 slice 总数，1 表示整帧
+    bool keyFrame = false;
+    int codec = 0;       // VideoCodec 枚举值
+    QRect sourceRect;    // 本帧对应的屏幕区域（采集像素）
+    QSize screenSize;    // 采集尺寸
+    // 分块模式下的 tile 序号和总数，tileCount 为 1 表示不分块
+    int tileId = 0;
+    int tileCount = 1;
+    bool lastTile = true;
+    // 采集时刻和编码完成时刻（deskClockUs），参数集等非画面包为 0
+    qint64 captureTimeUs = 0;
+    qint64 encodeDoneUs = 0;
+};
+Q_DECLARE_METATYPE(VideoPacketInfo)
+
 #endif // DESKDEFINE_H
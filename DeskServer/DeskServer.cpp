@@ -7,6 +7,8 @@
 #include <QtNetwork/QHostInfo>
 #include <QBuffer>
 #include "LogWidget.h"
+#include "EncoderOptions.h"
+#include "ScreenCaptureEncoder.h"
 
 DeskServer::DeskServer(QWidget* parent)
     : QWidget(parent), m_peerClient(nullptr)
@@ -33,6 +35,7 @@ DeskServer::~DeskServer()
         m_relayPeerClient->stop();
         m_relayPeerClient->deleteLater();
     }
+    ScreenCaptureEncoder::releaseShared();
 }
 
 void DeskServer::loadConfig()
@@ -70,6 +73,7 @@ void DeskServer::loadConfig()
         };
         // 默认情况下生成一个新的 uuid
         config["uuid"] = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        config["encoder"] = EncoderOptions().toJson();
 
         // 写入默认配置到文件
         if (file.open(QIODevice::WriteOnly))
@@ -88,6 +92,7 @@ void DeskServer::loadConfig()
     QJsonObject serverObj = config["server"].toObject();
     QJsonObject relayObj = config["relay"].toObject();
     m_uuidStr = config["uuid"].toString() == "" ? QUuid::createUuid().toString(QUuid::WithoutBraces): config["uuid"].toString();
+    EncoderOptions::global().load(config["encoder"].toObject());
 
     // 设置 UI 输入框的默认值
     ui.iPLineEdit->setText(serverObj["ip"].toString("127.0.0.1"));
@@ -111,6 +116,7 @@ void DeskServer::saveConfig()
     config["relay"] = relayObj;
 
     config["uuid"] = m_uuidStr;
+    config["encoder"] = EncoderOptions::global().toJson();
 
     QJsonDocument doc(config);
     QFile file("DeskServer.json");
@@ -252,6 +258,8 @@ void DeskServer::onStartClicked()
         }
 
         saveConfig();
+        // 提前创建并预热编码器，控制端连入时不再承担编码器打开和 DXGI 初始化的开销
+        ScreenCaptureEncoder::shared();
         m_peerClient = new PeerClient(m_uuidStr,this);
 
         m_peerClient->setRelayInfo(relayHost, relayPort);
@@ -0,0 +1,58 @@
+#include "DxgiCaptureBackend.h"
+
+#ifdef Q_OS_WIN
+
+#include <QDebug>
+#include "DXGIManager.h"
+
+DxgiCaptureBackend::~DxgiCaptureBackend()
+{
+    if (m_pDXGIManager)
+    {
+        delete m_pDXGIManager;
+        m_pDXGIManager = nullptr;
+    }
+}
+
+bool DxgiCaptureBackend::init()
+{
+    if (!m_pDXGIManager)
+    {
+        m_pDXGIManager = new DXGIManager;
+        m_pDXGIManager->SetCaptureSource(CSMonitor1);//!< 屏幕1 主屏
+        //!< 获取主屏大小，并先初始化一个图片内存
+        RECT rcDest;
+        m_pDXGIManager->GetOutputRect(rcDest);
+        m_iDeskHeight = rcDest.bottom - rcDest.top; //!< 主屏高度
+        m_iDeskWidth = rcDest.right - rcDest.left;	//!< 主屏宽度
+
+        m_image = QImage(m_iDeskWidth, m_iDeskHeight, QImage::Format_RGB32);//!< 图片大小
+    }
+    return true;
+}
+
+CaptureFrame DxgiCaptureBackend::grab()
+{
+    CaptureFrame frame;
+    if (!m_pDXGIManager)
+    {
+        qDebug() << "Error no DXGIManager";
+        return frame;
+    }
+
+    QImage bufferImage;
+    HRESULT hr = m_pDXGIManager->CaptureScreen(bufferImage);
+    m_iFrame += 1;
+
+    if (SUCCEEDED(hr))
+    {
+        m_image = bufferImage;
+    }
+
+    // DXGIManager 不提供脏矩形，按整屏变化处理
+    frame.image = m_image;
+    frame.dirtyRects.append(m_image.rect());
+    return frame;
+}
+
+#endif // Q_OS_WIN
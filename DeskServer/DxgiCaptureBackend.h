@@ -0,0 +1,33 @@
+#ifndef DXGICAPTUREBACKEND_H
+#define DXGICAPTUREBACKEND_H
+
+#include "CaptureBackend.h"
+
+#ifdef Q_OS_WIN
+
+class DXGIManager;
+
+// Windows 桌面复制（Desktop Duplication）采集，采集主屏
+class DxgiCaptureBackend : public CaptureBackend
+{
+public:
+    DxgiCaptureBackend() = default;
+    ~DxgiCaptureBackend() override;
+
+    bool init() override;
+    CaptureFrame grab() override;
+    QSize size() const override { return QSize(m_iDeskWidth, m_iDeskHeight); }
+    QString name() const override { return "DXGI"; }
+
+private:
+    DXGIManager* m_pDXGIManager = nullptr;
+    int m_iDeskWidth = 0;
+    int m_iDeskHeight = 0;
+    // 最近一次成功抓取的画面
+    QImage m_image;
+    int m_iFrame = 0;
+};
+
+#endif // Q_OS_WIN
+
+#endif // DXGICAPTUREBACKEND_H
@@ -0,0 +1,184 @@
+#include "EncodeGovernor.h"
+
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#else
+#include <QFile>
+#include <QStringList>
+#endif
+
+// 评估窗口
+#define GOVERNOR_WINDOW_MS 1000
+// 平均耗时超过帧预算的 80% 或 CPU 超过 90% 视为过载，耗时低于 40% 且 CPU 低于 70% 视为有余量
+#define OVERLOAD_COST_RATIO 0.8
+#define OVERLOAD_CPU 0.90
+#define HEADROOM_COST_RATIO 0.4
+#define HEADROOM_CPU 0.70
+// 两次降级之间的最小间隔，回升所需的持续余量时间及其上限
+#define STEP_DOWN_INTERVAL_MS 2000
+#define STEP_UP_HOLD_MS 5000
+#define STEP_UP_HOLD_MAX_MS 60000
+// 回升后这段时间内又过载，说明回升过早
+#define STEP_UP_PROBATION_MS 10000
+
+static const EncodeGovernor::Level LEVELS[] = {
+    { 1.0, 1.0, false },
+    { 0.75, 1.0, false },
+    { 0.5, 1.0, false },
+    { 0.5, 1.0, true },
+    { 0.5, 0.75, true },
+    { 0.34, 0.5, true },
+};
+static const int LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+EncodeGovernor::EncodeGovernor()
+    : m_stepUpHoldMs(STEP_UP_HOLD_MS)
+{
+}
+
+const EncodeGovernor::Level& EncodeGovernor::current() const
+{
+    return LEVELS[m_level];
+}
+
+void EncodeGovernor::reset()
+{
+    m_level = 0;
+    m_lastDecision.clear();
+    m_window.invalidate();
+    m_frames = 0;
+    m_costSumUs = 0;
+    m_lastChange.invalidate();
+    m_lastStepUp.invalidate();
+    m_headroomSince.invalidate();
+    m_stepUpHoldMs = STEP_UP_HOLD_MS;
+}
+
+double EncodeGovernor::sampleCpuLoad()
+{
+    quint64 idle = 0;
+    quint64 total = 0;
+#ifdef Q_OS_WIN
+    FILETIME idleTime, kernelTime, userTime;
+    if (!GetSystemTimes(&idleTime, &kernelTime, &userTime))
+    {
+        return -1.0;
+    }
+    auto toU64 = [](const FILETIME& ft) {
+        return (static_cast<quint64>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    };
+    idle = toU64(idleTime);
+    // 内核时间包含空闲时间
+    total = toU64(kernelTime) + toU64(userTime);
+#else
+    QFile stat("/proc/stat");
+    if (!stat.open(QIODevice::ReadOnly))
+    {
+        return -1.0;
+    }
+    // cpu  user nice system idle iowait irq softirq steal
+    const QStringList fields = QString::fromLatin1(stat.readLine()).simplified().split(' ');
+    if (fields.size() < 5)
+    {
+        return -1.0;
+    }
+    for (int i = 1; i < fields.size() && i <= 8; ++i)
+    {
+        total += fields[i].toULongLong();
+    }
+    idle = fields[4].toULongLong() + (fields.size() > 5 ? fields[5].toULongLong() : 0);
+#endif
+    const quint64 idleDelta = idle - m_lastIdle;
+    const quint64 totalDelta = total - m_lastTotal;
+    const bool first = (m_lastTotal == 0);
+    m_lastIdle = idle;
+    m_lastTotal = total;
+    if (first || totalDelta == 0)
+    {
+        return -1.0;
+    }
+    return 1.0 - static_cast<double>(idleDelta) / totalDelta;
+}
+
+bool EncodeGovernor::addFrame(qint64 costUs, int budgetMs)
+{
+    if (!m_window.isValid())
+    {
+        m_window.start();
+        sampleCpuLoad();
+    }
+    ++m_frames;
+    m_costSumUs += costUs;
+    m_budgetMs = budgetMs;
+    if (m_window.elapsed() < GOVERNOR_WINDOW_MS)
+    {
+        return false;
+    }
+
+    const double avgCostMs = m_costSumUs / 1000.0 / m_frames;
+    const double cpu = sampleCpuLoad();
+    m_window.restart();
+    m_frames = 0;
+    m_costSumUs = 0;
+    if (m_budgetMs <= 0)
+    {
+        return false;
+    }
+
+    const double costRatio = avgCostMs / m_budgetMs;
+    const QString reason = QString("encode %1 ms / budget %2 ms, cpu %3")
+                               .arg(avgCostMs, 0, 'f', 1)
+                               .arg(m_budgetMs)
+                               .arg(cpu < 0 ? QString("n/a") : QString("%1%").arg(qRound(cpu * 100)));
+
+    const bool overloaded = costRatio > OVERLOAD_COST_RATIO || cpu > OVERLOAD_CPU;
+    const bool headroom = costRatio < HEADROOM_COST_RATIO && cpu < HEADROOM_CPU;
+
+    if (overloaded)
+    {
+        m_headroomSince.invalidate();
+        if (m_level + 1 >= LEVEL_COUNT ||
+            (m_lastChange.isValid() && m_lastChange.elapsed() < STEP_DOWN_INTERVAL_MS))
+        {
+            return false;
+        }
+        if (m_lastStepUp.isValid() && m_lastStepUp.elapsed() < STEP_UP_PROBATION_MS)
+        {
+            m_stepUpHoldMs = qMin(m_stepUpHoldMs * 2, STEP_UP_HOLD_MAX_MS);
+        }
+        m_lastDecision = QString("level %1 -> %2 (overloaded: %3)").arg(m_level).arg(m_level + 1).arg(reason);
+        ++m_level;
+        m_lastChange.start();
+        return true;
+    }
+
+    if (!headroom || m_level == 0)
+    {
+        m_headroomSince.invalidate();
+        // 长时间稳定后恢复默认的回升等待时间
+        if (m_lastChange.isValid() && m_lastChange.elapsed() > STEP_UP_HOLD_MAX_MS)
+        {
+            m_stepUpHoldMs = STEP_UP_HOLD_MS;
+        }
+        return false;
+    }
+    if (!m_headroomSince.isValid())
+    {
+        m_headroomSince.start();
+        return false;
+    }
+    if (m_headroomSince.elapsed() < m_stepUpHoldMs)
+    {
+        return false;
+    }
+    m_lastDecision = QString("level %1 -> %2 (headroom for %3 s: %4)")
+                         .arg(m_level)
+                         .arg(m_level - 1)
+                         .arg(m_stepUpHoldMs / 1000)
+                         .arg(reason);
+    --m_level;
+    m_lastChange.start();
+    m_lastStepUp.start();
+    m_headroomSince.invalidate();
+    return true;
+}
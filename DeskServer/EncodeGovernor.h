@@ -0,0 +1,56 @@
+#ifndef ENCODEGOVERNOR_H
+#define ENCODEGOVERNOR_H
+
+#include <QString>
+#include <QElapsedTimer>
+
+// 编码负载调节：统计每帧采集+编码耗时与帧预算、整机 CPU 占用，
+// 过载时逐级降低帧率、预设和分辨率，余量恢复后逐级回升。只在编码线程中使用
+class EncodeGovernor
+{
+public:
+    struct Level
+    {
+        qreal fpsScale;  // 帧率倍数
+        qreal sizeScale; // 编码尺寸倍数
+        bool fastPreset; // 强制 ultrafast
+    };
+
+    EncodeGovernor();
+
+    // 记录一帧的耗时（微秒）和当前帧预算（毫秒），每秒评估一次
+    // 等级变化时返回 true，原因见 lastDecision()
+    bool addFrame(qint64 costUs, int budgetMs);
+
+    int level() const { return m_level; }
+    const Level& current() const;
+    // 最近一次调整的说明，用于日志
+    const QString& lastDecision() const { return m_lastDecision; }
+
+    void reset();
+
+private:
+    // 整机 CPU 占用（0~1），取不到时返回 -1
+    double sampleCpuLoad();
+
+    int m_level = 0;
+    QString m_lastDecision;
+
+    // 当前评估窗口
+    QElapsedTimer m_window;
+    int m_frames = 0;
+    qint64 m_costSumUs = 0;
+    int m_budgetMs = 0;
+
+    QElapsedTimer m_lastChange;
+    QElapsedTimer m_lastStepUp;
+    QElapsedTimer m_headroomSince;
+    // 回升所需的持续余量时间，回升后很快又过载时加倍，避免来回振荡
+    int m_stepUpHoldMs;
+
+    // 上一次 CPU 采样的累计值
+    quint64 m_lastIdle = 0;
+    quint64 m_lastTotal = 0;
+};
+
+#endif // ENCODEGOVERNOR_H
@@ -0,0 +1,65 @@
+#include "EncoderOptions.h"
+#include <QJsonArray>
+
+EncoderOptions& EncoderOptions::global()
+{
+    static EncoderOptions options;
+    return options;
+}
+
+void EncoderOptions::load(const QJsonObject& obj)
+{
+    const EncoderOptions defaults;
+    sliceMode = obj["sliceMode"].toBool(defaults.sliceMode);
+    sliceCount = qBound(1, obj["sliceCount"].toInt(defaults.sliceCount), 16);
+    gopSize = qMax(1, obj["gopSize"].toInt(defaults.gopSize));
+    keyframeRequestIntervalMs = qMax(0, obj["keyframeRequestIntervalMs"].toInt(defaults.keyframeRequestIntervalMs));
+    intraRefresh = obj["intraRefresh"].toBool(defaults.intraRefresh);
+    intraRefreshPeriod = qMax(2, obj["intraRefreshPeriod"].toInt(defaults.intraRefreshPeriod));
+    damageCapture = obj["damageCapture"].toBool(defaults.damageCapture);
+    maxFps = qBound(1, obj["maxFps"].toInt(defaults.maxFps), 120);
+
+    contentAdaptive = obj["contentAdaptive"].toBool(defaults.contentAdaptive);
+    roiEncoding = obj["roiEncoding"].toBool(defaults.roiEncoding);
+    qualityStats = obj["qualityStats"].toBool(defaults.qualityStats);
+    tiledMode = obj["tiledMode"].toBool(defaults.tiledMode);
+    tileColumns = qBound(1, obj["tileColumns"].toInt(defaults.tileColumns), 8);
+    tileRows = qBound(1, obj["tileRows"].toInt(defaults.tileRows), 8);
+    governor = obj["governor"].toBool(defaults.governor);
+
+    codecs.clear();
+    for (const QJsonValue& value : obj["codecs"].toArray())
+    {
+        QString name = value.toString().trimmed().toLower();
+        if (!name.isEmpty() && !codecs.contains(name))
+        {
+            codecs.append(name);
+        }
+    }
+    if (codecs.isEmpty())
+    {
+        codecs = defaults.codecs;
+    }
+}
+
+QJsonObject EncoderOptions::toJson() const
+{
+    QJsonObject obj;
+    obj["sliceMode"] = sliceMode;
+    obj["sliceCount"] = sliceCount;
+    obj["gopSize"] = gopSize;
+    obj["keyframeRequestIntervalMs"] = keyframeRequestIntervalMs;
+    obj["intraRefresh"] = intraRefresh;
+    obj["intraRefreshPeriod"] = intraRefreshPeriod;
+    obj["damageCapture"] = damageCapture;
+    obj["maxFps"] = maxFps;
+    obj["codecs"] = QJsonArray::fromStringList(codecs);
+    obj["contentAdaptive"] = contentAdaptive;
+    obj["roiEncoding"] = roiEncoding;
+    obj["qualityStats"] = qualityStats;
+    obj["tiledMode"] = tiledMode;
+    obj["tileColumns"] = tileColumns;
+    obj["tileRows"] = tileRows;
+    obj["governor"] = governor;
+    return obj;
+}
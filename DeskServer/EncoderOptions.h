@@ -0,0 +1,59 @@
+#ifndef ENCODEROPTIONS_H
+#define ENCODEROPTIONS_H
+
+#include <QJsonObject>
+#include <QStringList>
+
+// 编码器运行参数，对应 DeskServer.json 中的 "encoder" 节点
+struct EncoderOptions
+{
+    // 低延迟分片模式：每帧编码为多个 slice，每个 slice 单独成包发送
+    bool sliceMode = false;
+    int sliceCount = 4;
+
+    // 关键帧间隔（帧数）。控制端可随时请求关键帧恢复，因此默认取较长的间隔以节省带宽
+    int gopSize = 200;
+    // 两次按需关键帧之间的最小间隔，防止控制端频繁请求导致码率突增
+    int keyframeRequestIntervalMs = 500;
+
+    // 周期帧内刷新：以滚动的帧内编码列代替周期 IDR，使每帧大小保持平稳
+    bool intraRefresh = false;
+    // 一轮刷新覆盖整幅画面所用的帧数
+    int intraRefreshPeriod = 40;
+
+    // 按画面变化触发采集（采集后端支持时），不支持时退回固定帧率轮询
+    bool damageCapture = true;
+    // 变化触发模式下的最高帧率
+    int maxFps = 30;
+
+    // 编码格式优先级（h264 / hevc / vp9 / av1），按控制端上报的解码能力取第一个双方都支持的
+    QStringList codecs = { "h264" };
+
+    // 按屏幕内容（文字 / 运动画面）切换编码配置，见 ContentClassifier
+    // 默认关闭，保持原有的 ultrafast 预设和固定帧率
+    bool contentAdaptive = false;
+
+    // 感兴趣区域编码：鼠标附近和最近变化的区域降低 QP，其余区域提高 QP，总码率不变
+    // 需要 x264 开启自适应量化，增加编码耗时，默认关闭
+    bool roiEncoding = false;
+    // 统计 PSNR（编码器需额外计算，默认关闭），平均 QP 总是统计
+    bool qualityStats = false;
+
+    // 分块编码：采集画面按 tileColumns x tileRows 切分，每块一个编码器并行编码，只编码有变化的块
+    // 用于 4K 或多屏拼接的大画面，按原始分辨率编码，不使用显示区域缩放、内容自适应和感兴趣区域
+    bool tiledMode = false;
+    int tileColumns = 2;
+    int tileRows = 2;
+
+    // 负载调节：采集+编码耗时超出帧预算或整机 CPU 过高时逐级降低帧率、预设和分辨率，见 EncodeGovernor
+    // 默认关闭，保持原有的固定帧率和分辨率
+    bool governor = false;
+
+    // 全局配置，由 DeskServer::loadConfig 在启动时填充
+    static EncoderOptions& global();
+
+    void load(const QJsonObject& obj);
+    QJsonObject toJson() const;
+};
+
+#endif // ENCODEROPTIONS_H
@@ -0,0 +1,79 @@
+#include "EncoderStats.h"
+#include <QtMath>
+
+EncoderStats::EncoderStats(int reportInterval)
+    : m_reportInterval(reportInterval)
+{
+}
+
+void EncoderStats::addFrame(int packetSize, bool keyFrame, qint64 costUs)
+{
+    ++m_frames;
+    if (keyFrame)
+    {
+        ++m_keyFrames;
+    }
+
+    double delta = packetSize - m_sizeMean;
+    m_sizeMean += delta / m_frames;
+    m_sizeM2 += delta * (packetSize - m_sizeMean);
+    m_sizeMax = qMax(m_sizeMax, packetSize);
+
+    m_costSumUs += costUs;
+    m_costMaxUs = qMax(m_costMaxUs, costUs);
+}
+
+void EncoderStats::addQuality(double qp, double psnrY)
+{
+    ++m_qpFrames;
+    m_qpSum += qp;
+    if (psnrY >= 0.0)
+    {
+        m_psnrMin = m_psnrFrames ? qMin(m_psnrMin, psnrY) : psnrY;
+        ++m_psnrFrames;
+        m_psnrSum += psnrY;
+    }
+}
+
+QString EncoderStats::summary(const QString& mode)
+{
+    double stddev = m_frames > 1 ? qSqrt(m_sizeM2 / (m_frames - 1)) : 0.0;
+    QString text = QString("[Encoder-Stats] mode=%1 frames=%2 keyframes=%3 "
+                           "size avg=%4 stddev=%5 max=%6 bytes, cost avg=%7 max=%8 ms")
+                       .arg(mode)
+                       .arg(m_frames)
+                       .arg(m_keyFrames)
+                       .arg(qRound(m_sizeMean))
+                       .arg(qRound(stddev))
+                       .arg(m_sizeMax)
+                       .arg(m_frames ? m_costSumUs / 1000.0 / m_frames : 0.0, 0, 'f', 2)
+                       .arg(m_costMaxUs / 1000.0, 0, 'f', 2);
+    if (m_qpFrames > 0)
+    {
+        text += QString(", qp avg=%1").arg(m_qpSum / m_qpFrames, 0, 'f', 1);
+    }
+    if (m_psnrFrames > 0)
+    {
+        text += QString(", psnr-y avg=%1 min=%2 dB")
+                    .arg(m_psnrSum / m_psnrFrames, 0, 'f', 2)
+                    .arg(m_psnrMin, 0, 'f', 2);
+    }
+    reset();
+    return text;
+}
+
+void EncoderStats::reset()
+{
+    m_frames = 0;
+    m_keyFrames = 0;
+    m_sizeMean = 0.0;
+    m_sizeM2 = 0.0;
+    m_sizeMax = 0;
+    m_costSumUs = 0;
+    m_costMaxUs = 0;
+    m_qpFrames = 0;
+    m_qpSum = 0.0;
+    m_psnrFrames = 0;
+    m_psnrSum = 0.0;
+    m_psnrMin = 0.0;
+}
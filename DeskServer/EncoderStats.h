@@ -0,0 +1,39 @@
+#ifndef ENCODERSTATS_H
+#define ENCODERSTATS_H
+
+#include <QString>
+
+// 编码统计：按窗口累计包大小和每帧耗时，用于对比不同编码模式
+class EncoderStats
+{
+public:
+    explicit EncoderStats(int reportInterval = 100);
+
+    // 记录一帧：包大小（字节）、是否关键帧、采集到出包的耗时（微秒）
+    void addFrame(int packetSize, bool keyFrame, qint64 costUs);
+    // 记录一帧的编码质量：平均 QP，亮度 PSNR（dB，小于 0 表示未统计）
+    void addQuality(double qp, double psnrY);
+
+    // 达到统计窗口时返回 true，调用方取 summary() 输出后自动开始新窗口
+    bool ready() const { return m_frames >= m_reportInterval; }
+    QString summary(const QString& mode);
+    void reset();
+
+private:
+    int m_reportInterval;
+    int m_frames = 0;
+    int m_keyFrames = 0;
+    // Welford 在线方差
+    double m_sizeMean = 0.0;
+    double m_sizeM2 = 0.0;
+    int m_sizeMax = 0;
+    qint64 m_costSumUs = 0;
+    qint64 m_costMaxUs = 0;
+    int m_qpFrames = 0;
+    double m_qpSum = 0.0;
+    int m_psnrFrames = 0;
+    double m_psnrSum = 0.0;
+    double m_psnrMin = 0.0;
+};
+
+#endif // ENCODERSTATS_H
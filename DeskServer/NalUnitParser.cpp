@@ -0,0 +1,69 @@
+#include "NalUnitParser.h"
+
+QList<NalUnit> NalUnitParser::split(const uint8_t* data, int size, bool hevc)
+{
+    QList<NalUnit> units;
+    int start = -1;
+    int i = 0;
+    while (i + 3 <= size)
+    {
+        // 查找起始码 00 00 01
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+        {
+            // 四字节起始码时把前导 0 也算进当前 NAL
+            int codeStart = (i > 0 && data[i - 1] == 0) ? i - 1 : i;
+            if (start >= 0)
+            {
+                units.last().size = codeStart - start;
+            }
+            NalUnit unit;
+            unit.data = data + codeStart;
+            if (i + 3 < size)
+            {
+                unit.type = hevc ? ((data[i + 3] >> 1) & 0x3F) : (data[i + 3] & 0x1F);
+            }
+            units.append(unit);
+            start = codeStart;
+            i += 3;
+            continue;
+        }
+        ++i;
+    }
+    if (start >= 0)
+    {
+        units.last().size = size - start;
+    }
+    return units;
+}
+
+QList<QPair<int, int>> NalUnitParser::splitSlices(const uint8_t* data, int size)
+{
+    QList<QPair<int, int>> chunks;
+    const QList<NalUnit> units = split(data, size);
+
+    int chunkStart = 0;
+    for (int i = 0; i < units.size(); ++i)
+    {
+        if (!isVcl(units[i].type))
+        {
+            continue;
+        }
+        // slice 结束位置：下一个 NAL 的起点，最后一个 slice 吃掉剩余数据
+        int end = (i + 1 < units.size()) ? static_cast<int>(units[i + 1].data - data) : size;
+        chunks.append(qMakePair(chunkStart, end - chunkStart));
+        chunkStart = end;
+    }
+
+    if (chunks.size() < 2)
+    {
+        chunks.clear();
+        chunks.append(qMakePair(0, size));
+        return chunks;
+    }
+    // 末尾如果还有非 VCL 数据，并入最后一块
+    if (chunkStart < size)
+    {
+        chunks.last().second = size - chunks.last().first;
+    }
+    return chunks;
+}
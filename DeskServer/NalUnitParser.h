@@ -0,0 +1,52 @@
+#ifndef NALUNITPARSER_H
+#define NALUNITPARSER_H
+
+#include <QList>
+#include <QPair>
+#include <cstdint>
+
+// 注意：DeskControler/NalUnitParser.h 中有一份同样的拆分逻辑。
+// RendezvousProto 是不依赖 Qt 的纯 protobuf 静态库，以预编译形式从 Depend 引用，
+// 不适合放置基于 QList 的解析代码，因此两端各保留一份；
+// 本端额外提供编码侧的参数集/分片辅助函数，修改 split 或 NAL 类型值时需两边同步。
+
+// Annex B 码流中的一个 NAL 单元（包含起始码）
+struct NalUnit
+{
+    const uint8_t* data = nullptr; // 指向起始码
+    int size = 0;                  // 含起始码的长度
+    int type = 0;                  // nal_unit_type（H264 或 HEVC，取决于 split 的参数）
+};
+
+class NalUnitParser
+{
+public:
+    enum NalType
+    {
+        NalSliceIdr = 5,
+        NalSps = 7,
+        NalPps = 8,
+        // HEVC
+        NalHevcVps = 32,
+        NalHevcSps = 33,
+        NalHevcPps = 34
+    };
+
+    // 按起始码 00 00 01 / 00 00 00 01 切分，不拷贝数据。hevc 为 true 时按 HEVC 的 NAL 头解析类型
+    static QList<NalUnit> split(const uint8_t* data, int size, bool hevc = false);
+
+    // 是否为参数集（H264 SPS/PPS，HEVC VPS/SPS/PPS）
+    static bool isParameterSet(int type, bool hevc)
+    {
+        return hevc ? (type >= NalHevcVps && type <= NalHevcPps) : (type == NalSps || type == NalPps);
+    }
+
+    // 是否为编码图像数据（slice）
+    static bool isVcl(int type) { return type >= 1 && type <= 5; }
+
+    // 将一帧切分为若干块：每个 slice 一块，SPS/PPS/SEI 等前导 NAL 归入紧随其后的 slice
+    // 返回 (偏移, 长度) 列表，不足两个 slice 时返回整帧
+    static QList<QPair<int, int>> splitSlices(const uint8_t* data, int size);
+};
+
+#endif // NALUNITPARSER_H
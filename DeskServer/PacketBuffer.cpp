@@ -0,0 +1,125 @@
+#include "PacketBuffer.h"
+#include <QMutexLocker>
+#include <QtEndian>
+
+PacketBuffer::PacketBuffer(int capacity)
+    : m_storage(HEADROOM + capacity, Qt::Uninitialized), m_capacity(capacity)
+{
+}
+
+void PacketBuffer::reset(int size, int padding)
+{
+    Q_ASSERT(size + padding <= m_capacity);
+    m_head = HEADROOM;
+    m_payloadSize = size;
+    if (padding > 0)
+    {
+        memset(payload() + size, 0, padding);
+    }
+}
+
+bool PacketBuffer::prepend(const void* data, int size)
+{
+    if (size > m_head)
+    {
+        return false;
+    }
+    m_head -= size;
+    memcpy(m_storage.data() + m_head, data, size);
+    return true;
+}
+
+bool PacketBuffer::prependByte(uint8_t value)
+{
+    return prepend(&value, 1);
+}
+
+bool PacketBuffer::prependVarint(quint64 value)
+{
+    uint8_t bytes[10];
+    int count = 0;
+    do
+    {
+        bytes[count] = static_cast<uint8_t>(value & 0x7F);
+        value >>= 7;
+        if (value)
+        {
+            bytes[count] |= 0x80;
+        }
+        ++count;
+    } while (value);
+    return prepend(bytes, count);
+}
+
+bool PacketBuffer::prependBigEndian32(quint32 value)
+{
+    quint32 bigEndian = qToBigEndian(value);
+    return prepend(&bigEndian, sizeof(bigEndian));
+}
+
+PacketBufferPool& PacketBufferPool::instance()
+{
+    static PacketBufferPool pool;
+    return pool;
+}
+
+PacketBufferPool::~PacketBufferPool()
+{
+    qDeleteAll(m_free);
+    m_free.clear();
+}
+
+PacketBufferPtr PacketBufferPool::acquire(int size, int padding)
+{
+    const int needed = size + padding;
+    PacketBuffer* buffer = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (int i = 0; i < m_free.size(); ++i)
+        {
+            if (m_free[i]->capacity() >= needed)
+            {
+                buffer = m_free.takeAt(i);
+                break;
+            }
+        }
+        if (buffer)
+        {
+            ++m_hits;
+        }
+        else
+        {
+            ++m_misses;
+        }
+    }
+
+    if (!buffer)
+    {
+        // 按 16KB 向上取整，同一分辨率下的大部分帧可以复用同一批缓冲
+        const int capacity = (needed + 0x3FFF) & ~0x3FFF;
+        buffer = new PacketBuffer(capacity);
+    }
+    buffer->reset(size, padding);
+
+    return PacketBufferPtr(buffer, [](PacketBuffer* released) {
+        PacketBufferPool::instance().release(released);
+    });
+}
+
+PacketBufferPtr PacketBufferPool::acquireCopy(const void* data, int size)
+{
+    PacketBufferPtr buffer = acquire(size);
+    memcpy(buffer->payload(), data, size);
+    return buffer;
+}
+
+void PacketBufferPool::release(PacketBuffer* buffer)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_free.size() < MAX_FREE_BUFFERS)
+    {
+        m_free.append(buffer);
+        return;
+    }
+    delete buffer;
+}
@@ -0,0 +1,80 @@
+#ifndef PACKETBUFFER_H
+#define PACKETBUFFER_H
+
+#include <QSharedPointer>
+#include <QMutex>
+#include <QList>
+#include <QMetaType>
+#include <QByteArray>
+#include <cstdint>
+
+// 编码数据缓冲：编码器直接写入 payload，发送前在 payload 之前的预留空间就地写入帧头，
+// 从编码器到 RelaySocketWorker 全程不拷贝数据，只传递引用计数指针
+class PacketBuffer
+{
+public:
+    // payload 之前预留的字节数，足够容纳长度头 + RendezvousMessage/InpuVideoFrame 的字段头
+    // 最坏情况：InpuVideoFrame 的 uint32 字段各 6 字节、时间戳各 12 字节，共约 115 字节，再加 16 字节外层帧头
+    static const int HEADROOM = 160;
+
+    explicit PacketBuffer(int capacity);
+
+    // 为 payload 准备 size 字节（之后另有 padding 字节可用），丢弃已写入的帧头
+    void reset(int size, int padding = 0);
+    int capacity() const { return m_capacity; }
+
+    uint8_t* payload() { return m_storage.data() + HEADROOM; }
+    const uint8_t* payload() const { return m_storage.data() + HEADROOM; }
+    int payloadSize() const { return m_payloadSize; }
+    void setPayloadSize(int size) { m_payloadSize = size; }
+
+    // 在当前数据前写入头部，空间不足时返回 false
+    bool prepend(const void* data, int size);
+    bool prependByte(uint8_t value);
+    bool prependVarint(quint64 value);
+    bool prependBigEndian32(quint32 value);
+
+    // 帧头 + payload 的连续数据
+    const char* constData() const { return reinterpret_cast<const char*>(m_storage.data() + m_head); }
+    int size() const { return HEADROOM - m_head + m_payloadSize; }
+
+private:
+    QByteArray m_storage;
+    int m_capacity;
+    int m_head = HEADROOM;
+    int m_payloadSize = 0;
+};
+
+typedef QSharedPointer<PacketBuffer> PacketBufferPtr;
+Q_DECLARE_METATYPE(PacketBufferPtr)
+
+// PacketBuffer 复用池，引用全部释放后缓冲自动回到池中
+class PacketBufferPool
+{
+public:
+    static PacketBufferPool& instance();
+
+    // 取一个至少能容纳 size + padding 字节 payload 的缓冲
+    PacketBufferPtr acquire(int size, int padding = 0);
+    // 取一个缓冲并拷入数据，用于无法由编码器直接写入的小包
+    PacketBufferPtr acquireCopy(const void* data, int size);
+
+    // 复用命中/新分配次数
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+
+private:
+    PacketBufferPool() = default;
+    ~PacketBufferPool();
+    void release(PacketBuffer* buffer);
+
+    // 池中最多保留的空闲缓冲数
+    static const int MAX_FREE_BUFFERS = 32;
+
+    QMutex m_mutex;
+    QList<PacketBuffer*> m_free;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
+
+#endif // PACKETBUFFER_H
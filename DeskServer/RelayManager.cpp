@@ -18,6 +18,11 @@ RelayManager::RelayManager(QObject* parent)
 {
     m_inputSimulator = new RemoteInputSimulator(nullptr);
     m_remoteClipboard = new RemoteClipboard(nullptr);
+
+    // 指针位置和形状单独发送，不依赖视频帧
+    m_cursorMonitor = new CursorMonitor(this);
+    connect(m_cursorMonitor, &CursorMonitor::cursorEventReady, this, &RelayManager::onCursorEventReady);
+    connect(m_cursorMonitor, &CursorMonitor::cursorShapeReady, this, &RelayManager::onCursorShapeReady);
 }
 
 RelayManager::~RelayManager()
@@ -49,14 +54,10 @@ void RelayManager::start(const QHostAddress& relayAddress, quint16 relayPort, co
             .arg(m_relayAddress.toString()).arg(m_relayPort),
         LogWidget::Info);
 
-    m_encoderThread = new QThread(this);
-    m_encoder = new ScreenCaptureEncoder();
-    m_encoder->moveToThread(m_encoderThread);
-    connect(m_encoderThread, &QThread::started, m_encoder, &ScreenCaptureEncoder::startCapture);
+    // 复用常驻编码器，编码器已打开并缓存了 SPS/PPS，中继连通后即可立即出第一帧
+    m_encoder = ScreenCaptureEncoder::shared();
     connect(m_encoder, &ScreenCaptureEncoder::encodedPacketReady, this, &RelayManager::onEncodedPacketReady);
-    connect(m_encoderThread, &QThread::finished, m_encoder, &QObject::deleteLater);
     connect(m_remoteClipboard, &RemoteClipboard::ctrlCPressed, this, &RelayManager::sendClipboardEvent);
-    m_encoderThread->start();
     m_remoteClipboard->start();
 }
 
@@ -96,29 +97,16 @@ void RelayManager::stop()
 {
     LogWidget::instance()->addLog("RelayManager::stop() called", LogWidget::Info);
 
-    // 先停止编码器，避免继续产生数据
+    // 先停止编码器，避免继续产生数据。编码器是常驻的，只停止采集并断开信号，不销毁
     if (m_encoder)
     {
-        // 使用 QueuedConnection 而非 BlockingQueuedConnection，避免死锁
-        if (m_encoderThread && m_encoderThread->isRunning())
-        {
-            QMetaObject::invokeMethod(m_encoder, "stopCapture", Qt::BlockingQueuedConnection);
-        }
-    }
-    if (m_encoderThread)
-    {
-        m_encoderThread->quit();
-        if (!m_encoderThread->wait(3000))  // 最多等待3秒
-        {
-            LogWidget::instance()->addLog("RelayManager: Encoder thread did not stop in time, terminating", LogWidget::Warning);
-            m_encoderThread->terminate();
-            m_encoderThread->wait();
-        }
-        m_encoderThread->deleteLater();
-        m_encoderThread = nullptr;
-        m_encoder = nullptr;  // encoder 会被 deleteLater 自动删除
+        disconnect(m_encoder, nullptr, this, nullptr);
+        QMetaObject::invokeMethod(m_encoder, "stopCapture", Qt::QueuedConnection);
+        m_encoder = nullptr;
     }
 
+    m_cursorMonitor->stop();
+
     // 停止剪贴板监控
     if (m_remoteClipboard)
     {
@@ -178,6 +166,13 @@ void RelayManager::onWorkerSocketConnected()
         QMetaObject::invokeMethod(m_socketWorker, "sendData", Qt::QueuedConnection,
                                   Q_ARG(QByteArray, fullData));
         LogWidget::instance()->addLog(QString("RelayManager: RequestRelay message sent %1").arg(m_uuid), LogWidget::Info);
+
+        // 中继通道建立后立即开始采集，第一帧为强制 IDR
+        if (m_encoder)
+        {
+            QMetaObject::invokeMethod(m_encoder, "startCapture", Qt::QueuedConnection);
+        }
+        m_cursorMonitor->start();
     }
     else
     {
@@ -206,6 +201,8 @@ void RelayManager::onWorkerSocketDisconnected()
         LogWidget::instance()->addLog("RelayManager: Stopped screen encoding due to connection loss", LogWidget::Warning);
     }
 
+    m_cursorMonitor->stop();
+
     // 停止剪贴板监控
     if (m_remoteClipboard)
     {
@@ -239,6 +236,7 @@ void RelayManager::onWorkerDataReceived(const QByteArray& data)
 
 void RelayManager::processReceivedData(const QByteArray& packetData)
 {
+    const qint64 receiveUs = deskClockUs();
     RendezvousMessage msg;
     if (!msg.ParseFromArray(packetData.constData(), packetData.size()))
     {
@@ -249,7 +247,53 @@ void RelayManager::processReceivedData(const QByteArray& packetData)
     if (msg.has_inputcontrolevent())
     {
         const InputControlEvent& event = msg.inputcontrolevent();
-        if (event.has_mouse_event())
+        if (event.has_batch())
+        {
+            // 整批交给注入线程一次注入，鼠标事件只通知编码器最后的位置
+            QList<DeskInputEvent> events;
+            events.reserve(event.batch().events_size());
+            QPoint lastMouse;
+            bool hasMouse = false;
+            for (const InputControlEvent& item : event.batch().events())
+            {
+                DeskInputEvent input;
+                if (item.has_mouse_event())
+                {
+                    input.type = DeskInputEvent::Mouse;
+                    input.x = item.mouse_event().x();
+                    input.y = item.mouse_event().y();
+                    input.mask = item.mouse_event().mask();
+                    input.value = item.mouse_event().value();
+                }
+                else if (item.has_keyboard_event())
+                {
+                    input.type = DeskInputEvent::Keyboard;
+                    input.key = item.keyboard_event().key();
+                    input.pressed = item.keyboard_event().pressed();
+                }
+                else
+                {
+                    continue;
+                }
+                events.append(input);
+                if (input.type == DeskInputEvent::Mouse)
+                {
+                    lastMouse = QPoint(input.x, input.y);
+                    hasMouse = true;
+                }
+            }
+            if (!events.isEmpty())
+            {
+                if (hasMouse && m_encoder)
+                {
+                    QMetaObject::invokeMethod(m_encoder, "setPointerPosition", Qt::QueuedConnection,
+                                              Q_ARG(QPoint, lastMouse));
+                }
+                QMetaObject::invokeMethod(m_inputSimulator, "handleInputBatch", Qt::QueuedConnection,
+                                          Q_ARG(QList<DeskInputEvent>, events));
+            }
+        }
+        else if (event.has_mouse_event())
         {
             const MouseEvent& mouseEvent = event.mouse_event();
             int x = mouseEvent.x();
@@ -258,6 +302,12 @@ void RelayManager::processReceivedData(const QByteArray& packetData)
             int value = mouseEvent.value();
             QMetaObject::invokeMethod(m_inputSimulator, "handleMouseEvent", Qt::QueuedConnection,
                                       Q_ARG(int, x), Q_ARG(int, y), Q_ARG(int, mask), Q_ARG(int, value));
+            if (m_encoder)
+            {
+                // 用户正在操作的位置，编码时优先保证该区域的画质
+                QMetaObject::invokeMethod(m_encoder, "setPointerPosition", Qt::QueuedConnection,
+                                          Q_ARG(QPoint, QPoint(x, y)));
+            }
         }
         else if (event.has_touch_event())
         {
@@ -308,35 +358,120 @@ void RelayManager::processReceivedData(const QByteArray& packetData)
         QMetaObject::invokeMethod(m_remoteClipboard, "onClipboardMessageReceived", Qt::QueuedConnection,
                                   Q_ARG(ClipboardEvent, clipboardEvent));
     }
+    else if (msg.has_time_sync())
+    {
+        // 填入本端收发时刻立即返回，控制端据此估计时钟差
+        RendezvousMessage reply;
+        TimeSync* sync = reply.mutable_time_sync();
+        sync->set_client_send_us(msg.time_sync().client_send_us());
+        sync->set_relay_request_us(msg.relay_time_us());
+        sync->set_server_receive_us(receiveUs);
+        sync->set_server_send_us(deskClockUs());
+        sendMessage(reply);
+    }
+    else if (msg.has_keyframe_request())
+    {
+        if (m_encoder)
+        {
+            QMetaObject::invokeMethod(m_encoder, "requestKeyframe", Qt::QueuedConnection);
+        }
+    }
+    else if (msg.has_viewport_info())
+    {
+        const ViewportInfo& viewport = msg.viewport_info();
+        QRectF crop(viewport.crop_x(), viewport.crop_y(), viewport.crop_width(), viewport.crop_height());
+        if (m_encoder)
+        {
+            QMetaObject::invokeMethod(m_encoder, "setViewport", Qt::QueuedConnection,
+                                      Q_ARG(QSize, QSize(viewport.width(), viewport.height())),
+                                      Q_ARG(QRectF, crop),
+                                      Q_ARG(int, static_cast<int>(viewport.max_fps())));
+        }
+    }
+    else if (msg.has_codec_capabilities())
+    {
+        const CodecCapabilities& capabilities = msg.codec_capabilities();
+        QList<int> decoders;
+        for (int codec : capabilities.decoders())
+        {
+            decoders.append(codec);
+        }
+        if (m_encoder)
+        {
+            QMetaObject::invokeMethod(m_encoder, "setDecoderCapabilities", Qt::QueuedConnection,
+                                      Q_ARG(QList<int>, decoders));
+        }
+    }
     else
     {
         LogWidget::instance()->addLog("Received unknown message type in RendezvousMessage", LogWidget::Warning);
     }
 }
 
-void RelayManager::onEncodedPacketReady(const QByteArray& packet)
+void RelayManager::onEncodedPacketReady(const PacketBufferPtr& packet, const VideoPacketInfo& info)
 {
     if (m_socketWorker)
     {
+        // 只序列化 InpuVideoFrame 中除 data 以外的字段，编码数据不再拷贝进 protobuf
         InpuVideoFrame videoFrame;
-        videoFrame.set_data(packet.data(), packet.size());
-        RendezvousMessage msg;
-        *msg.mutable_inpuvideoframe() = videoFrame;
-        std::string outStr;
-        if (!msg.SerializeToString(&outStr))
+        videoFrame.set_frame_id(info.frameId);
+        videoFrame.set_slice_index(info.sliceIndex);
+        videoFrame.set_slice_count(info.sliceCount);
+        videoFrame.set_key_frame(info.keyFrame);
+        videoFrame.set_codec(static_cast<VideoCodec>(info.codec));
+        videoFrame.set_source_x(info.sourceRect.x());
+        videoFrame.set_source_y(info.sourceRect.y());
+        videoFrame.set_source_width(info.sourceRect.width());
+        videoFrame.set_source_height(info.sourceRect.height());
+        videoFrame.set_screen_width(info.screenSize.width());
+        videoFrame.set_screen_height(info.screenSize.height());
+        if (info.tileCount > 1)
+        {
+            videoFrame.set_tile_id(info.tileId);
+            videoFrame.set_tile_count(info.tileCount);
+            videoFrame.set_last_tile(info.lastTile);
+        }
+        if (info.captureTimeUs > 0)
+        {
+            videoFrame.set_capture_time_us(info.captureTimeUs);
+            videoFrame.set_encode_done_us(info.encodeDoneUs);
+            videoFrame.set_send_time_us(deskClockUs());
+        }
+        std::string metaStr;
+        if (!videoFrame.SerializeToString(&metaStr))
         {
             LogWidget::instance()->addLog("RelayManager: Failed to serialize InpuVideoFrame message", LogWidget::Error);
             return;
         }
-        QByteArray data(outStr.data(), static_cast<int>(outStr.size()));
-        quint32 packetSize = static_cast<quint32>(data.size());
-        quint32 bigEndianSize = qToBigEndian(packetSize);
-        QByteArray header(reinterpret_cast<const char*>(&bigEndianSize), sizeof(bigEndianSize));
-        QByteArray fullData;
-        fullData.append(header);
-        fullData.append(data);
-        QMetaObject::invokeMethod(m_socketWorker, "sendData", Qt::QueuedConnection,
-                                  Q_ARG(QByteArray, fullData));
+
+        // 在 payload 前的预留空间里由内向外写帧头，得到的字节与完整序列化的消息等价：
+        // [长度(4B BE)][RendezvousMessage.inpuVideoFrame 字段头][InpuVideoFrame 其余字段][data 字段头][payload]
+        // protobuf 不要求字段按序号排列，data 放在最后可以让 payload 保持原位
+        const uint8_t lengthDelimited = 2;
+        bool ok = packet->prependVarint(static_cast<quint64>(packet->payloadSize())) &&
+                  packet->prependByte((InpuVideoFrame::kDataFieldNumber << 3) | lengthDelimited) &&
+                  packet->prepend(metaStr.data(), static_cast<int>(metaStr.size()));
+        ok = ok &&
+             packet->prependVarint(static_cast<quint64>(packet->size())) &&
+             packet->prependByte((RendezvousMessage::kInpuVideoFrameFieldNumber << 3) | lengthDelimited);
+        ok = ok && packet->prependBigEndian32(static_cast<quint32>(packet->size()));
+        if (!ok)
+        {
+            // 预留空间不够时退回完整序列化，多一次拷贝但不丢包
+            LogWidget::instance()->addLog(
+                QString("RelayManager: Packet headroom too small for %1 bytes of framing, copying").arg(metaStr.size()),
+                LogWidget::Debug);
+            videoFrame.set_data(packet->payload(), packet->payloadSize());
+            RendezvousMessage msg;
+            *msg.mutable_inpuvideoframe() = videoFrame;
+            if (!sendMessage(msg))
+            {
+                LogWidget::instance()->addLog("RelayManager: Failed to send InpuVideoFrame message", LogWidget::Error);
+            }
+            return;
+        }
+        QMetaObject::invokeMethod(m_socketWorker, "sendPacket", Qt::QueuedConnection,
+                                  Q_ARG(PacketBufferPtr, packet));
     }
     else
     {
@@ -344,6 +479,44 @@ void RelayManager::onEncodedPacketReady(const QByteArray& packet)
     }
 }
 
+bool RelayManager::sendMessage(const RendezvousMessage& msg)
+{
+    if (!m_socketWorker)
+    {
+        return false;
+    }
+    std::string serialized;
+    if (!msg.SerializeToString(&serialized))
+    {
+        return false;
+    }
+    QByteArray fullData;
+    fullData.reserve(static_cast<int>(sizeof(quint32) + serialized.size()));
+    quint32 bigEndianSize = qToBigEndian(static_cast<quint32>(serialized.size()));
+    fullData.append(reinterpret_cast<const char*>(&bigEndianSize), sizeof(bigEndianSize));
+    fullData.append(serialized.data(), static_cast<int>(serialized.size()));
+    QMetaObject::invokeMethod(m_socketWorker, "sendData", Qt::QueuedConnection,
+                              Q_ARG(QByteArray, fullData));
+    return true;
+}
+
+void RelayManager::onCursorEventReady(const CursorEvent& cursorEvent)
+{
+    RendezvousMessage msg;
+    *msg.mutable_cursor_event() = cursorEvent;
+    sendMessage(msg);
+}
+
+void RelayManager::onCursorShapeReady(const CursorShape& cursorShape)
+{
+    RendezvousMessage msg;
+    *msg.mutable_cursor_shape() = cursorShape;
+    if (!sendMessage(msg))
+    {
+        LogWidget::instance()->addLog("RelayManager: Failed to send CursorShape message", LogWidget::Warning);
+    }
+}
+
 void RelayManager::sendClipboardEvent(const ClipboardEvent& clipboardEvent)
 {
     // 组装 ClipboardEvent 消息到 RendezvousMessage 中
@@ -8,6 +8,7 @@
 #include "ScreenCaptureEncoder.h"
 #include "RelaySocketWorker.h"
 #include "RemoteClipboard.h"
+#include "CursorMonitor.h"
 
 class RelayManager : public QObject
 {
@@ -31,11 +32,15 @@ private slots:
 	void onWorkerSocketDisconnected();
 	void onWorkerDataReceived(const QByteArray& data);
 	void onWorkerSocketError(const QString& errMsg);
-	void onEncodedPacketReady(const QByteArray& packet);
+	void onEncodedPacketReady(const PacketBufferPtr& packet, const VideoPacketInfo& info);
 	void sendClipboardEvent(const ClipboardEvent& clipboardEvent);
+	void onCursorEventReady(const CursorEvent& cursorEvent);
+	void onCursorShapeReady(const CursorShape& cursorShape);
 
 private:
 	void processReceivedData(const QByteArray& packetData);
+	// 序列化并加上 4 字节长度头后发送
+	bool sendMessage(const RendezvousMessage& msg);
 
 private:
 	RelaySocketWorker* m_socketWorker;
@@ -47,8 +52,8 @@ private:
 
 	ScreenCaptureEncoder* m_encoder;
 	RemoteInputSimulator* m_inputSimulator;
-	QThread* m_encoderThread;
 	RemoteClipboard* m_remoteClipboard;
+	CursorMonitor* m_cursorMonitor;
 };
 
 #endif // RELAYMANAGER_H
@@ -51,6 +51,15 @@ void RelaySocketWorker::sendData(const QByteArray& data)
     }
 }
 
+void RelaySocketWorker::sendPacket(const PacketBufferPtr& packet)
+{
+    if (packet && m_socket->state() == QAbstractSocket::ConnectedState)
+    {
+        m_socket->write(packet->constData(), packet->size());
+        m_socket->flush();
+    }
+}
+
 void RelaySocketWorker::disconnectSocket()
 {
     if (m_socket)
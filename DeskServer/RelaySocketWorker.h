@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QtNetwork/QTcpSocket>
 #include <QtNetwork/QHostAddress>
+#include "PacketBuffer.h"
 
 class RelaySocketWorker : public QObject
 {
@@ -16,6 +17,8 @@ public:
 public slots:
     void connectToHost(const QHostAddress& address, quint16 port);
     void sendData(const QByteArray& data);
+    // 发送已组好帧头的池化缓冲，直接从缓冲写入 socket
+    void sendPacket(const PacketBufferPtr& packet);
     void disconnectSocket();
 
 private slots:
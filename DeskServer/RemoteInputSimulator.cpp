@@ -7,94 +7,170 @@
 #define POINTER_TOUCH_ID_MAX 33554433
 #define POINTER_TOUCH_SPACE  10
 
+WORD mapIntKeyToVK(int key);
+
 RemoteInputSimulator::RemoteInputSimulator(QObject* parent)
     : QObject(parent)
 {
     m_workerThread = new QThread;
     this->moveToThread(m_workerThread);
     connect(m_workerThread, &QThread::finished, this, &QObject::deleteLater);
-    m_workerThread->start();
-
-    // 在注入前设置最高优先级
-    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
-    SetPriorityClass(GetCurrentProcess(), REALTIME_PRIORITY_CLASS);
+    // 输入注入线程使用最高优先级，保证编码负载高时输入仍能及时响应
+    // 不再把整个进程提升到实时优先级，否则编码线程会抢占系统和其他程序
+    m_workerThread->start(QThread::TimeCriticalPriority);
 
     // 初始化触摸
     InitializeTouchInjection(10, TOUCH_FEEDBACK_DEFAULT);
 }
 
-void RemoteInputSimulator::handleMouseEvent(int x, int y, int mask, int value)
+// 服务端输入坐标换算为 SendInput 的绝对移动（0~65535）
+static INPUT absoluteMoveInput(int x, int y)
 {
-    // --- 添加日志 ---
-    LogWidget::instance()->addLog(
-        QString("[Windows-Input] Executing Mouse: x=%1, y=%2").arg(x).arg(y),
-        LogWidget::Info
-        );
+    x = x * 1.0 / 1920.0 * 2560.0;
+    y = y * 1.0 / 1080.0 * 1440.0;
+    INPUT moveInput = {};
+    moveInput.type = INPUT_MOUSE;
+    moveInput.mi.dx = (65535 * x) / GetSystemMetrics(SM_CXSCREEN);
+    moveInput.mi.dy = (65535 * y) / GetSystemMetrics(SM_CYSCREEN);
+    moveInput.mi.dwFlags = MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_MOVE;
+    return moveInput;
+}
 
-    LogWidget::instance()->addLog("handleMouseEvent------"+QString::number(x), LogWidget::Debug);
+// 服务端按键（ControlKey 枚举值）转换为 SendInput 的键盘事件，未映射的按键返回 false
+static bool keyboardInput(int key, bool pressed, INPUT& input)
+{
+    WORD vk = mapIntKeyToVK(key);
+    if (vk == 0)
+    {
+        LogWidget::instance()->addLog("Unmapped key received in RemoteInputSimulator", LogWidget::Warning);
+        return false;
+    }
+    input = {};
+    input.type = INPUT_KEYBOARD;
+    input.ki.wVk = vk;
+    input.ki.dwFlags = pressed ? 0 : KEYEVENTF_KEYUP;
+    return true;
+}
 
+void RemoteInputSimulator::activateForegroundWindow(const char* caller)
+{
     // 获取当前前台窗口,并尝试激活
     HWND targetHwnd = GetForegroundWindow();
     if (targetHwnd)
     {
         if (!SetForegroundWindow(targetHwnd))
         {
-            LogWidget::instance()->addLog("Failed to set foreground window in handleMouseEvent", LogWidget::Warning);
+            LogWidget::instance()->addLog(QString("Failed to set foreground window in %1").arg(caller), LogWidget::Warning);
         }
     }
     else
     {
-        LogWidget::instance()->addLog("No foreground window found in handleMouseEvent", LogWidget::Warning);
+        LogWidget::instance()->addLog(QString("No foreground window found in %1").arg(caller), LogWidget::Warning);
     }
+}
 
-    // 计算屏幕归一化坐标(SendInput 要求 0~65535)
-    x = x * 1.0 / 1920.0 * 2560.0;
-    y = y * 1.0 / 1080.0 * 1440.0;
-    int screenX = (65535 * x) / GetSystemMetrics(SM_CXSCREEN);
-    int screenY = (65535 * y) / GetSystemMetrics(SM_CYSCREEN);
-
-    //LogWidget::instance()->addLog("screenX------"+QString::number(screenX), LogWidget::Warning);
-    //LogWidget::instance()->addLog("screenY------"+QString::number(screenY), LogWidget::Warning);
-    //LogWidget::instance()->addLog("value------"+QString::number(value), LogWidget::Warning);
+void RemoteInputSimulator::handleMouseEvent(int x, int y, int mask, int value)
+{
+    // 控制端会持续发送悬停移动，只为按键类事件输出日志
+    if (mask != MouseMove)
+    {
+        LogWidget::instance()->addLog(
+            QString("[Windows-Input] Executing Mouse: x=%1, y=%2, mask=%3").arg(x).arg(y).arg(mask),
+            LogWidget::Info
+            );
+    }
 
-    // 定义鼠标移动事件
-    INPUT moveInput = {};
-    moveInput.type = INPUT_MOUSE;
-    moveInput.mi.dx = screenX;
-    moveInput.mi.dy = screenY;
-    moveInput.mi.dwFlags = MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_MOVE;
+    activateForegroundWindow("handleMouseEvent");
 
     // 如果需要双击，则采用 QTimer 延时处理避免阻塞
     if (mask & MouseDoubleClick)
     {
-        // 构造一次左键点击（按下和释放）
-        INPUT leftDown = {};
-        leftDown.type = INPUT_MOUSE;
-        leftDown.mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
-        INPUT leftUp = {};
-        leftUp.type = INPUT_MOUSE;
-        leftUp.mi.dwFlags = MOUSEEVENTF_LEFTUP;
-
-        // 第一组事件：鼠标移动 + 左键点击
-        std::vector<INPUT> firstInputs;
-        firstInputs.push_back(moveInput);
-        firstInputs.push_back(leftDown);
-        firstInputs.push_back(leftUp);
-        SendInput(static_cast<UINT>(firstInputs.size()), firstInputs.data(), sizeof(INPUT));
-
-        // 延时 50 毫秒后再发送一次点击
-        QTimer::singleShot(50, [=]() {
-            std::vector<INPUT> secondInputs;
-            secondInputs.push_back(moveInput);
-            secondInputs.push_back(leftDown);
-            secondInputs.push_back(leftUp);
-            SendInput(static_cast<UINT>(secondInputs.size()), secondInputs.data(), sizeof(INPUT));
-        });
+        injectDoubleClick(x, y);
         return;
     }
 
-    // 构造其它鼠标事件
     std::vector<INPUT> inputs;
+    appendMouseInputs(x, y, mask, value, inputs);
+    if (!inputs.empty())
+    {
+        SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
+    }
+}
+
+void RemoteInputSimulator::handleInputBatch(QList<DeskInputEvent> events)
+{
+    activateForegroundWindow("handleInputBatch");
+
+    std::vector<INPUT> inputs;
+    inputs.reserve(events.size() * 2);
+    for (const DeskInputEvent& event : events)
+    {
+        if (event.type == DeskInputEvent::Keyboard)
+        {
+            INPUT input;
+            if (keyboardInput(event.key, event.pressed, input))
+            {
+                inputs.push_back(input);
+            }
+        }
+        else if (event.mask & MouseDoubleClick)
+        {
+            // 双击的第二次点击需要延时，先注入之前累积的事件保证顺序
+            if (!inputs.empty())
+            {
+                SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
+                inputs.clear();
+            }
+            injectDoubleClick(event.x, event.y);
+        }
+        else
+        {
+            appendMouseInputs(event.x, event.y, event.mask, event.value, inputs);
+        }
+    }
+
+    if (!inputs.empty())
+    {
+        UINT sent = SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
+        if (sent != inputs.size())
+        {
+            LogWidget::instance()->addLog(QString("SendInput injected %1 of %2 events in handleInputBatch")
+                                              .arg(sent).arg(inputs.size()), LogWidget::Warning);
+        }
+    }
+}
+
+void RemoteInputSimulator::injectDoubleClick(int x, int y)
+{
+    INPUT moveInput = absoluteMoveInput(x, y);
+    // 构造一次左键点击（按下和释放）
+    INPUT leftDown = {};
+    leftDown.type = INPUT_MOUSE;
+    leftDown.mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
+    INPUT leftUp = {};
+    leftUp.type = INPUT_MOUSE;
+    leftUp.mi.dwFlags = MOUSEEVENTF_LEFTUP;
+
+    // 第一组事件：鼠标移动 + 左键点击
+    std::vector<INPUT> firstInputs;
+    firstInputs.push_back(moveInput);
+    firstInputs.push_back(leftDown);
+    firstInputs.push_back(leftUp);
+    SendInput(static_cast<UINT>(firstInputs.size()), firstInputs.data(), sizeof(INPUT));
+
+    // 延时 50 毫秒后再发送一次点击
+    QTimer::singleShot(50, [=]() {
+        std::vector<INPUT> secondInputs;
+        secondInputs.push_back(moveInput);
+        secondInputs.push_back(leftDown);
+        secondInputs.push_back(leftUp);
+        SendInput(static_cast<UINT>(secondInputs.size()), secondInputs.data(), sizeof(INPUT));
+    });
+}
+
+void RemoteInputSimulator::appendMouseInputs(int x, int y, int mask, int value, std::vector<INPUT>& inputs)
+{
+    INPUT moveInput = absoluteMoveInput(x, y);
     inputs.push_back(moveInput);  // 始终发送鼠标移动事件
 
     if (mask & MouseLeftDown)
@@ -138,18 +214,13 @@ void RemoteInputSimulator::handleMouseEvent(int x, int y, int mask, int value)
         LogWidget::instance()->addLog("MouseWheel------"+QString::number(x)+QString::number(y), LogWidget::Warning);
         INPUT wheel = {0};
         wheel.type = INPUT_MOUSE;
-        wheel.mi.dx = screenX;
-        wheel.mi.dy = screenY;
+        wheel.mi.dx = moveInput.mi.dx;
+        wheel.mi.dy = moveInput.mi.dy;
         wheel.mi.dwFlags = MOUSEEVENTF_WHEEL;
         wheel.mi.mouseData = value;
 
         inputs.push_back(wheel);
     }
-
-    if (!inputs.empty())
-    {
-        SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
-    }
 }
 
 void RemoteInputSimulator::handleTouchEvent(int timestamp, QList<DeskTouchPoint> points)
@@ -332,17 +403,11 @@ void RemoteInputSimulator::handleKeyboardEvent(int protoKey, bool pressed)
     }
 
     // 将 protoKey 转换为 proto 枚举类型（ControlKey）
-    WORD vk = mapIntKeyToVK(protoKey);
-    if (vk == 0) {
-        LogWidget::instance()->addLog("Unmapped key received in RemoteInputSimulator", LogWidget::Warning);
+    INPUT input;
+    if (!keyboardInput(protoKey, pressed, input)) {
         return;
     }
 
-    INPUT input = { 0 };
-    input.type = INPUT_KEYBOARD;
-    input.ki.wVk = vk;
-    input.ki.dwFlags = pressed ? 0 : KEYEVENTF_KEYUP;
-
     UINT sent = SendInput(1, &input, sizeof(INPUT));
     if (sent != 1) {
         LogWidget::instance()->addLog("SendInput failed in handleKeyboardEvent", LogWidget::Warning);
@@ -3,6 +3,7 @@
 #include <QObject>
 #include <Windows.h>
 #include <QThread>
+#include <vector>
 
 #include "rendezvous.pb.h"
 
@@ -19,7 +20,16 @@ public slots:
     void handleMouseEvent(int x, int y, int mask, int value);
     void handleTouchEvent(int timestamp, QList<DeskTouchPoint> points);
     void handleKeyboardEvent(int key, bool pressed);
+    // 一批鼠标和键盘事件合并为一次 SendInput，批内顺序不变
+    void handleInputBatch(QList<DeskInputEvent> events);
 
 private:
+    // 激活前台窗口，每次注入前调用一次
+    void activateForegroundWindow(const char* caller);
+    // 把一条鼠标事件（不含双击）转换为 INPUT 追加到 inputs
+    void appendMouseInputs(int x, int y, int mask, int value, std::vector<INPUT>& inputs);
+    // 双击：先注入一次点击，50 毫秒后再注入一次
+    void injectDoubleClick(int x, int y);
+
     QThread* m_workerThread = nullptr;
 };
@@ -1,21 +1,76 @@
 #include "ScreenCaptureEncoder.h"
 #include "LogWidget.h"
+#include "EncoderOptions.h"
+#include "NalUnitParser.h"
+#include "PacketBuffer.h"
+#include "CaptureBackend.h"
+#include "VideoCodecProfile.h"
 
 #include <QElapsedTimer>
+#include <QThread>
+#include <QSocketNotifier>
+#include <QThreadPool>
 #include <QDebug>
 #include <QBuffer>
 #include <QImageWriter>
+#include <QtMath>
+#include <cstring>
+#include <cmath>
+
+extern "C" {
+#include <libavutil/intreadwrite.h>
+}
 
 #define FIXED_W 1920
 #define FIXED_H 1080
 #define FRAME_FPS 20
+// 感兴趣区域：鼠标周围的半径（编码画面像素），鼠标静止超过该时间后不再作为焦点
+#define ROI_POINTER_RADIUS 160
+#define ROI_POINTER_TIMEOUT_MS 3000
+// 变化区域超过该数量或面积比例时视为整屏变化，不再单独标记
+#define ROI_MAX_DIRTY_RECTS 24
+#define ROI_MAX_DIRTY_RATIO 0.3
+
+
+ScreenCaptureEncoder* ScreenCaptureEncoder::s_shared = nullptr;
+QThread* ScreenCaptureEncoder::s_sharedThread = nullptr;
 
-#include "DXGIManager.h"
-DXGIManager* m_pDXGIManager = Q_NULLPTR;
+ScreenCaptureEncoder* ScreenCaptureEncoder::shared()
+{
+    if (!s_shared)
+    {
+        s_sharedThread = new QThread;
+        s_shared = new ScreenCaptureEncoder();
+        s_shared->moveToThread(s_sharedThread);
+        connect(s_sharedThread, &QThread::finished, s_shared, &QObject::deleteLater);
+        // 采集编码线程低于输入注入线程，CPU 紧张时优先保证输入
+        s_sharedThread->start(QThread::LowPriority);
+        QMetaObject::invokeMethod(s_shared, "warmUp", Qt::QueuedConnection);
+    }
+    return s_shared;
+}
+
+void ScreenCaptureEncoder::releaseShared()
+{
+    if (!s_shared)
+    {
+        return;
+    }
+    QMetaObject::invokeMethod(s_shared, "stopCapture", Qt::BlockingQueuedConnection);
+    s_sharedThread->quit();
+    if (!s_sharedThread->wait(3000))
+    {
+        LogWidget::instance()->addLog("ScreenCaptureEncoder: Encoder thread did not stop in time, terminating", LogWidget::Warning);
+        s_sharedThread->terminate();
+        s_sharedThread->wait();
+    }
+    delete s_sharedThread;
+    s_sharedThread = nullptr;
+    s_shared = nullptr;  // encoder 在线程结束时由 deleteLater 删除
+}
 
 ScreenCaptureEncoder::ScreenCaptureEncoder(QObject* parent)
-    : QObject(parent), codec(nullptr), codecCtx(nullptr), frame(nullptr),
-    swsCtx(nullptr), frameCounter(0)
+    : QObject(parent), codec(nullptr), m_profile(VideoCodecProfile::defaultProfile()), frameCounter(0)
 {
     QSize screenSize = getFixedSize();
     if (screenSize.isEmpty())
@@ -23,262 +78,733 @@ ScreenCaptureEncoder::ScreenCaptureEncoder(QObject* parent)
         LogWidget::instance()->addLog("No primary screen found!", LogWidget::Error);
     }
 
-    // 查找 H264 编码器
-    codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    // 会话开始时总是 H264，控制端上报解码能力后由 setDecoderCapabilities 切换
+    codec = m_profile->findEncoder();
     if (!codec)
     {
         LogWidget::instance()->addLog("H264 codec not found", LogWidget::Error);
     }
 
-    // 分配编码上下文
-    codecCtx = avcodec_alloc_context3(codec);
-    if (!codecCtx)
+    // 创建当前分辨率的编码管线
+    switchPipeline(screenSize);
+
+    m_packet = av_packet_alloc();
+
+    initCapture();
+
+    // MOD: 调整定时器间隔，匹配20fps（50ms每帧）
+    timer = new QTimer(this);
+    connect(timer, &QTimer::timeout, this, &ScreenCaptureEncoder::captureAndEncode);
+
+    // 变化触发采集：采集后端有变化通知时安排采集，两次采集之间至少间隔 1000 / maxFps 毫秒
+    m_captureCapTimer = new QTimer(this);
+    m_captureCapTimer->setSingleShot(true);
+    connect(m_captureCapTimer, &QTimer::timeout, this, &ScreenCaptureEncoder::captureDamaged);
+    if (m_capture && m_capture->supportsDamage() && EncoderOptions::global().damageCapture)
     {
-        LogWidget::instance()->addLog("Could not allocate video codec context", LogWidget::Error);
+        m_damageNotifier = new QSocketNotifier(m_capture->damageHandle(), QSocketNotifier::Read, this);
+        m_damageNotifier->setEnabled(false);
+        connect(m_damageNotifier, &QSocketNotifier::activated, this, &ScreenCaptureEncoder::scheduleCapture);
     }
+}
 
-    // MOD: 降低比特率，从原来的 width*height*4 调整为 width*height*2
-    //codecCtx->bit_rate = screenSize.width() * screenSize.height() * 1.5;
-    codecCtx->bit_rate = 2400000;
-    // 设置最大和最小码率，防止码率突发导致网络拥塞
-    //codecCtx->rc_min_rate = codecCtx->bit_rate;
-    codecCtx->rc_max_rate = 2400000;
-    //codecCtx->rc_buffer_size = (int)codecCtx->bit_rate;
-    codecCtx->rc_buffer_size = 2400000;
+ScreenCaptureEncoder::~ScreenCaptureEncoder()
+{
+    if (timer)
+    {
+        timer->stop();
+    }
+    freeTiles();
+    for (EncoderPipeline* pipeline : m_pipelines)
+    {
+        freePipeline(pipeline);
+    }
+    m_pipelines.clear();
+    m_pipeline = nullptr;
+    if (m_packet)
+    {
+        av_packet_free(&m_packet);
+    }
 
-    codecCtx->width = screenSize.width();
-    codecCtx->height = screenSize.height();
+    delete m_capture;
+    m_capture = nullptr;
+}
 
-    // 强制单线程编码，降低编码延迟
-    codecCtx->thread_count = 1;
+ScreenCaptureEncoder::EncoderPipeline* ScreenCaptureEncoder::createPipeline(const QSize& size)
+{
+    EncoderPipeline* pipeline = new EncoderPipeline;
+    pipeline->size = size;
+    pipeline->content = m_contentType;
+    pipeline->fastPreset = governorFastPreset();
 
-    // MOD: 降低帧率到20fps（原来30fps）
-    codecCtx->time_base = AVRational{ 1, FRAME_FPS };
-    codecCtx->framerate = AVRational{ FRAME_FPS, 1 };
-    codecCtx->gop_size = 40;
-    codecCtx->max_b_frames = 0;
-    codecCtx->pix_fmt = AV_PIX_FMT_YUV420P;
+    // 分配编码上下文
+    pipeline->codecCtx = avcodec_alloc_context3(codec);
+    if (!pipeline->codecCtx)
+    {
+        LogWidget::instance()->addLog("Could not allocate video codec context", LogWidget::Error);
+        freePipeline(pipeline);
+        return nullptr;
+    }
 
-    // 设置低延迟预设和零延迟调优
-    av_opt_set(codecCtx->priv_data, "preset", "ultrafast", 0);
-    // MOD: 增加零延迟调优选项
-    av_opt_set(codecCtx->priv_data, "tune", "zerolatency", 0);
+    setupCodecContext(pipeline->codecCtx, size.width(), size.height());
+    pipeline->fps = pipeline->codecCtx->framerate.num;
 
     // 打开编码器
-    if (avcodec_open2(codecCtx, codec, nullptr) < 0)
+    if (avcodec_open2(pipeline->codecCtx, codec, nullptr) < 0)
     {
         LogWidget::instance()->addLog("Could not open codec", LogWidget::Error);
+        freePipeline(pipeline);
+        return nullptr;
     }
 
     // 分配视频帧
-    frame = av_frame_alloc();
-    if (!frame)
+    pipeline->frame = av_frame_alloc();
+    if (!pipeline->frame)
     {
         LogWidget::instance()->addLog("Could not allocate video frame", LogWidget::Error);
+        freePipeline(pipeline);
+        return nullptr;
     }
-    frame->format = codecCtx->pix_fmt;
-    frame->width = codecCtx->width;
-    frame->height = codecCtx->height;
+    pipeline->frame->format = pipeline->codecCtx->pix_fmt;
+    pipeline->frame->width = pipeline->codecCtx->width;
+    pipeline->frame->height = pipeline->codecCtx->height;
 
     // 分配帧缓冲区
-    int ret = av_image_alloc(frame->data, frame->linesize, codecCtx->width, codecCtx->height,
-                             codecCtx->pix_fmt, 32);
+    int ret = av_image_alloc(pipeline->frame->data, pipeline->frame->linesize,
+                             pipeline->codecCtx->width, pipeline->codecCtx->height,
+                             pipeline->codecCtx->pix_fmt, 32);
     if (ret < 0)
     {
         LogWidget::instance()->addLog("Could not allocate raw picture buffer", LogWidget::Error);
+        freePipeline(pipeline);
+        return nullptr;
     }
 
-    // 初始化转换上下文，从 QImage 的 BGRA 转换为 YUV420P
-    swsCtx = sws_getContext(codecCtx->width, codecCtx->height, AV_PIX_FMT_BGRA,
-                            codecCtx->width, codecCtx->height, codecCtx->pix_fmt,
-                            SWS_BILINEAR, nullptr, nullptr, nullptr);
-    if (!swsCtx)
+    // 转换上下文依赖采集尺寸，在第一次编码时按实际采集图像创建
+    return pipeline;
+}
+
+void ScreenCaptureEncoder::freePipeline(EncoderPipeline* pipeline)
+{
+    if (!pipeline)
     {
-        LogWidget::instance()->addLog("Could not initialize the conversion context", LogWidget::Error);
+        return;
     }
-
-    initDXGIManager();
-
-    // MOD: 调整定时器间隔，匹配20fps（50ms每帧）
-    timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, &ScreenCaptureEncoder::captureAndEncode);
+    if (pipeline->swsCtx)
+    {
+        sws_freeContext(pipeline->swsCtx);
+    }
+    if (pipeline->frame)
+    {
+        av_freep(&pipeline->frame->data[0]);
+        av_frame_free(&pipeline->frame);
+    }
+    if (pipeline->codecCtx)
+    {
+        avcodec_free_context(&pipeline->codecCtx);
+    }
+    delete pipeline;
 }
 
-ScreenCaptureEncoder::~ScreenCaptureEncoder()
+ScreenCaptureEncoder::EncoderPipeline* ScreenCaptureEncoder::findPipeline(const QSize& size) const
 {
-    if (timer)
+    for (EncoderPipeline* pipeline : m_pipelines)
     {
-        timer->stop();
+        if (pipeline->size == size && pipeline->content == m_contentType &&
+            pipeline->fastPreset == governorFastPreset() && pipeline->fps == frameRate())
+        {
+            return pipeline;
+        }
     }
-    if (swsCtx)
+    return nullptr;
+}
+
+// 分辨率变化时切换编码管线，已缓存的管线直接复用，定时器不停止
+bool ScreenCaptureEncoder::switchPipeline(const QSize& size)
+{
+    QElapsedTimer switchTimer;
+    switchTimer.start();
+
+    EncoderPipeline* pipeline = findPipeline(size);
+    const bool cached = (pipeline != nullptr);
+    if (!pipeline)
     {
-        sws_freeContext(swsCtx);
+        pipeline = createPipeline(size);
+        if (!pipeline)
+        {
+            return false;
+        }
     }
-    if (frame)
+
+    // 最近使用的排在最前，超出上限时淘汰最久未用的
+    m_pipelines.removeOne(pipeline);
+    m_pipelines.prepend(pipeline);
+    while (m_pipelines.size() > MAX_PIPELINES)
     {
-        av_freep(&frame->data[0]);
-        av_frame_free(&frame);
+        freePipeline(m_pipelines.takeLast());
     }
-    if (codecCtx)
+
+    const bool initial = (m_pipeline == nullptr);
+    m_pipeline = pipeline;
+    if (initial)
     {
-        avcodec_free_context(&codecCtx);
+        return true;
     }
 
-    unitDXGIManager();
+    // 控制端没有新尺寸下的参考帧，新管线的第一帧必须是 IDR，不受请求限流约束
+    m_keyframeRequested = true;
+    m_lastForcedKeyframe.invalidate();
+
+    LogWidget::instance()->addLog(
+        QString("ScreenCaptureEncoder: Switched to %1x%2 %3 pipeline (%4) in %5 ms")
+            .arg(size.width())
+            .arg(size.height())
+            .arg(ContentClassifier::profile(m_contentType).name)
+            .arg(cached ? "cached" : "new")
+            .arg(switchTimer.elapsed()),
+        LogWidget::Info);
+    return true;
 }
 
-void ScreenCaptureEncoder::startCapture()
+void ScreenCaptureEncoder::setPointerPosition(const QPoint& pos)
 {
-    // MOD: 使用定时器触发间隔以实现帧率 FRAME_FPS
-    timer->start(1000 / FRAME_FPS);
+    m_pointerPos = pos;
+    m_pointerUpdated.start();
 }
 
-// 当检测到屏幕分辨率变化时，重新初始化编码器
-void ScreenCaptureEncoder::reinitializeEncoder(int newWidth, int newHeight)
+void ScreenCaptureEncoder::attachRegionsOfInterest(AVFrame* frame, const QRect& sourceRect, const QSize& captureSize)
 {
-    // 停止定时器，防止并发访问
-    timer->stop();
+    // frame 在管线内复用，先去掉上一帧的区域
+    av_frame_remove_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+    if (!EncoderOptions::global().roiEncoding || sourceRect.isEmpty() || captureSize.isEmpty())
+    {
+        return;
+    }
 
-    // 释放之前的资源
-    if (swsCtx)
+    const QRect frameRect(0, 0, frame->width, frame->height);
+    // 采集像素到编码像素的比例
+    const double sx = static_cast<double>(frame->width) / sourceRect.width();
+    const double sy = static_cast<double>(frame->height) / sourceRect.height();
+    // 按优先级排列：鼠标区域、变化区域，最后整帧提高 QP。重叠时排在前面的生效
+    QList<QPair<QRect, AVRational>> regions;
+    if (m_pointerUpdated.isValid() && m_pointerUpdated.elapsed() < ROI_POINTER_TIMEOUT_MS)
     {
-        sws_freeContext(swsCtx);
-        swsCtx = nullptr;
+        // 参考坐标 -> 采集像素 -> 编码画面
+        const QSize reference = captureSize.width() >= captureSize.height() ? QSize(FIXED_W, FIXED_H) : QSize(FIXED_H, FIXED_W);
+        const int px = qRound((m_pointerPos.x() * static_cast<double>(captureSize.width()) / reference.width() - sourceRect.x()) * sx);
+        const int py = qRound((m_pointerPos.y() * static_cast<double>(captureSize.height()) / reference.height() - sourceRect.y()) * sy);
+        QRect pointerRect(px - ROI_POINTER_RADIUS, py - ROI_POINTER_RADIUS,
+                          ROI_POINTER_RADIUS * 2, ROI_POINTER_RADIUS * 2);
+        pointerRect = pointerRect.intersected(frameRect);
+        if (!pointerRect.isEmpty())
+        {
+            regions.append(qMakePair(pointerRect, av_make_q(-1, 8)));
+        }
     }
-    if (frame)
+
+    // 变化区域按采集坐标给出，换算到编码画面
+    const QList<QRect>& dirtyRects = m_classifier.changedRects();
+    if (!dirtyRects.isEmpty() && dirtyRects.size() <= ROI_MAX_DIRTY_RECTS &&
+        m_classifier.dirtyRatio() < ROI_MAX_DIRTY_RATIO)
     {
-        av_freep(&frame->data[0]);
-        av_frame_free(&frame);
-        frame = nullptr;
+        for (const QRect& rect : dirtyRects)
+        {
+            QRect scaled(qFloor((rect.x() - sourceRect.x()) * sx), qFloor((rect.y() - sourceRect.y()) * sy),
+                         qCeil(rect.width() * sx), qCeil(rect.height() * sy));
+            scaled = scaled.intersected(frameRect);
+            if (!scaled.isEmpty())
+            {
+                regions.append(qMakePair(scaled, av_make_q(-1, 16)));
+            }
+        }
     }
-    if (codecCtx)
+
+    if (regions.isEmpty())
     {
-        avcodec_free_context(&codecCtx);
-        codecCtx = nullptr;
+        // 没有焦点区域时整帧均匀分配
+        return;
     }
+    regions.append(qMakePair(frameRect, av_make_q(1, 10)));
 
-    // 重新分配编码上下文
-    codecCtx = avcodec_alloc_context3(codec);
-    if (!codecCtx)
+    AVFrameSideData* sideData = av_frame_new_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST,
+                                                       regions.size() * sizeof(AVRegionOfInterest));
+    if (!sideData)
     {
-        LogWidget::instance()->addLog("Could not allocate video codec context", LogWidget::Error);
+        return;
     }
+    AVRegionOfInterest* roi = reinterpret_cast<AVRegionOfInterest*>(sideData->data);
+    for (int i = 0; i < regions.size(); ++i)
+    {
+        const QRect& rect = regions[i].first;
+        roi[i].self_size = sizeof(AVRegionOfInterest);
+        roi[i].top = rect.top();
+        roi[i].bottom = rect.top() + rect.height();
+        roi[i].left = rect.left();
+        roi[i].right = rect.left() + rect.width();
+        roi[i].qoffset = regions[i].second;
+    }
+}
 
-    // MOD: 使用新的分辨率和调优参数（保持原分辨率不变）
-    QSize newSize(newWidth, newHeight);
-    // codecCtx->bit_rate = newSize.width() * newSize.height() * 2; // MOD: bit_rate调整
-    // codecCtx->width = newSize.width();
-    // codecCtx->height = newSize.height();
-    // codecCtx->time_base = AVRational{ 1, FRAME_FPS }; // MOD: 20fps
-    // codecCtx->framerate = AVRational{ FRAME_FPS, 1 };
-    // codecCtx->gop_size = 10;
-    // codecCtx->max_b_frames = 1;
-    // codecCtx->pix_fmt = AV_PIX_FMT_YUV420P;
-    // codecCtx->bit_rate = (int64_t)(newSize.width() * newSize.height() * 1.5);
-    // codecCtx->rc_min_rate = codecCtx->bit_rate;
-    // codecCtx->rc_max_rate = codecCtx->bit_rate;
-    // codecCtx->rc_buffer_size = (int)codecCtx->bit_rate;
-    //codecCtx->bit_rate = screenSize.width() * screenSize.height() * 1.5;
-    codecCtx->bit_rate = 2400000;
+void ScreenCaptureEncoder::collectQualityStats(const AVPacket* pkt, const AVCodecContext* ctx)
+{
+    // 布局：quality(32) pict_type(8) error_count(8) 保留(16) error[error_count](64)
+    size_t size = 0;
+    const uint8_t* data = av_packet_get_side_data(pkt, AV_PKT_DATA_QUALITY_STATS, &size);
+    if (!data || size < 8)
+    {
+        return;
+    }
+    const double qp = static_cast<double>(AV_RL32(data)) / FF_QP2LAMBDA;
+    double psnrY = -1.0;
+    const int errorCount = data[5];
+    if (errorCount > 0 && size >= 16)
+    {
+        const quint64 error = AV_RL64(data + 8);
+        const double pixels = static_cast<double>(ctx->width) * ctx->height;
+        psnrY = error > 0 ? 10.0 * std::log10(255.0 * 255.0 * pixels / error) : 99.0;
+    }
+    m_stats.addQuality(qp, psnrY);
+}
+
+void ScreenCaptureEncoder::setTargetSize(const QSize& size)
+{
+    // x264 要求宽高为偶数
+    m_targetSize = size.isValid() ? QSize(size.width() & ~1, size.height() & ~1) : QSize();
+}
+
+// 设置编码参数，每个分辨率的编码管线共用
+void ScreenCaptureEncoder::setupCodecContext(AVCodecContext* ctx, int width, int height)
+{
+    const EncoderOptions& options = EncoderOptions::global();
+    // slice 拆包只对 H264 实现
+    const bool sliceMode = options.sliceMode && !options.tiledMode && m_profile->codec == VIDEO_CODEC_H264;
+    const ContentProfile& content = ContentClassifier::profile(m_contentType);
+    // 分块模式不做内容分类，与 frameRate() 一致不使用内容配置
+    const bool contentAdaptive = options.contentAdaptive && !options.tiledMode;
+
+    // MOD: 降低比特率，从原来的 width*height*4 调整为 width*height*2
+    //codecCtx->bit_rate = width * height * 1.5;
+    ctx->bit_rate = 2400000;
     // 设置最大和最小码率，防止码率突发导致网络拥塞
     //codecCtx->rc_min_rate = codecCtx->bit_rate;
-    codecCtx->rc_max_rate = 2400000;
+    ctx->rc_max_rate = 2400000;
     //codecCtx->rc_buffer_size = (int)codecCtx->bit_rate;
-    codecCtx->rc_buffer_size = 2400000;
+    ctx->rc_buffer_size = 2400000;
+
+    ctx->width = width;
+    ctx->height = height;
+
+    if (sliceMode)
+    {
+        // 分片模式：每帧切成多个 slice，由 x264 的 sliced threads 并行编码，
+        // 输出后按 slice 逐个发送，控制端收到即可开始解码
+        ctx->slices = options.sliceCount;
+        ctx->thread_type = FF_THREAD_SLICE;
+        ctx->thread_count = options.sliceCount;
+    }
+    else
+    {
+        // 强制单线程编码，降低编码延迟
+        ctx->thread_count = 1;
+    }
 
-    codecCtx->width = newSize.width();
-    codecCtx->height = newSize.height();
-    codecCtx->time_base = AVRational{ 1, FRAME_FPS }; // MOD: 20fps
-    codecCtx->framerate = AVRational{ FRAME_FPS, 1 };
-    codecCtx->gop_size = 40;
-    codecCtx->max_b_frames = 0;
-    codecCtx->pix_fmt = AV_PIX_FMT_YUV420P;
+    // MOD: 降低帧率到20fps（原来30fps）
+    // 内容自适应时按内容配置的帧率，码率不变，低帧率下每帧可分到更多码率
+    const int fps = frameRate();
+    ctx->time_base = AVRational{ 1, fps };
+    ctx->framerate = AVRational{ fps, 1 };
+    // 帧内刷新模式下 gop_size 即刷新周期，不再产生周期 IDR
+    ctx->gop_size = options.intraRefresh ? options.intraRefreshPeriod : options.gopSize;
+    ctx->max_b_frames = 0;
+    ctx->pix_fmt = AV_PIX_FMT_YUV420P;
 
-    // 强制单线程
-    codecCtx->thread_count = 1;
+    switch (m_profile->codec)
+    {
+    case VIDEO_CODEC_H264:
+        // 设置低延迟预设和零延迟调优
+        av_opt_set(ctx->priv_data, "preset", (contentAdaptive && !governorFastPreset()) ? content.preset : "ultrafast", 0);
+        if (contentAdaptive)
+        {
+            // 文字内容压低 QP 上限保证清晰，运动内容放宽 QP 换取帧率
+            ctx->qmin = content.qmin;
+            ctx->qmax = content.qmax;
+        }
+        // MOD: 增加零延迟调优选项
+        av_opt_set(ctx->priv_data, "tune", "zerolatency", 0);
+        // 按需请求的 I 帧输出为 IDR，控制端可从该帧直接开始解码
+        av_opt_set(ctx->priv_data, "forced-idr", "1", 0);
+        if (options.intraRefresh)
+        {
+            av_opt_set(ctx->priv_data, "intra-refresh", "1", 0);
+        }
+        if (options.roiEncoding && !options.tiledMode)
+        {
+            // x264 只在开启自适应量化时使用 ROI，ultrafast 预设默认关闭；分块模式不附加 ROI，不需要开启
+            av_opt_set_int(ctx->priv_data, "aq-mode", 1, 0);
+        }
+        break;
+    case VIDEO_CODEC_HEVC:
+        av_opt_set(ctx->priv_data, "preset", (contentAdaptive && !governorFastPreset()) ? content.preset : "ultrafast", 0);
+        av_opt_set(ctx->priv_data, "tune", "zerolatency", 0);
+        av_opt_set(ctx->priv_data, "forced-idr", "1", 0);
+        // x265 的日志默认输出到 stderr，这里只保留错误
+        av_opt_set(ctx->priv_data, "x265-params",
+                   options.intraRefresh ? "log-level=error:intra-refresh=1" : "log-level=error", 0);
+        break;
+    case VIDEO_CODEC_VP9:
+        // 实时模式，不使用前向参考帧
+        av_opt_set(ctx->priv_data, "deadline", "realtime", 0);
+        av_opt_set(ctx->priv_data, "cpu-used", "8", 0);
+        av_opt_set_int(ctx->priv_data, "lag-in-frames", 0, 0);
+        av_opt_set_int(ctx->priv_data, "row-mt", 1, 0);
+        ctx->thread_count = qBound(1, QThread::idealThreadCount(), 4);
+        break;
+    case VIDEO_CODEC_AV1:
+        if (strcmp(codec->name, "libsvtav1") == 0)
+        {
+            // pred-struct=1 为低延迟结构，不产生 B 帧
+            av_opt_set(ctx->priv_data, "preset", "12", 0);
+            av_opt_set(ctx->priv_data, "svtav1-params", "pred-struct=1", 0);
+        }
+        else
+        {
+            av_opt_set(ctx->priv_data, "usage", "realtime", 0);
+            av_opt_set(ctx->priv_data, "cpu-used", "10", 0);
+            av_opt_set_int(ctx->priv_data, "lag-in-frames", 0, 0);
+            av_opt_set_int(ctx->priv_data, "row-mt", 1, 0);
+        }
+        ctx->thread_count = qBound(1, QThread::idealThreadCount(), 4);
+        break;
+    default:
+        break;
+    }
 
-    av_opt_set(codecCtx->priv_data, "preset", "ultrafast", 0);
-    av_opt_set(codecCtx->priv_data, "tune", "zerolatency", 0);
+    if (options.qualityStats)
+    {
+        ctx->flags |= AV_CODEC_FLAG_PSNR;
+    }
 
-    if (avcodec_open2(codecCtx, codec, nullptr) < 0) {
-        LogWidget::instance()->addLog("Could not open codec", LogWidget::Error);
+    // 编码输出直接写入池化缓冲，见 getEncodeBuffer。编码器不支持时由 emitPacket 拷贝一次
+    // 分块模式下多个编码器并行输出，不共用 m_pendingBuffer
+    if (codec && (codec->capabilities & AV_CODEC_CAP_DR1) && !options.tiledMode)
+    {
+        ctx->opaque = this;
+        ctx->get_encode_buffer = &ScreenCaptureEncoder::getEncodeBuffer;
     }
+}
 
-    // 分配新的视频帧
-    frame = av_frame_alloc();
-    if (!frame)
+void ScreenCaptureEncoder::setDecoderCapabilities(const QList<int>& decoders)
+{
+    // 按配置的优先级取第一个本机可编码且控制端可解码的格式
+    const VideoCodecProfile* selected = nullptr;
+    const AVCodec* selectedEncoder = nullptr;
+    for (const QString& name : EncoderOptions::global().codecs)
     {
-        LogWidget::instance()->addLog("Could not allocate video frame", LogWidget::Error);
+        const VideoCodecProfile* profile = VideoCodecProfile::find(name);
+        if (!profile)
+        {
+            LogWidget::instance()->addLog(QString("ScreenCaptureEncoder: Unknown codec \"%1\" in config").arg(name), LogWidget::Warning);
+            continue;
+        }
+        if (!decoders.contains(profile->codec))
+        {
+            continue;
+        }
+        const AVCodec* encoder = profile->findEncoder();
+        if (!encoder)
+        {
+            continue;
+        }
+        selected = profile;
+        selectedEncoder = encoder;
+        break;
+    }
+    if (!selected)
+    {
+        selected = VideoCodecProfile::defaultProfile();
+        selectedEncoder = selected->findEncoder();
+    }
+    if (selected == m_profile || !selectedEncoder)
+    {
+        return;
     }
-    frame->format = codecCtx->pix_fmt;
-    frame->width = codecCtx->width;
-    frame->height = codecCtx->height;
+    switchCodec(selected, selectedEncoder);
+    if (m_damageNotifier)
+    {
+        scheduleCapture();
+    }
+}
 
-    int ret = av_image_alloc(frame->data, frame->linesize, codecCtx->width, codecCtx->height,
-                             codecCtx->pix_fmt, 32);
-    if (ret < 0)
+void ScreenCaptureEncoder::switchCodec(const VideoCodecProfile* profile, const AVCodec* encoder)
+{
+    // 切换格式：旧格式的所有管线和参数集都不再可用
+    const VideoCodecProfile* previous = m_profile;
+    m_profile = profile;
+    codec = encoder;
+    freeTiles();
+    for (EncoderPipeline* pipeline : m_pipelines)
     {
-        LogWidget::instance()->addLog("Could not allocate raw picture buffer", LogWidget::Error);
+        freePipeline(pipeline);
     }
+    m_pipelines.clear();
+    m_pipeline = nullptr;
+    m_parameterSets.clear();
+    m_stats.reset();
 
-    // 重新初始化转换上下文
-    swsCtx = sws_getContext(codecCtx->width, codecCtx->height, AV_PIX_FMT_BGRA,
-                            codecCtx->width, codecCtx->height, codecCtx->pix_fmt,
-                            SWS_BILINEAR, nullptr, nullptr, nullptr);
-    if (!swsCtx)
+    // 下一帧按新格式重建管线，第一帧必须是关键帧
+    m_keyframeRequested = true;
+    m_lastForcedKeyframe.invalidate();
+    LogWidget::instance()->addLog(
+        QString("ScreenCaptureEncoder: Codec switched %1 -> %2 (%3)")
+            .arg(previous->name)
+            .arg(m_profile->name)
+            .arg(codec->name),
+        LogWidget::Info);
+}
+
+int ScreenCaptureEncoder::getEncodeBuffer(AVCodecContext* ctx, AVPacket* pkt, int flags)
+{
+    Q_UNUSED(flags);
+    ScreenCaptureEncoder* encoder = static_cast<ScreenCaptureEncoder*>(ctx->opaque);
+
+    PacketBufferPtr buffer = PacketBufferPool::instance().acquire(pkt->size, AV_INPUT_BUFFER_PADDING_SIZE);
+    // AVBufferRef 持有一份引用，av_packet_unref 时释放
+    PacketBufferPtr* ref = new PacketBufferPtr(buffer);
+    pkt->buf = av_buffer_create(buffer->payload(), pkt->size + AV_INPUT_BUFFER_PADDING_SIZE,
+                                &ScreenCaptureEncoder::releaseEncodeBuffer, ref, 0);
+    if (!pkt->buf)
     {
-        LogWidget::instance()->addLog("Could not initialize the conversion context", LogWidget::Error);
+        delete ref;
+        return AVERROR(ENOMEM);
+    }
+    pkt->data = pkt->buf->data;
+
+    // emitPacket 按 payload 地址认领该缓冲
+    encoder->m_pendingBuffer = buffer;
+    return 0;
+}
+
+void ScreenCaptureEncoder::releaseEncodeBuffer(void* opaque, uint8_t* data)
+{
+    Q_UNUSED(data);
+    delete static_cast<PacketBufferPtr*>(opaque);
+}
+
+void ScreenCaptureEncoder::startCapture()
+{
+    m_sessionActive = true;
+    m_waitingFirstFrame = true;
+    m_firstFrameTimer.start();
+
+    // 先发送缓存的 SPS/PPS，控制端解码器可在关键帧到达前完成初始化
+    if (!m_parameterSets.isEmpty())
+    {
+        VideoPacketInfo info;
+        info.frameId = m_packetFrameId;
+        info.codec = m_profile->codec;
+        emit encodedPacketReady(PacketBufferPool::instance().acquireCopy(m_parameterSets.constData(), m_parameterSets.size()), info);
+    }
+
+    // 新会话的解码器没有任何参考帧，立即编码当前屏幕为 IDR，不等第一个定时周期
+    m_keyframeRequested = true;
+    m_lastForcedKeyframe.invalidate();
+    captureAndEncode();
+
+    if (m_damageNotifier)
+    {
+        // 画面变化时才采集，最高 maxFps
+        m_damageNotifier->setEnabled(true);
+        LogWidget::instance()->addLog(
+            QString("ScreenCaptureEncoder: Damage-driven capture via %1, max %2 fps")
+                .arg(m_capture->name())
+                .arg(EncoderOptions::global().maxFps),
+            LogWidget::Info);
+        return;
+    }
+
+    // MOD: 使用定时器触发间隔以实现帧率 FRAME_FPS
+    timer->start(1000 / frameRate());
+}
+
+int ScreenCaptureEncoder::frameRate() const
+{
+    int fps = FRAME_FPS;
+    if (EncoderOptions::global().contentAdaptive && !EncoderOptions::global().tiledMode)
+    {
+        fps = ContentClassifier::profile(m_contentType).maxFps;
+    }
+    if (EncoderOptions::global().governor)
+    {
+        fps = qMax(1, qRound(fps * m_governor.current().fpsScale));
     }
+    if (m_viewportMaxFps > 0)
+    {
+        fps = qMin(fps, m_viewportMaxFps);
+    }
+    return fps;
+}
+
+bool ScreenCaptureEncoder::governorFastPreset() const
+{
+    return EncoderOptions::global().governor && m_governor.current().fastPreset;
+}
 
-    qDebug() << "Encoder reinitialized with resolution:" << codecCtx->width << "x" << codecCtx->height;
+void ScreenCaptureEncoder::applyGovernorLevel()
+{
+    const EncodeGovernor::Level& level = m_governor.current();
+    LogWidget::instance()->addLog(
+        QString("[Encode-Governor] %1 => fps x%2, size x%3%4")
+            .arg(m_governor.lastDecision())
+            .arg(level.fpsScale, 0, 'f', 2)
+            .arg(level.sizeScale, 0, 'f', 2)
+            .arg(level.fastPreset ? ", ultrafast" : ""),
+        LogWidget::Info);
 
-    // MOD: 重启定时器，使用50ms间隔
-    timer->start(1000 / FRAME_FPS);
+    if (timer->isActive())
+    {
+        timer->setInterval(1000 / frameRate());
+    }
+    // 编码尺寸和预设只能换管线，分块模式只调节帧率
+    if (m_pipeline && !EncoderOptions::global().tiledMode)
+    {
+        switchPipeline(getFixedSize());
+    }
 }
 
-QImage ScreenCaptureEncoder::grabDXG()
+void ScreenCaptureEncoder::applyContentType(ContentClassifier::ContentType type)
 {
-    if (!m_pDXGIManager)
+    m_contentType = type;
+    const ContentProfile& content = ContentClassifier::profile(type);
+    LogWidget::instance()->addLog(
+        QString("ScreenCaptureEncoder: Content switched to %1 (dirty %2%, edges %3%), preset %4, qp %5-%6, %7 fps")
+            .arg(content.name)
+            .arg(qRound(m_classifier.dirtyRatio() * 100))
+            .arg(qRound(m_classifier.edgeDensity() * 100))
+            .arg(content.preset)
+            .arg(content.qmin)
+            .arg(content.qmax)
+            .arg(content.maxFps),
+        LogWidget::Info);
+
+    // preset 和 QP 范围只能在打开编码器时设置，每种内容各用一套管线，切换后第一帧为 IDR
+    if (m_pipeline)
     {
-        qDebug() << "Error no DXGIManager";
-        return QImage();
+        switchPipeline(m_pipeline->size);
     }
+    if (timer->isActive())
+    {
+        timer->setInterval(1000 / frameRate());
+    }
+}
 
-    QImage bufferImage;
-    HRESULT hr = m_pDXGIManager->CaptureScreen(bufferImage);
-    m_iFrame += 1;
+void ScreenCaptureEncoder::scheduleCapture()
+{
+    if (!m_sessionActive)
+    {
+        return;
+    }
+    if (m_damageNotifier)
+    {
+        // 到采集完成前不再监听，否则描述符一直可读会让事件循环空转
+        m_damageNotifier->setEnabled(false);
+    }
+    if (m_captureCapTimer->isActive())
+    {
+        return;
+    }
 
-    if (SUCCEEDED(hr))
+    int fps = EncoderOptions::global().maxFps;
+    if (EncoderOptions::global().contentAdaptive && !EncoderOptions::global().tiledMode)
+    {
+        fps = qMin(fps, ContentClassifier::profile(m_contentType).maxFps);
+    }
+    if (EncoderOptions::global().governor)
     {
-        m_image = bufferImage;
+        fps = qMax(1, qRound(fps * m_governor.current().fpsScale));
     }
+    if (m_viewportMaxFps > 0)
+    {
+        fps = qMin(fps, m_viewportMaxFps);
+    }
+    const int minInterval = 1000 / fps;
+    const qint64 elapsed = m_lastCapture.isValid() ? m_lastCapture.elapsed() : minInterval;
+    if (elapsed < minInterval)
+    {
+        m_captureCapTimer->start(static_cast<int>(minInterval - elapsed));
+        return;
+    }
+    captureDamaged();
+}
 
-    return m_image;
+void ScreenCaptureEncoder::captureDamaged()
+{
+    captureAndEncode();
+    if (!m_sessionActive || !m_damageNotifier)
+    {
+        return;
+    }
+    m_damageNotifier->setEnabled(true);
+    // 抓图时 Xlib 可能已把新的通知读入内部队列，描述符不会再变为可读，需主动检查
+    // 被限流的关键帧请求同样需要再安排一次采集
+    if (m_capture->hasPendingDamage() || m_keyframeRequested)
+    {
+        scheduleCapture();
+    }
 }
 
-void ScreenCaptureEncoder::initDXGIManager()
+void ScreenCaptureEncoder::warmUp()
 {
-    if (!m_pDXGIManager)
+    if (m_sessionActive)
     {
-        m_pDXGIManager = new DXGIManager;
-        m_pDXGIManager->SetCaptureSource(CSMonitor1);//!< 屏幕1 主屏
-        //!< 获取主屏大小，并先初始化一个图片内存
-        RECT rcDest;
-        m_pDXGIManager->GetOutputRect(rcDest);
-        m_iDeskHeight = rcDest.bottom - rcDest.top; //!< 主屏高度
-        m_iDeskWidth = rcDest.right - rcDest.left;	//!< 主屏宽度
-        m_iBuffSize = m_iDeskWidth * m_iDeskHeight * 4;	//!< 图片缓冲大小
+        return;
+    }
+    QElapsedTimer warmUpTimer;
+    warmUpTimer.start();
+    captureAndEncode();
 
-        m_image = QImage(m_iDeskWidth, m_iDeskHeight, QImage::Format_RGB32);//!< 图片大小
+    // 预建另一方向的管线，屏幕旋转时直接切换
+    if (m_pipeline && !EncoderOptions::global().tiledMode)
+    {
+        QSize alternate = m_pipeline->size.transposed();
+        if (!findPipeline(alternate))
+        {
+            EncoderPipeline* pipeline = createPipeline(alternate);
+            if (pipeline)
+            {
+                m_pipelines.append(pipeline);
+            }
+        }
     }
+    LogWidget::instance()->addLog(
+        QString("ScreenCaptureEncoder: Encoder warmed up in %1 ms").arg(warmUpTimer.elapsed()),
+        LogWidget::Info);
 }
 
-void ScreenCaptureEncoder::unitDXGIManager()
+CaptureFrame ScreenCaptureEncoder::grabScreen()
 {
-    if (m_pDXGIManager)
+    if (!m_capture)
     {
-        delete m_pDXGIManager;
-        m_pDXGIManager = Q_NULLPTR;
+        LogWidget::instance()->addLog("ScreenCaptureEncoder: No capture backend", LogWidget::Error);
+        return CaptureFrame();
+    }
+    return m_capture->grab();
+}
+
+void ScreenCaptureEncoder::initCapture()
+{
+    if (m_capture)
+    {
+        return;
+    }
+    m_capture = CaptureBackend::create();
+    if (!m_capture)
+    {
+        LogWidget::instance()->addLog("No capture backend for this platform", LogWidget::Error);
+        return;
+    }
+    if (!m_capture->init())
+    {
+        LogWidget::instance()->addLog(QString("Failed to initialize %1 capture").arg(m_capture->name()), LogWidget::Error);
     }
 }
 
@@ -293,29 +819,526 @@ QSize ScreenCaptureEncoder::getFixedSize()
         LogWidget::instance()->addLog("No primary screen found!", LogWidget::Error);
         return size;
     }
+    // 默认编码尺寸 FIXED_W x FIXED_H，setTargetSize 可指定更小的尺寸（按横屏给出）
+    QSize baseSize = m_targetSize.isValid() ? m_targetSize : QSize(FIXED_W, FIXED_H);
     QSize screenSize = screen->size();
     if (screenSize.width() > screenSize.height())
     {
-        size = QSize(FIXED_W, FIXED_H);
+        size = baseSize;
+    }
+    else
+    {
+        size = baseSize.transposed();
+    }
+
+    QSize captureSize = m_capture ? m_capture->size() : QSize();
+    if (captureSize.isEmpty())
+    {
+        captureSize = screenSize;
+    }
+    if (!m_viewportSize.isValid())
+    {
+        // 没有显示区域时按源区域的宽高比放进默认编码尺寸，非 16:9 屏幕不拉伸，宽高取偶数
+        QSize fit = cropRect(captureSize).size();
+        if (!fit.isEmpty())
+        {
+            fit.scale(size, Qt::KeepAspectRatio);
+            size = QSize(qMax(64, fit.width() & ~1), qMax(64, fit.height() & ~1));
+        }
     }
     else
     {
-        size = QSize(FIXED_H, FIXED_W);
+        // 按控制端显示区域编码：源区域比显示区域大时缩小到显示区域，否则按源区域原始分辨率编码
+        // 两种情况都不超过默认编码尺寸
+        QSize fit = cropRect(captureSize).size();
+        if (fit.width() > m_viewportSize.width() || fit.height() > m_viewportSize.height())
+        {
+            fit.scale(m_viewportSize, Qt::KeepAspectRatio);
+        }
+        if (fit.width() > size.width() || fit.height() > size.height())
+        {
+            fit.scale(size, Qt::KeepAspectRatio);
+        }
+        // 取 8 的倍数，窗口拖动时尺寸小幅变化不会频繁新建管线
+        size = QSize(qMax(64, (fit.width() + 4) & ~7), qMax(64, (fit.height() + 4) & ~7));
+    }
+
+    // 负载调节降低分辨率
+    const qreal scale = EncoderOptions::global().governor ? m_governor.current().sizeScale : 1.0;
+    if (scale < 1.0)
+    {
+        size = QSize(qMax(64, qRound(size.width() * scale) & ~7), qMax(64, qRound(size.height() * scale) & ~7));
     }
 
     return size;
 }
 
+QRect ScreenCaptureEncoder::cropRect(const QSize& captureSize) const
+{
+    const QRect full(QPoint(0, 0), captureSize);
+    if (m_crop.isEmpty())
+    {
+        return full;
+    }
+    QRect rect(qRound(m_crop.x() * captureSize.width()), qRound(m_crop.y() * captureSize.height()),
+               qRound(m_crop.width() * captureSize.width()), qRound(m_crop.height() * captureSize.height()));
+    rect = rect.intersected(full);
+    if (rect.width() < 16 || rect.height() < 16)
+    {
+        return full;
+    }
+    return rect;
+}
+
+void ScreenCaptureEncoder::setViewport(const QSize& size, const QRectF& crop, int maxFps)
+{
+    m_viewportSize = size.isValid() ? size : QSize();
+    const bool fpsChanged = (maxFps != m_viewportMaxFps);
+    m_viewportMaxFps = qMax(0, maxFps);
+    // 只接受落在屏幕内的区域，整屏或无效区域按整屏处理
+    const QRectF normalized = crop.intersected(QRectF(0, 0, 1, 1));
+    m_crop = (normalized.width() >= 1.0 && normalized.height() >= 1.0) ? QRectF() : normalized;
+    LogWidget::instance()->addLog(
+        QString("ScreenCaptureEncoder: Viewport %1x%2, crop %3,%4 %5x%6, max fps %7")
+            .arg(m_viewportSize.width())
+            .arg(m_viewportSize.height())
+            .arg(m_crop.x(), 0, 'f', 3)
+            .arg(m_crop.y(), 0, 'f', 3)
+            .arg(m_crop.width(), 0, 'f', 3)
+            .arg(m_crop.height(), 0, 'f', 3)
+            .arg(m_viewportMaxFps > 0 ? QString::number(m_viewportMaxFps) : QString("-")),
+        LogWidget::Debug);
+    if (fpsChanged && timer && timer->isActive())
+    {
+        timer->setInterval(1000 / frameRate());
+    }
+    if (m_damageNotifier)
+    {
+        // 画面静止时也要按新区域重新编码
+        m_keyframeRequested = true;
+        scheduleCapture();
+    }
+}
+
+void ScreenCaptureEncoder::requestKeyframe()
+{
+    if (!m_keyframeRequested)
+    {
+        LogWidget::instance()->addLog("Keyframe requested by controller", LogWidget::Debug);
+    }
+    m_keyframeRequested = true;
+    if (m_damageNotifier)
+    {
+        // 变化触发模式下画面静止时没有定时采集，需要主动安排一帧
+        scheduleCapture();
+    }
+}
+
 void ScreenCaptureEncoder::stopCapture()
 {
+    m_sessionActive = false;
+    // 显示区域属于会话，下一个控制端重新上报
+    m_viewportSize = QSize();
+    m_crop = QRectF();
+    m_viewportMaxFps = 0;
+    // 负载等级和内容类型按会话重新评估，新会话从文字配置和空的分块哈希开始
+    m_governor.reset();
+    m_classifier.reset();
+    if (m_contentType != ContentClassifier::ContentText)
+    {
+        m_contentType = ContentClassifier::ContentText;
+        if (m_pipeline && !EncoderOptions::global().tiledMode)
+        {
+            switchPipeline(m_pipeline->size);
+        }
+    }
     if (timer)
     {
         timer->stop();
     }
+    if (m_captureCapTimer)
+    {
+        m_captureCapTimer->stop();
+    }
+    if (m_damageNotifier)
+    {
+        m_damageNotifier->setEnabled(false);
+    }
+    // 下一个控制端的解码器先按 H264 打开，协商前必须收到 H264：恢复默认格式并重新预热缓存 SPS/PPS
+    const VideoCodecProfile* defaultProfile = VideoCodecProfile::defaultProfile();
+    const AVCodec* defaultEncoder = defaultProfile->findEncoder();
+    if (m_profile != defaultProfile && defaultEncoder)
+    {
+        switchCodec(defaultProfile, defaultEncoder);
+        QMetaObject::invokeMethod(this, "warmUp", Qt::QueuedConnection);
+    }
+}
+
+void ScreenCaptureEncoder::cacheParameterSets(const AVPacket* pkt)
+{
+    // VP9/AV1 不是 Annex B 码流，序列头随关键帧发送，无需单独缓存
+    if (!m_profile->annexB)
+    {
+        return;
+    }
+    QByteArray parameterSets;
+    const QList<NalUnit> units = NalUnitParser::split(pkt->data, pkt->size, m_profile->hevc);
+    for (const NalUnit& unit : units)
+    {
+        if (NalUnitParser::isParameterSet(unit.type, m_profile->hevc))
+        {
+            parameterSets.append(reinterpret_cast<const char*>(unit.data), unit.size);
+        }
+    }
+    if (!parameterSets.isEmpty())
+    {
+        m_parameterSets = parameterSets;
+    }
+}
+
+void ScreenCaptureEncoder::emitPacket(const AVPacket* pkt)
+{
+    VideoPacketInfo info;
+    info.frameId = m_packetFrameId++;
+    info.keyFrame = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+    info.codec = m_profile->codec;
+    info.sourceRect = m_sourceRect;
+    info.screenSize = m_captureSize;
+    info.captureTimeUs = m_captureTimeUs;
+    info.encodeDoneUs = deskClockUs();
+    if (info.keyFrame)
+    {
+        // 周期性关键帧同样满足挂起的请求
+        m_keyframeRequested = false;
+        cacheParameterSets(pkt);
+    }
+
+    if (!m_sessionActive)
+    {
+        return;
+    }
+    if (m_waitingFirstFrame)
+    {
+        m_waitingFirstFrame = false;
+        LogWidget::instance()->addLog(
+            QString("ScreenCaptureEncoder: Time to first frame %1 ms").arg(m_firstFrameTimer.elapsed()),
+            LogWidget::Info);
+    }
+
+    if (!EncoderOptions::global().sliceMode || m_profile->codec != VIDEO_CODEC_H264)
+    {
+        // 编码器直接写入的池化缓冲，原样交给发送端
+        PacketBufferPtr buffer;
+        if (m_pendingBuffer && m_pendingBuffer->payload() == pkt->data)
+        {
+            buffer = m_pendingBuffer;
+            buffer->setPayloadSize(pkt->size);
+        }
+        else
+        {
+            buffer = PacketBufferPool::instance().acquireCopy(pkt->data, pkt->size);
+        }
+        emit encodedPacketReady(buffer, info);
+        return;
+    }
+
+    // 按 slice 拆包，每个 slice 立即发出，不等待整帧组包
+    // 每个 slice 前都要写帧头，无法共用编码缓冲，各拷贝一次到独立的池化缓冲
+    const QList<QPair<int, int>> chunks = NalUnitParser::splitSlices(pkt->data, pkt->size);
+    info.sliceCount = chunks.size();
+    for (int i = 0; i < chunks.size(); ++i)
+    {
+        info.sliceIndex = i;
+        emit encodedPacketReady(PacketBufferPool::instance().acquireCopy(pkt->data + chunks[i].first, chunks[i].second), info);
+    }
+}
+
+void ScreenCaptureEncoder::freeTiles()
+{
+    if (m_tilePool)
+    {
+        m_tilePool->waitForDone();
+    }
+    for (TileSlot* tile : m_tiles)
+    {
+        freePipeline(tile->pipeline);
+        av_packet_free(&tile->packet);
+        delete tile;
+    }
+    m_tiles.clear();
+    m_tileSurface = QSize();
+}
+
+bool ScreenCaptureEncoder::ensureTiles(const QSize& surfaceSize)
+{
+    if (surfaceSize == m_tileSurface && !m_tiles.isEmpty())
+    {
+        return true;
+    }
+    freeTiles();
+
+    const EncoderOptions& options = EncoderOptions::global();
+    // 分界对齐到 16 像素（宏块），最后一列/行吃掉剩余部分，YUV420 要求宽高为偶数
+    QList<int> xs;
+    QList<int> ys;
+    for (int c = 0; c <= options.tileColumns; ++c)
+    {
+        xs.append(c == options.tileColumns ? (surfaceSize.width() & ~1) : ((surfaceSize.width() * c / options.tileColumns) & ~15));
+    }
+    for (int r = 0; r <= options.tileRows; ++r)
+    {
+        ys.append(r == options.tileRows ? (surfaceSize.height() & ~1) : ((surfaceSize.height() * r / options.tileRows) & ~15));
+    }
+
+    for (int r = 0; r < options.tileRows; ++r)
+    {
+        for (int c = 0; c < options.tileColumns; ++c)
+        {
+            TileSlot* tile = new TileSlot;
+            tile->rect = QRect(xs[c], ys[r], xs[c + 1] - xs[c], ys[r + 1] - ys[r]);
+            tile->pipeline = createPipeline(tile->rect.size());
+            tile->packet = av_packet_alloc();
+            m_tiles.append(tile);
+            if (!tile->pipeline || !tile->packet)
+            {
+                freeTiles();
+                return false;
+            }
+        }
+    }
+
+    if (!m_tilePool)
+    {
+        m_tilePool = new QThreadPool(this);
+    }
+    m_tilePool->setMaxThreadCount(qBound(1, QThread::idealThreadCount(), static_cast<int>(m_tiles.size())));
+    m_tileSurface = surfaceSize;
+    LogWidget::instance()->addLog(
+        QString("ScreenCaptureEncoder: Tiled mode %1x%2 on %3x%4 surface, %5 threads")
+            .arg(options.tileColumns)
+            .arg(options.tileRows)
+            .arg(surfaceSize.width())
+            .arg(surfaceSize.height())
+            .arg(m_tilePool->maxThreadCount()),
+        LogWidget::Info);
+    return true;
+}
+
+bool ScreenCaptureEncoder::updateTileReference(TileSlot* tile, const QImage& image)
+{
+    const int rowBytes = tile->rect.width() * 4;
+    const int rows = tile->rect.height();
+    bool changed = (tile->reference.size() != rowBytes * rows);
+    if (changed)
+    {
+        tile->reference.resize(rowBytes * rows);
+    }
+    char* ref = tile->reference.data();
+    for (int y = 0; y < rows; ++y)
+    {
+        const uchar* src = image.constScanLine(tile->rect.y() + y) + tile->rect.x() * 4;
+        char* dst = ref + y * rowBytes;
+        // 找到第一处不同后其余行直接拷贝
+        if (changed || memcmp(dst, src, rowBytes) != 0)
+        {
+            changed = true;
+            memcpy(dst, src, rowBytes);
+        }
+    }
+    return changed;
+}
+
+void ScreenCaptureEncoder::encodeTile(TileSlot* tile, const QImage& image, bool forceKeyframe)
+{
+    EncoderPipeline* pipeline = tile->pipeline;
+    AVCodecContext* ctx = pipeline->codecCtx;
+    AVFrame* frame = pipeline->frame;
+    tile->output.reset();
+
+    // 逐字节比较，1 像素的光标、下划线等细小变化也不会漏掉
+    const bool changed = updateTileReference(tile, image);
+    if (!changed && !forceKeyframe && !tile->needsKeyframe)
+    {
+        return;
+    }
+
+    // tile 按原始分辨率编码，sws 只做颜色转换
+    pipeline->swsCtx = sws_getCachedContext(pipeline->swsCtx,
+                                            tile->rect.width(), tile->rect.height(), AV_PIX_FMT_BGRA,
+                                            ctx->width, ctx->height, ctx->pix_fmt,
+                                            SWS_POINT, nullptr, nullptr, nullptr);
+    if (!pipeline->swsCtx)
+    {
+        return;
+    }
+    const uint8_t* srcData[4] = {
+        image.constBits() + tile->rect.y() * image.bytesPerLine() + tile->rect.x() * 4,
+        nullptr, nullptr, nullptr
+    };
+    int srcLinesize[4] = { static_cast<int>(image.bytesPerLine()), 0, 0, 0 };
+    sws_scale(pipeline->swsCtx, srcData, srcLinesize, 0, tile->rect.height(), frame->data, frame->linesize);
+
+    frame->pts = tile->pts++;
+    frame->pict_type = (forceKeyframe || tile->needsKeyframe) ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+    if (avcodec_send_frame(ctx, frame) < 0)
+    {
+        return;
+    }
+    if (avcodec_receive_packet(ctx, tile->packet) == 0)
+    {
+        tile->output = PacketBufferPool::instance().acquireCopy(tile->packet->data, tile->packet->size);
+        tile->outputKey = (tile->packet->flags & AV_PKT_FLAG_KEY) != 0;
+        if (tile->outputKey)
+        {
+            tile->needsKeyframe = false;
+        }
+        av_packet_unref(tile->packet);
+    }
+    else
+    {
+        // 没有输出，下一帧重新编码
+        tile->reference.clear();
+    }
+}
+
+void ScreenCaptureEncoder::captureAndEncodeTiles()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    m_lastCapture.start();
+    CaptureFrame captured = grabScreen();
+    const QImage& screenImg = captured.image;
+    if (screenImg.isNull())
+    {
+        return;
+    }
+    m_captureTimeUs = deskClockUs();
+    if (captured.dirtyRects.isEmpty() && !m_keyframeRequested)
+    {
+        return;
+    }
+    // tile 编码器按打开时的帧率分配码率，帧率变化后重建
+    if (!m_tiles.isEmpty() && m_tiles.first()->pipeline->fps != frameRate())
+    {
+        freeTiles();
+    }
+    if (!ensureTiles(screenImg.size()))
+    {
+        LogWidget::instance()->addLog("ScreenCaptureEncoder: Failed to create tile encoders", LogWidget::Error);
+        return;
+    }
+
+    bool forceKeyframe = false;
+    if (m_keyframeRequested &&
+        (!m_lastForcedKeyframe.isValid() ||
+         m_lastForcedKeyframe.elapsed() >= EncoderOptions::global().keyframeRequestIntervalMs))
+    {
+        forceKeyframe = true;
+        m_keyframeRequested = false;
+        m_lastForcedKeyframe.start();
+    }
+
+    // 与采集后端给出的变化区域相交的 tile 在线程池中逐字节比较，只编码内容有变化或需要关键帧的 tile，
+    // 其余 tile 在控制端保持上一次的画面。不支持变化检测的后端总是给出整屏
+    QList<TileSlot*> work;
+    for (TileSlot* tile : m_tiles)
+    {
+        bool candidate = forceKeyframe || tile->needsKeyframe;
+        for (int i = 0; !candidate && i < captured.dirtyRects.size(); ++i)
+        {
+            candidate = captured.dirtyRects[i].intersects(tile->rect);
+        }
+        if (candidate)
+        {
+            work.append(tile);
+        }
+    }
+    if (work.isEmpty())
+    {
+        return;
+    }
+
+    for (TileSlot* tile : work)
+    {
+        m_tilePool->start([tile, &screenImg, forceKeyframe]() {
+            encodeTile(tile, screenImg, forceKeyframe);
+        });
+    }
+    m_tilePool->waitForDone();
+
+    int totalSize = 0;
+    bool anyKey = false;
+    int lastIndex = -1;
+    for (int i = 0; i < work.size(); ++i)
+    {
+        if (work[i]->output)
+        {
+            totalSize += work[i]->output->payloadSize();
+            anyKey = anyKey || work[i]->outputKey;
+            lastIndex = i;
+        }
+    }
+    if (lastIndex < 0)
+    {
+        return;
+    }
+    m_stats.addFrame(totalSize, anyKey, timer.nsecsElapsed() / 1000);
+    if (EncoderOptions::global().governor && m_governor.addFrame(timer.nsecsElapsed() / 1000, 1000 / frameRate()))
+    {
+        applyGovernorLevel();
+    }
+    if (m_stats.ready())
+    {
+        LogWidget::instance()->addLog(m_stats.summary(QString("%1 tiled %2x%3").arg(m_profile->name)
+                                                          .arg(EncoderOptions::global().tileColumns)
+                                                          .arg(EncoderOptions::global().tileRows)),
+                                      LogWidget::Info);
+    }
+
+    const quint32 frameId = m_packetFrameId++;
+    if (!m_sessionActive)
+    {
+        return;
+    }
+    if (m_waitingFirstFrame)
+    {
+        m_waitingFirstFrame = false;
+        LogWidget::instance()->addLog(
+            QString("ScreenCaptureEncoder: Time to first frame %1 ms").arg(m_firstFrameTimer.elapsed()),
+            LogWidget::Info);
+    }
+    for (int i = 0; i <= lastIndex; ++i)
+    {
+        TileSlot* tile = work[i];
+        if (!tile->output)
+        {
+            continue;
+        }
+        VideoPacketInfo info;
+        info.frameId = frameId;
+        info.keyFrame = tile->outputKey;
+        info.codec = m_profile->codec;
+        info.sourceRect = tile->rect;
+        info.screenSize = screenImg.size();
+        info.tileId = m_tiles.indexOf(tile);
+        info.tileCount = m_tiles.size();
+        info.lastTile = (i == lastIndex);
+        info.captureTimeUs = m_captureTimeUs;
+        info.encodeDoneUs = deskClockUs();
+        emit encodedPacketReady(tile->output, info);
+        tile->output.reset();
+    }
 }
 
 void ScreenCaptureEncoder::captureAndEncode()
 {
+    if (EncoderOptions::global().tiledMode)
+    {
+        captureAndEncodeTiles();
+        return;
+    }
+
     QElapsedTimer timer;
     timer.start(); // 开始计时
 
@@ -325,28 +1348,80 @@ void ScreenCaptureEncoder::captureAndEncode()
         LogWidget::instance()->addLog("No primary screen foundt", LogWidget::Error);
         return;
     }
-    if (currentScreenSize.width() != codecCtx->width || currentScreenSize.height() != codecCtx->height)
+    // 帧率变化（负载调节、显示区域帧率上限）同样换管线：time_base 只能在打开编码器时设置，
+    // 沿用旧管线时码率控制仍按原帧率给每帧分配预算
+    if (m_pipeline && currentScreenSize == m_pipeline->size && m_pipeline->fps != frameRate())
     {
-        LogWidget::instance()->addLog(
-            QString("Screen resolution changed from %1x%2 to %3x%4")
-                .arg(codecCtx->width)
-                .arg(codecCtx->height)
-                .arg(currentScreenSize.width())
-                .arg(currentScreenSize.height()),
-            LogWidget::Info);
-        // 分辨率变化时重新初始化编码器
-        reinitializeEncoder(currentScreenSize.width(), currentScreenSize.height());
-        return; // 本次不进行编码,下个周期会使用新参数捕获
+        if (!switchPipeline(currentScreenSize))
+        {
+            return;
+        }
     }
+    if (!m_pipeline || currentScreenSize != m_pipeline->size)
+    {
+        if (m_pipeline)
+        {
+            LogWidget::instance()->addLog(
+                QString("Screen resolution changed from %1x%2 to %3x%4")
+                    .arg(m_pipeline->size.width())
+                    .arg(m_pipeline->size.height())
+                    .arg(currentScreenSize.width())
+                    .arg(currentScreenSize.height()),
+                LogWidget::Info);
+        }
+        // 分辨率变化时切换到对应尺寸的管线，本帧直接按新尺寸编码
+        if (!switchPipeline(currentScreenSize))
+        {
+            return;
+        }
+    }
+    AVCodecContext* codecCtx = m_pipeline->codecCtx;
+    AVFrame* frame = m_pipeline->frame;
 
     // 捕获整个屏幕
     //QPixmap pixmap = screen->grabWindow(0);
     //QImage image = pixmap.toImage().convertToFormat(QImage::Format_ARGB32);
 
-    QImage dxgImg = grabDXG();
-    // MOD: 直接使用原始分辨率,不改变尺寸
-    QImage scaledImage = dxgImg.scaled(codecCtx->width, codecCtx->height, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    QImage image = scaledImage.convertToFormat(QImage::Format_ARGB32);
+    m_lastCapture.start();
+    CaptureFrame captured = grabScreen();
+    const QImage& screenImg = captured.image;
+    if (screenImg.isNull())
+    {
+        return;
+    }
+    m_captureTimeUs = deskClockUs();
+    if (EncoderOptions::global().contentAdaptive || EncoderOptions::global().roiEncoding)
+    {
+        ContentClassifier::ContentType content = m_classifier.analyze(screenImg);
+        if (EncoderOptions::global().contentAdaptive && content != m_contentType)
+        {
+            applyContentType(content);
+            codecCtx = m_pipeline->codecCtx;
+            frame = m_pipeline->frame;
+        }
+    }
+    // 画面没有变化且没有待处理的关键帧请求时不编码
+    // captured.dirtyRects 为本帧的变化区域，供后续按区域处理
+    if (captured.dirtyRects.isEmpty() && !m_keyframeRequested)
+    {
+        return;
+    }
+    // 只编码控制端要显示的区域，裁剪通过偏移源指针实现，不拷贝
+    const QRect sourceRect = cropRect(screenImg.size());
+    m_sourceRect = sourceRect;
+    m_captureSize = screenImg.size();
+
+    // 缩放与颜色转换都交给 sws，从采集尺寸一步转换到编码尺寸，不再经过 QImage::scaled
+    // 源区域尺寸不变时 sws_getCachedContext 直接返回原上下文
+    m_pipeline->swsCtx = sws_getCachedContext(m_pipeline->swsCtx,
+                                              sourceRect.width(), sourceRect.height(), AV_PIX_FMT_BGRA,
+                                              codecCtx->width, codecCtx->height, codecCtx->pix_fmt,
+                                              SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!m_pipeline->swsCtx)
+    {
+        LogWidget::instance()->addLog("Could not initialize the conversion context", LogWidget::Error);
+        return;
+    }
 
     // QByteArray data;
     // QBuffer buffer(&data);
@@ -368,16 +1443,31 @@ void ScreenCaptureEncoder::captureAndEncode()
 
 
 
-    uint8_t* srcData[4] = { scaledImage.bits(), nullptr, nullptr, nullptr };
-    int srcLinesize[4] = { static_cast<int>(scaledImage.bytesPerLine()), 0, 0, 0 };
+    const uint8_t* srcData[4] = {
+        screenImg.constBits() + sourceRect.y() * screenImg.bytesPerLine() + sourceRect.x() * 4,
+        nullptr, nullptr, nullptr
+    };
+    int srcLinesize[4] = { static_cast<int>(screenImg.bytesPerLine()), 0, 0, 0 };
 
     // 转换图像格式
-    sws_scale(swsCtx, srcData, srcLinesize, 0, codecCtx->height, frame->data, frame->linesize);
+    sws_scale(m_pipeline->swsCtx, srcData, srcLinesize, 0, sourceRect.height(), frame->data, frame->linesize);
 
     frame->pts = frameCounter++;
+    attachRegionsOfInterest(frame, sourceRect, screenImg.size());
 
-    // 编码该帧
-    AVPacket* pkt = av_packet_alloc();
+    // 按需关键帧，两次强制 IDR 之间至少间隔 keyframeRequestIntervalMs
+    frame->pict_type = AV_PICTURE_TYPE_NONE;
+    if (m_keyframeRequested &&
+        (!m_lastForcedKeyframe.isValid() ||
+         m_lastForcedKeyframe.elapsed() >= EncoderOptions::global().keyframeRequestIntervalMs))
+    {
+        frame->pict_type = AV_PICTURE_TYPE_I;
+        m_keyframeRequested = false;
+        m_lastForcedKeyframe.start();
+    }
+
+    // 编码该帧，AVPacket 在构造时分配一次，每帧复用
+    AVPacket* pkt = m_packet;
     if (!pkt)
     {
         LogWidget::instance()->addLog("Could not allocate AVPacket", LogWidget::Warning);
@@ -388,25 +1478,37 @@ void ScreenCaptureEncoder::captureAndEncode()
     if (ret < 0)
     {
         LogWidget::instance()->addLog("Error sending frame for encoding", LogWidget::Warning);
-        av_packet_free(&pkt);
         return;
     }
     ret = avcodec_receive_packet(codecCtx, pkt);
     if (ret == 0)
     {
-        QByteArray data(reinterpret_cast<const char*>(pkt->data), pkt->size);
-        emit encodedPacketReady(data);
+        m_stats.addFrame(pkt->size, (pkt->flags & AV_PKT_FLAG_KEY) != 0, timer.nsecsElapsed() / 1000);
+        collectQualityStats(pkt, codecCtx);
+        if (m_stats.ready())
+        {
+            QString mode = QString("%1 %2 %3%4%5").arg(m_profile->name,
+                                                       ContentClassifier::profile(m_contentType).name,
+                                                       EncoderOptions::global().intraRefresh ? "intra-refresh" : "gop",
+                                                       EncoderOptions::global().roiEncoding ? " roi" : "",
+                                                       m_governor.level() > 0 ? QString(" gov-L%1").arg(m_governor.level()) : QString());
+            LogWidget::instance()->addLog(m_stats.summary(mode), LogWidget::Info);
+        }
+        emitPacket(pkt);
         av_packet_unref(pkt);
-        av_packet_free(&pkt);
     }
     else if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
     {
-        av_packet_free(&pkt);
     }
     else
     {
         LogWidget::instance()->addLog("Error during encoding", LogWidget::Warning);
-        av_packet_free(&pkt);
+    }
+    m_pendingBuffer.reset();
+
+    if (EncoderOptions::global().governor && m_governor.addFrame(timer.nsecsElapsed() / 1000, 1000 / frameRate()))
+    {
+        applyGovernorLevel();
     }
     //
 
@@ -3,11 +3,18 @@
 
 #include <QObject>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QScreen>
 #include <QGuiApplication>
 #include <QImage>
 #include <QPixmap>
 #include <QDebug>
+#include "DeskDefine.h"
+#include "EncoderStats.h"
+#include "PacketBuffer.h"
+#include "CaptureBackend.h"
+#include "ContentClassifier.h"
+#include "EncodeGovernor.h"
 
 // FFmpeg includes
 extern "C" {
@@ -17,6 +24,10 @@ extern "C" {
 #include <libswscale/swscale.h>
 }
 
+class QSocketNotifier;
+class QThreadPool;
+struct VideoCodecProfile;
+
 class ScreenCaptureEncoder : public QObject
 {
     Q_OBJECT
@@ -24,43 +35,171 @@ public:
     explicit ScreenCaptureEncoder(QObject* parent = nullptr);
     ~ScreenCaptureEncoder();
 
+    // 进程内常驻的编码器，运行在独立线程上，跨会话复用已打开的编码器和屏幕采集
+    // 只能在主线程调用
+    static ScreenCaptureEncoder* shared();
+    static void releaseShared();
+
+public slots:
+    // 会话开始：先发缓存的 SPS/PPS，再立即编码当前屏幕为关键帧，之后按帧率定时采集
     void startCapture();
-    // 停止捕获
+    // 停止捕获，编码器保持打开供下一个会话使用
     void stopCapture();
+    // 预热：编码一帧但不输出，完成编码器初始化并缓存 SPS/PPS
+    void warmUp();
+    // 控制端请求关键帧，按 keyframeRequestIntervalMs 限流后在下一帧强制 IDR
+    void requestKeyframe();
+    // 指定编码尺寸（按横屏给出，竖屏自动交换宽高），空尺寸恢复默认。下一帧生效
+    void setTargetSize(const QSize& size);
+    // 控制端上报的可解码格式（VideoCodec 枚举值），按配置优先级选定编码格式，变化时重建编码器
+    void setDecoderCapabilities(const QList<int>& decoders);
+    // 控制端最近一次鼠标事件的位置（FIXED_W x FIXED_H 参考坐标，与输入事件一致），附近区域按感兴趣区域编码
+    void setPointerPosition(const QPoint& pos);
+    // 控制端显示区域（物理像素）和要显示的屏幕区域（归一化，空表示整屏）
+    // 编码尺寸按显示区域取，不超过源区域和默认编码尺寸，下一帧生效
+    // maxFps 为控制端需要的最高帧率，0 表示不限制
+    void setViewport(const QSize& size, const QRectF& crop, int maxFps);
 
 signals:
     // 当编码出数据包后发出信号，由外部处理发送逻辑
-    void encodedPacketReady(const QByteArray& packet);
+    // 分片模式下每个 slice 发一次，info 中带有帧序号和 slice 序号
+    // packet 为池化缓冲，payload 前留有写帧头的空间，接收方可直接就地组帧发送
+    void encodedPacketReady(const PacketBufferPtr& packet, const VideoPacketInfo& info);
 
 private slots:
     void captureAndEncode();
+    // 收到画面变化通知，按 maxFps 限速后采集
+    void scheduleCapture();
+    void captureDamaged();
 
 private:
-    void reinitializeEncoder(int newWidth, int newHeight);
+    // 一个编码尺寸对应的一套编码器、帧缓冲和转换上下文，分辨率切换时整体复用
+    struct EncoderPipeline
+    {
+        QSize size;
+        ContentClassifier::ContentType content = ContentClassifier::ContentText;
+        bool fastPreset = false; // 负载调节强制 ultrafast
+        int fps = 0;             // 打开时的帧率，码率控制按它给每帧分配预算
+        AVCodecContext* codecCtx = nullptr;
+        AVFrame* frame = nullptr;
+        struct SwsContext* swsCtx = nullptr; // 从采集尺寸直接缩放到编码尺寸
+    };
+
+    // 分块模式下的一个 tile：屏幕上的固定区域，独占一套编码管线，在线程池中并行编码
+    struct TileSlot
+    {
+        QRect rect;
+        EncoderPipeline* pipeline = nullptr;
+        AVPacket* packet = nullptr;
+        qint64 pts = 0;
+        // 新建的编码器第一帧必须是关键帧
+        bool needsKeyframe = true;
+        // 最近一次编码的 tile 像素（逐行紧密排列），逐字节比较判断是否变化
+        QByteArray reference;
+        // 本次编码的输出，编码线程写入，采集线程在全部完成后取走
+        PacketBufferPtr output;
+        bool outputKey = false;
+    };
+
+    EncoderPipeline* createPipeline(const QSize& size);
+    void freePipeline(EncoderPipeline* pipeline);
+    // 按尺寸、当前内容类型、负载调节的预设和当前帧率查找
+    EncoderPipeline* findPipeline(const QSize& size) const;
+    bool switchPipeline(const QSize& size);
+    // 内容类型变化：切换到对应配置的管线并调整采集帧率
+    void applyContentType(ContentClassifier::ContentType type);
+    // 当前采集帧率上限，开启内容自适应时由内容配置决定，再按负载调节等级降低
+    int frameRate() const;
+    // 负载调节等级变化：输出原因，调整帧率，需要时切换编码管线
+    void applyGovernorLevel();
+    bool governorFastPreset() const;
+    void setupCodecContext(AVCodecContext* ctx, int width, int height);
+    // AVCodecContext::get_encode_buffer 回调，让编码器把输出直接写进 PacketBufferPool 的缓冲
+    static int getEncodeBuffer(AVCodecContext* ctx, AVPacket* pkt, int flags);
+    static void releaseEncodeBuffer(void* opaque, uint8_t* data);
+    void emitPacket(const AVPacket* pkt);
+    // 按鼠标位置和最近变化的分块给 frame 附加 AV_FRAME_DATA_REGIONS_OF_INTEREST
+    // sourceRect 为本帧编码的屏幕区域（采集像素）
+    void attachRegionsOfInterest(AVFrame* frame, const QRect& sourceRect, const QSize& captureSize);
+    // 从 AV_PKT_DATA_QUALITY_STATS 取 QP 和 PSNR 计入统计
+    void collectQualityStats(const AVPacket* pkt, const AVCodecContext* ctx);
+    void cacheParameterSets(const AVPacket* pkt);
+    // 切换编码格式：释放旧格式的所有管线和参数集，下一帧按新格式重建
+    void switchCodec(const VideoCodecProfile* profile, const AVCodec* encoder);
 
-    QImage grabDXG();
-    void initDXGIManager();
-    void unitDXGIManager();
+    // 分块模式的采集与编码，tiledMode 开启时代替单路编码
+    void captureAndEncodeTiles();
+    // 按采集尺寸和 tileColumns x tileRows 建立 tile，尺寸不变时复用
+    bool ensureTiles(const QSize& surfaceSize);
+    void freeTiles();
+    // 在线程池中执行，只访问 tile 自己的状态。像素与上次编码相同且不需要关键帧时跳过
+    static void encodeTile(TileSlot* tile, const QImage& image, bool forceKeyframe);
+    // 逐行比较 tile 像素与上次编码的内容，有变化时更新参考并返回 true
+    static bool updateTileReference(TileSlot* tile, const QImage& image);
+
+    // 通过采集后端抓屏，Windows 为 DXGI，Linux 为 X11 MIT-SHM
+    CaptureFrame grabScreen();
+    void initCapture();
 
     QSize getFixedSize();
+    // 按 m_crop 计算要编码的屏幕区域
+    QRect cropRect(const QSize& captureSize) const;
 
-    // DXG屏幕捕获
-    bool m_bInitDXGI = false;
-    unsigned char* m_pBuff = Q_NULLPTR;
-    int m_iBuffSize = 0;
-    int m_iDeskWidth;
-    int m_iDeskHeight;
-    QImage m_image;
-    int m_iFrame = 0;
+    // 屏幕采集
+    CaptureBackend* m_capture = nullptr;
+    // 变化触发采集，采集后端不支持时为空，使用 timer 按 FRAME_FPS 轮询
+    QSocketNotifier* m_damageNotifier = nullptr;
+    QTimer* m_captureCapTimer = nullptr;
+    QElapsedTimer m_lastCapture;
+    // 帧采集时刻（deskClockUs），随包发给控制端安排播放和统计延迟
+    qint64 m_captureTimeUs = 0;
 
 private:
     // FFmpeg相关成员
     const AVCodec* codec;
-    AVCodecContext* codecCtx;
-    AVFrame* frame;
-    struct SwsContext* swsCtx;
+    // 当前编码格式，codec 为该格式下选中的 FFmpeg 编码器
+    const VideoCodecProfile* m_profile;
+    // 已建好的管线，最近使用的在前，最多保留 MAX_PIPELINES 个
+    static const int MAX_PIPELINES = 4;
+    QList<EncoderPipeline*> m_pipelines;
+    EncoderPipeline* m_pipeline = nullptr;
+    QSize m_targetSize;
+    ContentClassifier m_classifier;
+    EncodeGovernor m_governor;
+    ContentClassifier::ContentType m_contentType = ContentClassifier::ContentText;
+    // 分块模式
+    QList<TileSlot*> m_tiles;
+    QSize m_tileSurface;
+    QThreadPool* m_tilePool = nullptr;
+
+    QSize m_viewportSize;
+    QRectF m_crop;
+    int m_viewportMaxFps = 0;
+    // 最近一帧编码的屏幕区域和采集尺寸，随编码包发给控制端
+    QRect m_sourceRect;
+    QSize m_captureSize;
+    QPoint m_pointerPos;
+    QElapsedTimer m_pointerUpdated;
     int frameCounter;
+    AVPacket* m_packet = nullptr;
+    // 本次编码由 getEncodeBuffer 分配的缓冲
+    PacketBufferPtr m_pendingBuffer;
+    quint32 m_packetFrameId = 0;
+    bool m_keyframeRequested = false;
+    QElapsedTimer m_lastForcedKeyframe;
+    // 每 100 帧输出一次包大小方差和编码耗时
+    EncoderStats m_stats;
     QTimer* timer;
+
+    // 会话状态，未连接时编码结果不输出
+    bool m_sessionActive = false;
+    bool m_waitingFirstFrame = false;
+    QElapsedTimer m_firstFrameTimer;
+    // 最近一个关键帧中的 SPS/PPS
+    QByteArray m_parameterSets;
+
+    static ScreenCaptureEncoder* s_shared;
+    static QThread* s_sharedThread;
 };
 
 #endif // SCREENCAPTUREENCODER_H
@@ -0,0 +1,54 @@
+#include "VideoCodecProfile.h"
+
+const QList<VideoCodecProfile>& VideoCodecProfile::all()
+{
+    static const QList<VideoCodecProfile> profiles = {
+        { VIDEO_CODEC_H264, "h264", { "libx264" }, true, false },
+        { VIDEO_CODEC_HEVC, "hevc", { "libx265" }, true, true },
+        { VIDEO_CODEC_VP9, "vp9", { "libvpx-vp9" }, false, false },
+        { VIDEO_CODEC_AV1, "av1", { "libsvtav1", "libaom-av1" }, false, false },
+    };
+    return profiles;
+}
+
+const VideoCodecProfile* VideoCodecProfile::find(const QString& name)
+{
+    for (const VideoCodecProfile& profile : all())
+    {
+        if (profile.name.compare(name, Qt::CaseInsensitive) == 0)
+        {
+            return &profile;
+        }
+    }
+    return nullptr;
+}
+
+const VideoCodecProfile* VideoCodecProfile::find(VideoCodec codec)
+{
+    for (const VideoCodecProfile& profile : all())
+    {
+        if (profile.codec == codec)
+        {
+            return &profile;
+        }
+    }
+    return nullptr;
+}
+
+const VideoCodecProfile* VideoCodecProfile::defaultProfile()
+{
+    return find(VIDEO_CODEC_H264);
+}
+
+const AVCodec* VideoCodecProfile::findEncoder() const
+{
+    for (const QString& encoderName : encoderNames)
+    {
+        const AVCodec* encoder = avcodec_find_encoder_by_name(encoderName.toLatin1().constData());
+        if (encoder)
+        {
+            return encoder;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,33 @@
+#ifndef VIDEOCODECPROFILE_H
+#define VIDEOCODECPROFILE_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "rendezvous.pb.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 一种视频编码格式：配置中的名字、协议中的枚举值以及按顺序尝试的 FFmpeg 编码器
+struct VideoCodecProfile
+{
+    VideoCodec codec;
+    QString name;
+    QStringList encoderNames;
+    // 码流是否为 Annex B（H264/HEVC），可按 NAL 提取参数集和拆分 slice
+    bool annexB;
+    bool hevc;
+
+    // 返回第一个本机 FFmpeg 中可用的编码器，都不可用时返回 nullptr
+    const AVCodec* findEncoder() const;
+
+    static const QList<VideoCodecProfile>& all();
+    static const VideoCodecProfile* find(const QString& name);
+    static const VideoCodecProfile* find(VideoCodec codec);
+    // 默认格式 H264，所有控制端都能解码
+    static const VideoCodecProfile* defaultProfile();
+};
+
+#endif // VIDEOCODECPROFILE_H
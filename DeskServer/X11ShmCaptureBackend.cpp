@@ -0,0 +1,289 @@
+#include "X11ShmCaptureBackend.h"
+
+#ifdef Q_OS_LINUX
+
+#include "LogWidget.h"
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+
+struct X11ShmState
+{
+    Display* display = nullptr;
+    Window root = 0;
+    XImage* image = nullptr;
+    XShmSegmentInfo shmInfo;
+    bool attached = false;
+    // XDamage
+    Damage damage = 0;
+    int damageEventBase = 0;
+    // 第一帧没有参照，按整屏变化处理
+    bool fullDamage = true;
+};
+
+// XShmAttach 失败（如远程 X 服务器）时以错误事件通知，默认处理会直接退出进程
+static bool s_attachFailed = false;
+static int onAttachError(Display*, XErrorEvent*)
+{
+    s_attachFailed = true;
+    return 0;
+}
+
+X11ShmCaptureBackend::X11ShmCaptureBackend()
+    : d(new X11ShmState)
+{
+    d->shmInfo.shmid = -1;
+    d->shmInfo.shmaddr = nullptr;
+}
+
+X11ShmCaptureBackend::~X11ShmCaptureBackend()
+{
+    release();
+    delete d;
+}
+
+bool X11ShmCaptureBackend::init()
+{
+    release();
+
+    d->display = XOpenDisplay(nullptr);
+    if (!d->display)
+    {
+        LogWidget::instance()->addLog(
+            QString("X11ShmCaptureBackend: Cannot open display %1").arg(QString::fromLocal8Bit(qgetenv("DISPLAY"))),
+            LogWidget::Error);
+        return false;
+    }
+
+    int screen = DefaultScreen(d->display);
+    d->root = RootWindow(d->display, screen);
+    m_width = DisplayWidth(d->display, screen);
+    m_height = DisplayHeight(d->display, screen);
+    Visual* visual = DefaultVisual(d->display, screen);
+    int depth = DefaultDepth(d->display, screen);
+    if (depth != 24 && depth != 32)
+    {
+        LogWidget::instance()->addLog(QString("X11ShmCaptureBackend: Unsupported depth %1").arg(depth), LogWidget::Error);
+        release();
+        return false;
+    }
+
+    m_useShm = XShmQueryExtension(d->display);
+    if (m_useShm)
+    {
+        d->image = XShmCreateImage(d->display, visual, depth, ZPixmap, nullptr, &d->shmInfo, m_width, m_height);
+        if (d->image && d->image->bits_per_pixel == 32)
+        {
+            d->shmInfo.shmid = shmget(IPC_PRIVATE, d->image->bytes_per_line * d->image->height, IPC_CREAT | 0600);
+        }
+        if (d->shmInfo.shmid >= 0)
+        {
+            d->shmInfo.shmaddr = static_cast<char*>(shmat(d->shmInfo.shmid, nullptr, 0));
+            if (d->shmInfo.shmaddr == reinterpret_cast<char*>(-1))
+            {
+                d->shmInfo.shmaddr = nullptr;
+            }
+        }
+        if (d->shmInfo.shmaddr)
+        {
+            d->image->data = d->shmInfo.shmaddr;
+            d->shmInfo.readOnly = False;
+
+            s_attachFailed = false;
+            XErrorHandler previous = XSetErrorHandler(onAttachError);
+            Status status = XShmAttach(d->display, &d->shmInfo);
+            XSync(d->display, False);
+            XSetErrorHandler(previous);
+            d->attached = status && !s_attachFailed;
+        }
+        if (d->shmInfo.shmid >= 0)
+        {
+            // 双方都已附加，标记删除后在最后一方分离时由系统回收
+            shmctl(d->shmInfo.shmid, IPC_RMID, nullptr);
+        }
+        if (!d->attached)
+        {
+            LogWidget::instance()->addLog("X11ShmCaptureBackend: MIT-SHM unavailable, falling back to XGetImage", LogWidget::Warning);
+            if (d->image)
+            {
+                XDestroyImage(d->image);
+                d->image = nullptr;
+            }
+            if (d->shmInfo.shmaddr)
+            {
+                shmdt(d->shmInfo.shmaddr);
+                d->shmInfo.shmaddr = nullptr;
+            }
+            d->shmInfo.shmid = -1;
+            m_useShm = false;
+        }
+    }
+
+    // 根窗口的变化通知：区域由空变为非空时产生一个事件，之后由 takeDamage 取走并清空
+    // 变化区域通过 XFixes region 取回，两个扩展都需要
+    // 协议要求先交换版本号再使用扩展请求，版本协商失败时退回定时轮询
+    int damageErrorBase = 0;
+    int fixesEventBase = 0;
+    int fixesErrorBase = 0;
+    int damageMajor = 0;
+    int damageMinor = 0;
+    int fixesMajor = 0;
+    int fixesMinor = 0;
+    if (XDamageQueryExtension(d->display, &d->damageEventBase, &damageErrorBase) &&
+        XDamageQueryVersion(d->display, &damageMajor, &damageMinor) && damageMajor >= 1 &&
+        XFixesQueryExtension(d->display, &fixesEventBase, &fixesErrorBase) &&
+        XFixesQueryVersion(d->display, &fixesMajor, &fixesMinor) && fixesMajor >= 2)
+    {
+        d->damage = XDamageCreate(d->display, d->root, XDamageReportNonEmpty);
+        XFlush(d->display);
+    }
+    else
+    {
+        LogWidget::instance()->addLog("X11ShmCaptureBackend: DAMAGE or XFIXES extension unavailable, damage-driven capture disabled", LogWidget::Warning);
+    }
+    d->fullDamage = true;
+
+    m_image = QImage(m_width, m_height, QImage::Format_RGB32);
+    m_image.fill(Qt::black);
+
+    LogWidget::instance()->addLog(
+        QString("X11ShmCaptureBackend: Capturing %1x%2 via %3").arg(m_width).arg(m_height).arg(name()),
+        LogWidget::Info);
+    return true;
+}
+
+bool X11ShmCaptureBackend::supportsDamage() const
+{
+    return d->damage != 0;
+}
+
+int X11ShmCaptureBackend::damageHandle() const
+{
+    return d->display ? ConnectionNumber(d->display) : -1;
+}
+
+bool X11ShmCaptureBackend::hasPendingDamage()
+{
+    if (!d->display || !d->damage)
+    {
+        return false;
+    }
+    return XEventsQueued(d->display, QueuedAfterReading) > 0;
+}
+
+QList<QRect> X11ShmCaptureBackend::takeDamage()
+{
+    QList<QRect> rects;
+
+    // 丢弃已排队的通知，变化区域统一从 damage 对象中取
+    XEvent event;
+    while (XCheckTypedEvent(d->display, d->damageEventBase + XDamageNotify, &event))
+    {
+    }
+
+    XserverRegion region = XFixesCreateRegion(d->display, nullptr, 0);
+    XDamageSubtract(d->display, d->damage, 0, region);
+    int count = 0;
+    XRectangle* xrects = XFixesFetchRegion(d->display, region, &count);
+    for (int i = 0; i < count; ++i)
+    {
+        rects.append(QRect(xrects[i].x, xrects[i].y, xrects[i].width, xrects[i].height));
+    }
+    if (xrects)
+    {
+        XFree(xrects);
+    }
+    XFixesDestroyRegion(d->display, region);
+    return rects;
+}
+
+CaptureFrame X11ShmCaptureBackend::grab()
+{
+    CaptureFrame frame;
+    if (!d->display)
+    {
+        frame.image = m_image;
+        return frame;
+    }
+
+    // 先取走变化区域再抓图，抓图期间发生的变化会留到下一次
+    if (d->damage && !d->fullDamage)
+    {
+        frame.dirtyRects = takeDamage();
+    }
+    else
+    {
+        if (d->damage)
+        {
+            takeDamage();
+        }
+        frame.dirtyRects.append(QRect(0, 0, m_width, m_height));
+        d->fullDamage = false;
+    }
+
+    if (m_useShm)
+    {
+        if (XShmGetImage(d->display, d->root, d->image, 0, 0, AllPlanes))
+        {
+            // 直接引用共享内存，下一次 XShmGetImage 会覆盖其内容
+            m_image = QImage(reinterpret_cast<const uchar*>(d->image->data), m_width, m_height,
+                             d->image->bytes_per_line, QImage::Format_RGB32);
+        }
+        frame.image = m_image;
+        return frame;
+    }
+
+    XImage* image = XGetImage(d->display, d->root, 0, 0, m_width, m_height, AllPlanes, ZPixmap);
+    if (image)
+    {
+        if (image->bits_per_pixel == 32)
+        {
+            m_image = QImage(reinterpret_cast<const uchar*>(image->data), m_width, m_height,
+                             image->bytes_per_line, QImage::Format_RGB32).copy();
+        }
+        XDestroyImage(image);
+    }
+    frame.image = m_image;
+    return frame;
+}
+
+void X11ShmCaptureBackend::release()
+{
+    // 先丢弃可能引用共享内存的图像
+    m_image = QImage();
+    if (!d->display)
+    {
+        return;
+    }
+    if (d->damage)
+    {
+        XDamageDestroy(d->display, d->damage);
+        d->damage = 0;
+    }
+    if (d->attached)
+    {
+        XShmDetach(d->display, &d->shmInfo);
+        d->attached = false;
+    }
+    if (d->image)
+    {
+        // MIT-SHM 图像的 destroy 不释放 data，共享内存由下面的 shmdt 分离
+        XDestroyImage(d->image);
+        d->image = nullptr;
+    }
+    if (d->shmInfo.shmaddr)
+    {
+        shmdt(d->shmInfo.shmaddr);
+        d->shmInfo.shmaddr = nullptr;
+    }
+    d->shmInfo.shmid = -1;
+    XCloseDisplay(d->display);
+    d->display = nullptr;
+}
+
+#endif // Q_OS_LINUX
@@ -0,0 +1,42 @@
+#ifndef X11SHMCAPTUREBACKEND_H
+#define X11SHMCAPTUREBACKEND_H
+
+#include "CaptureBackend.h"
+
+#ifdef Q_OS_LINUX
+
+// Xlib 的宏与 Qt 冲突，X11 相关类型只在 .cpp 中出现
+struct X11ShmState;
+
+// X11 MIT-SHM 采集：XShmGetImage 把根窗口画面直接写入共享内存，grab() 返回的图像引用这块内存，不做拷贝
+// 通过 DISPLAY 连接 X 服务器，可在 Xvfb 上无界面运行。X 服务器不支持 MIT-SHM 时退回 XGetImage
+// X 服务器支持 DAMAGE 扩展时提供变化通知和变化区域
+class X11ShmCaptureBackend : public CaptureBackend
+{
+public:
+    X11ShmCaptureBackend();
+    ~X11ShmCaptureBackend() override;
+
+    bool init() override;
+    CaptureFrame grab() override;
+    bool supportsDamage() const override;
+    int damageHandle() const override;
+    bool hasPendingDamage() override;
+    QSize size() const override { return QSize(m_width, m_height); }
+    QString name() const override { return m_useShm ? "X11 MIT-SHM" : "X11"; }
+
+private:
+    void release();
+    // 取走自上次以来的 XDamage 变化区域
+    QList<QRect> takeDamage();
+
+    X11ShmState* d;
+    int m_width = 0;
+    int m_height = 0;
+    bool m_useShm = false;
+    QImage m_image;
+};
+
+#endif // Q_OS_LINUX
+
+#endif // X11SHMCAPTUREBACKEND_H
@@ -1,4 +1,6 @@
 #include "DeskServer.h"
+#include "DeskDefine.h"
+#include "PacketBuffer.h"
 #include <QtWidgets/QApplication>
 #include <QSharedMemory>
 #include <QtNetwork/QNetworkProxy>
@@ -63,6 +65,8 @@ int main(int argc, char *argv[])
 
     QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
     qRegisterMetaType<QHostAddress>("QHostAddress");
+    qRegisterMetaType<VideoPacketInfo>("VideoPacketInfo");
+    qRegisterMetaType<PacketBufferPtr>("PacketBufferPtr");
 
     const QString sharedMemoryKey = "DeskServerSharedMemory";
     QSharedMemory sharedMem(sharedMemoryKey);
@@ -43,22 +43,22 @@ void IDServer::onRegistrationSuccess(const QString& uuid, const QString& ip)
 		LogWidget::instance()->addLog("failed to write to database", LogWidget::Error);
 	}
 
-	// UIıжǷѴڸ uuid
+	// 更新UI的表格，先判断是否已存在该 uuid
 	bool exist = false;
 	for (int row = 0; row < model->rowCount(); ++row) {
 		QStandardItem* item = model->item(row, 0);
 		if (item && item->text() == uuid) {
-			// Ѵ״̬Ϊ Online
+			// 如果已存在则更新状态为 Online
 			QStandardItem* statusItem = model->item(row, 3);
 			statusItem->setText("Online");
-			// ipҲпܻ
+			// ip也有可能会更新
 			QStandardItem* ipItem = model->item(row, 1);
 			ipItem->setText(ip);
 			exist = true;
 			break;
 		}
 	}
-	// ڣ
+	// 如果不存在，则添加新行
 	if (!exist) {
 		QList<QStandardItem*> items;
 		items.append(new QStandardItem(uuid));
@@ -113,7 +113,7 @@ void IDServer::onStartClicked()
 	ui.stopButton_->setEnabled(true);
 	ui.lineEdit->setEnabled(false);
 
-	// ȡûϢ
+	// 获取所有用户信息
 	std::vector<UserInfo> userInfos = userInfoDB->getAllUserInfo();
 
 	if (userInfos.size() == 0)
@@ -121,12 +121,12 @@ void IDServer::onStartClicked()
 		return;
 	}
 
-	// 
+	// 清空现有数据
 	model->clear();
 
-	// ñͷ
+	// 设置表头
 	model->setHorizontalHeaderLabels({ "UUID", "IP",  "LastRegTime","Status" });
-	// ݼص model 
+	// 将数据加载到 model 中
 	for (const auto& userInfo : userInfos) {
 		QList<QStandardItem*> items;
 		items.append(new QStandardItem(QString::fromStdString(userInfo.UUID)));
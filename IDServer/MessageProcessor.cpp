@@ -17,7 +17,7 @@ void MessageProcessor::processMessage(const QByteArray& data, QTcpSocket* socket
 		LogWidget::instance()->addLog("Failed to parse RendezvousMessage from data", LogWidget::Warning);
 		return;
 	}
-	//  oneof ֶжϢ
+	// 根据 oneof 字段判断消息类型
 	 if (msg.has_register_peer()) {
 		emit registerPeer(msg.register_peer(), socket);
 	}
@@ -12,7 +12,7 @@ class MessageProcessor : public QObject {
 public:
 	explicit MessageProcessor( QObject* parent = nullptr);
 
-	// յϢdata ʽΪ JSON
+	// 处理接收到的消息（data 格式为 JSON）
 	void processMessage(const QByteArray& data, QTcpSocket* sockett);
 signals:
 	void registerPeer(const RegisterPeer& req, QTcpSocket* socket);
@@ -24,7 +24,7 @@ RendezvousServer::RendezvousServer(const std::shared_ptr<UserInfoDB> db, QObject
 bool RendezvousServer::start(quint16 port) {
 
 	tcpServer = new QTcpServer(this);
-	//  TCP 
+	// 启动 TCP 服务器
 	bool tcpOk = tcpServer->listen(QHostAddress::Any, port);
 	if (!tcpOk) {
 		LogWidget::instance()->addLog(QString("TCP Server error: %1").arg(tcpServer->errorString()), LogWidget::Error);
@@ -80,7 +80,7 @@ void RendezvousServer::handlePunchHoleRequest(const PunchHoleRequest& req, QTcpS
 		out.resize(msg.ByteSizeLong());
 		msg.SerializeToArray(out.data(), out.size());
 
-		// 4ֽڳͷ
+		// 添加4字节长度头
 		quint32 packetSize = static_cast<quint32>(out.size());
 		quint32 bigEndianSize = qToBigEndian(packetSize);
 		QByteArray header(reinterpret_cast<const char*>(&bigEndianSize), sizeof(bigEndianSize));
@@ -101,7 +101,7 @@ void RendezvousServer::handlePunchHoleRequest(const PunchHoleRequest& req, QTcpS
 		out.resize(msg.ByteSizeLong());
 		msg.SerializeToArray(out.data(), out.size());
 
-		// 4ֽڳͷ
+		// 添加4字节长度头
 		quint32 packetSize = static_cast<quint32>(out.size());
 		quint32 bigEndianSize = qToBigEndian(packetSize);
 		QByteArray header(reinterpret_cast<const char*>(&bigEndianSize), sizeof(bigEndianSize));
@@ -141,7 +141,7 @@ void RendezvousServer::handleRegisterPeer(const RegisterPeer& req, QTcpSocket* s
 	tcpPunchMap.insert(uuid, socket);
 	socket->write(fullData);
 	socket->setProperty("uuid", uuid);
-	// źţ֪ͨϲ㴦ݿUI
+	// 发射信号，通知上层处理数据库和UI更新
 	emit registrationSuccess(uuid, ip);
 }
 
@@ -165,12 +165,12 @@ void RendezvousServer::handlePunchHoleSent(const PunchHoleSent& req, QTcpSocket*
 		out.resize(msg.ByteSizeLong());
 		msg.SerializeToArray(out.data(), out.size());
 
-		// 4ֽڴ򳤶ͷ
+		// 构造4字节大端序长度头
 		quint32 packetSize = static_cast<quint32>(out.size());
 		quint32 bigEndianSize = qToBigEndian(packetSize);
 		QByteArray header(reinterpret_cast<const char*>(&bigEndianSize), sizeof(bigEndianSize));
 
-		// ݣ[ͷ][Ϣ]
+		// 组合完整数据：[长度头][消息数据]
 		QByteArray fullData;
 		fullData.append(header);
 		fullData.append(out);
@@ -15,9 +15,9 @@ class RendezvousServer : public QObject {
 	Q_OBJECT
 public:
 	explicit RendezvousServer(const std::shared_ptr<UserInfoDB> db,QObject* parent = nullptr);
-	// ָ̬˿ڣǷɹ
+	// 动态启动服务器，指定监听端口，返回是否启动成功
 	bool start(quint16 port);
-	// ֹͣ
+	// 停止服务器
 	void stop();
 
 
@@ -25,7 +25,7 @@ void UserInfoDB::close() {
 }
 
 bool UserInfoDB::purgeOldRecords() {
-	// ǰʱ䣬洢ʱΪ ISO ʽ
+	// 计算三天前的时间，假设存储的时间为 ISO 格式
 	QString threshold = QDateTime::currentDateTime().addDays(-3).toString(Qt::ISODate);
 	std::string sql = "DELETE FROM UserInfo WHERE LastRegTime IS NOT NULL AND LastRegTime < '" + threshold.toStdString() + "';";
 	return execute(sql);
@@ -33,7 +33,7 @@ bool UserInfoDB::purgeOldRecords() {
 
 std::vector<UserInfo> UserInfoDB::getAllUserInfo() {
 
-	// ǰļ¼
+	// 清理三天前的记录
 	purgeOldRecords();
 
 	std::vector<UserInfo> userInfos;
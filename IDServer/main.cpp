@@ -13,19 +13,19 @@
 
 LONG WINAPI MyUnhandledExceptionFilter(EXCEPTION_POINTERS* pExceptionPointers)
 {
-	//  dump ļʹö̬⸲֮ǰ dump ļ
+	// 定义 dump 文件名，建议使用动态命名以免覆盖之前的 dump 文件
 	TCHAR dumpFileName[MAX_PATH] = _T("crash_dump.dmp");
 
-	//  dump ļ
+	// 创建 dump 文件
 	HANDLE hFile = CreateFile(dumpFileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
 	if (hFile != INVALID_HANDLE_VALUE) {
-		//  dump 
+		// 设置 dump 参数
 		MINIDUMP_EXCEPTION_INFORMATION dumpInfo;
 		dumpInfo.ThreadId = GetCurrentThreadId();
 		dumpInfo.ExceptionPointers = pExceptionPointers;
 		dumpInfo.ClientPointers = FALSE;
 
-		//  dump ļMiniDumpNormal Ϣ
+		// 生成 dump 文件，MiniDumpNormal 生成最基本的信息
 		BOOL success = MiniDumpWriteDump(GetCurrentProcess(), GetCurrentProcessId(), hFile,
 			MiniDumpNormal, &dumpInfo, nullptr, nullptr);
 		if (success) {
@@ -40,7 +40,7 @@ LONG WINAPI MyUnhandledExceptionFilter(EXCEPTION_POINTERS* pExceptionPointers)
 		_tprintf(_T("Failed to create dump file. Error: %d\n"), GetLastError());
 	}
 
-	//  EXCEPTION_EXECUTE_HANDLERϵͳֹ
+	// 返回 EXCEPTION_EXECUTE_HANDLER，系统将终止程序
 	return EXCEPTION_EXECUTE_HANDLER;
 }
 
@@ -48,9 +48,9 @@ LONG WINAPI MyUnhandledExceptionFilter(EXCEPTION_POINTERS* pExceptionPointers)
 bool checkSingleInstance(const QString& key) {
 	static QSharedMemory sharedMem(key);
 	if (!sharedMem.create(1)) {
-		return false; // ʵ
+		return false; // 已有实例在运行
 	}
-	return true; // ûʵ
+	return true; // 没有实例在运行
 }
 int main(int argc, char *argv[])
 {
@@ -67,7 +67,7 @@ int main(int argc, char *argv[])
 	}
 	IDServer w;
 
-	// ֹ
+	// 禁止最大化
 	w.setWindowFlags(w.windowFlags() & ~Qt::WindowMaximizeButtonHint);
     w.show();
     return a.exec();
@@ -1,5 +1,28 @@
 #include "connectionhandler.h"
 #include "LogWidget.h"
+#include <chrono>
+
+// RendezvousMessage.relay_time_us 的字段号，转发时以 varint 追加在消息末尾
+#define RELAY_TIME_FIELD 100
+
+// 在已序列化的消息末尾追加中继时刻（单调时钟，微秒）。protobuf 允许字段出现在任意位置，
+// 标量字段以最后一次出现为准，因此无需解析整条消息
+static void appendRelayTime(QByteArray& packetData)
+{
+	quint64 value = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	quint32 tag = (RELAY_TIME_FIELD << 3) | 0;
+	while (tag >= 0x80) {
+		packetData.append(static_cast<char>((tag & 0x7F) | 0x80));
+		tag >>= 7;
+	}
+	packetData.append(static_cast<char>(tag));
+	while (value >= 0x80) {
+		packetData.append(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	packetData.append(static_cast<char>(value));
+}
 
 ConnectionHandler::ConnectionHandler(QObject* parent)
 	: QObject(parent)
@@ -18,13 +41,13 @@ ConnectionHandler::~ConnectionHandler()
 
 bool ConnectionHandler::start(qintptr socketDescriptor)
 {
-	// е socketDescriptor  QTcpSocket 
+	// 将已有的 socketDescriptor 与 QTcpSocket 关联
 	if (!m_socket.setSocketDescriptor(socketDescriptor)) {
 		LogWidget::instance()->addLog(QString("Failed to set socket descriptor: %1").arg(socketDescriptor), LogWidget::Warning);
 		return false;
 	}
 	m_socket.setSocketOption(QAbstractSocket::KeepAliveOption, 1);
-	// ݵͳʱźŲ
+	// 连接数据到达和超时的信号槽
 	connect(&m_socket, &QTcpSocket::readyRead, this, &ConnectionHandler::onReadyRead);
 	connect(&m_socket, &QTcpSocket::disconnected, this, &ConnectionHandler::disconnectFromPeer);
 	connect(&m_timer, &QTimer::timeout, this, &ConnectionHandler::onTimeout);
@@ -34,9 +57,9 @@ bool ConnectionHandler::start(qintptr socketDescriptor)
 void ConnectionHandler::pairWith(std::shared_ptr<ConnectionHandler> peer)
 {
 	m_peer = peer;
-	// Գɹֹͣʱʱ
+	// 配对成功后停止超时定时器
 	m_timer.stop();
-	// ΪתźŲۣյʱתԶ
+	// 为数据转发建立信号槽：当本端收到数据时转发给对端
 	connect(&m_socket, &QTcpSocket::readyRead, this, [this]() {
 		QByteArray data = m_socket.readAll();
 		if (m_peer && m_peer->socket()->state() == QAbstractSocket::ConnectedState) {
@@ -63,13 +86,13 @@ void ConnectionHandler::disconnectFromPeer()
 	m_isDisconnecting = true;
 
 	m_timer.stop();
-	// Ͽ m_socket صźӣֹ onReadyRead Ȳ
+	// 断开所有与 m_socket 相关的信号连接，防止后续触发 onReadyRead 等槽
 	m_socket.disconnect();
 
-	// ֹӣ
+	// 立即中止连接，清除缓冲区，避免后续处理残留数据
 	m_socket.abort();
 
-	// ԵĶԶӣϿֹѭ m_isDisconnecting ǣ
+	// 如果有配对的对端连接，则主动让其断开（防止死循环，检查 m_isDisconnecting 标记）
 	if (m_peer) 
 	{
 		if (!m_peer->m_isDisconnecting) {
@@ -101,16 +124,9 @@ void ConnectionHandler::onReadyRead()
 			break;
 
 		QByteArray packetData = buffer.mid(4, packetSize);
-		QByteArray fullPacket;
-		{
-			quint32 bigEndianSize = qToBigEndian(packetSize);
-			fullPacket.append(reinterpret_cast<const char*>(&bigEndianSize), sizeof(bigEndianSize));
-			fullPacket.append(packetData);
-		}
-
 		buffer.remove(0, 4 + packetSize);
 
-		// δ֣δԣϢ
+		// 如果还未完成握手（即未配对），则进行握手消息处理
 		if (!m_peer) {
 			RendezvousMessage msg;
 			if (msg.ParseFromArray(packetData.constData(), packetData.size())) {
@@ -138,13 +154,18 @@ void ConnectionHandler::onReadyRead()
 			}
 		}
 		else {
-			// ѾԣֱӽϢͷתԶ
+			// 如果已经配对，追加中继时刻后连同长度头转发给对端，两端据此分段统计延迟
 			if (m_peer->socket()->state() == QAbstractSocket::ConnectedState) {
+				appendRelayTime(packetData);
+				QByteArray fullPacket;
+				quint32 bigEndianSize = qToBigEndian(static_cast<quint32>(packetData.size()));
+				fullPacket.append(reinterpret_cast<const char*>(&bigEndianSize), sizeof(bigEndianSize));
+				fullPacket.append(packetData);
 				m_peer->socket()->write(fullPacket);
 			}
 		}
 	}
-	// ʣݴ socket У´ζȡʹ
+	// 将剩余的数据存回 socket 属性中，供下次读取使用
 	m_socket.setProperty("buffer", buffer);
 }
 
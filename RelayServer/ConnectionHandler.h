@@ -15,35 +15,35 @@ public:
 	explicit ConnectionHandler( QObject* parent = nullptr);
 	~ConnectionHandler();
 
-	// Ӵ
+	// 启动该连接处理器
 	bool start(qintptr socketDescriptor);
 
-	// Զ
+	// 与对端连接配对
 	void pairWith(std::shared_ptr<ConnectionHandler> peer);
 
-	// ʱʱλ룩
+	// 启动超时定时器（单位：毫秒）
 	void startTimeout(int msec);
 
-	// ϿǰӼԶ
+	// 断开当前连接及其对端连接
 	void disconnectFromPeer();
 
-	// ȡڲ QTcpSocket ָ
+	// 获取内部的 QTcpSocket 指针
 	QTcpSocket* socket();
 
 signals:
-	//  UUID мʱź
+	// 当解析到包含 UUID 的中继请求时发射该信号
 	void relayRequestReceived(const QString& uuid);
 
 private slots:
-	//  socket  readyRead ź
+	// 处理 socket 的 readyRead 信号
 	void onReadyRead();
-	// ʱ
+	// 超时处理槽
 	void onTimeout();
 
 private:
 	QTcpSocket m_socket;
 	QTimer m_timer;
-	// ԵĶԶ
+	// 配对的对端连接
 	std::shared_ptr<ConnectionHandler> m_peer;
 	bool m_isDisconnecting = false;
 	QString m_roleStr;
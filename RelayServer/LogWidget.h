@@ -16,14 +16,14 @@ class LogWidget : public QWidget
 {
 	Q_OBJECT
 public:
-	// ־ö
+	// 日志级别枚举
 	enum LogLevel {
 		Info,
 		Warning,
 		Error
 	};
 
-	// ʷ
+	// 单例访问方法
 	static LogWidget* instance()
 	{
 		static QMutex mutex;
@@ -34,35 +34,35 @@ public:
 		return m_instance;
 	}
 
-	// ʼø
+	// 初始化函数，设置父窗口
 	void init(QWidget* parent);
 
-	// ־Ϊ Q_INVOKABLE ̵ֿ֧߳
+	// 添加日志，建议标记为 Q_INVOKABLE 以支持跨线程调用
 	Q_INVOKABLE void addLog(const QString& logMessage, LogLevel level = Info);
 
-	// ÿ͸ֵ
+	// 禁用拷贝构造和赋值
 	LogWidget(const LogWidget&) = delete;
 	LogWidget& operator=(const LogWidget&) = delete;
 
 private:
-	// ˽й캯
+	// 私有构造函数
 	explicit LogWidget();
-	// ʱر־ļ
+	// 析构时关闭日志文件
 	~LogWidget() {
 		if (m_logFile) {
 			m_logFile->close();
 		}
 	}
 
-	// ʵʸ־ڲ
+	// 实际更新日志的内部函数
 	void appendLog(const QString& logMessage, LogLevel level, const QString& callerThreadId);
 
-	// ʵ
+	// 单例实例
 	static LogWidget* m_instance;
 
-	// UI
+	// UI组件
 	QTextEdit* logEdit;
-	// ־ļ
+	// 日志文件对象
 	QFile* m_logFile;
 };
 
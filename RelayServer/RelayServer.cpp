@@ -22,7 +22,7 @@ RelayServer::~RelayServer()
 
 void RelayServer::handleNewConnection()
 {
-	// еȴ
+	// 处理所有等待连接
 	while (m_server.hasPendingConnections()) {
 		QTcpSocket* socket = m_server.nextPendingConnection();
 		LogWidget::instance()->addLog(QString("received new connection %1").arg(socket->peerAddress().toString()));
@@ -37,7 +37,7 @@ void RelayServer::handleNewConnection()
 			continue;
 		}
 
-		//  ConnectionHandler յмʱ relayRequestReceived źŽ
+		// 当 ConnectionHandler 收到中继请求时，触发 relayRequestReceived 信号进行配对
 		connect(handler.get(), &ConnectionHandler::relayRequestReceived, this,
 			[=](const QString& uuid) {
 				tryPairing(uuid, handler);
@@ -79,15 +79,15 @@ void RelayServer::start()
 
 void RelayServer::stop()
 {
-	// رշ
+	// 关闭服务器
 	m_server.close();
 
-	// Ͽѽ
+	// 断开所有已建立的连接
 	for (auto& handler : mPeers) {
 		handler->disconnectFromPeer();
 	}
 
-	// յȴб
+	// 清空等待列表
 	mPeers.clear();
 
 	if (m_udpHeartbeatServer) {
@@ -105,17 +105,17 @@ void RelayServer::stop()
 
 void RelayServer::tryPairing(const QString& uuid, std::shared_ptr<ConnectionHandler> handler)
 {
-	// еȴеӣм̣ȴб
+	// 如果已有等待中的连接，则建立中继，否则加入等待列表
 	if (mPeers.contains(uuid)) {
 		LogWidget::instance()->addLog("UUID matched", LogWidget::Info);
 		auto peer = mPeers.take(uuid);
-		// ˫ת
+		// 建立双向数据转发
 		handler->pairWith(peer);
 		peer->pairWith(handler);
 	}
 	else {
 		mPeers.insert(uuid, handler);
-		// һʱʱδϿ
-		handler->startTimeout(30000);  // 30볬ʱ
+		// 启动一个定时器，若超时未配对则断开连接
+		handler->startTimeout(30000);  // 30秒超时
 	}
 }
\ No newline at end of file
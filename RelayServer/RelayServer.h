@@ -17,7 +17,7 @@ public:
 
 private:
 	void handleNewConnection();
-	// ƥ䲢м
+	// 匹配并进行中继
 	void tryPairing(const QString& uuid, std::shared_ptr<ConnectionHandler> handler);
 
 private slots :
@@ -28,7 +28,7 @@ private:
     Ui::RelayServerClass ui;
 
 	QTcpServer m_server;
-	// 洢ƥӣkey Ϊ uuid ʶ
+	// 存储待匹配的连接，key 为 uuid 或其他标识符
 	QMap<QString, std::shared_ptr<ConnectionHandler>> mPeers;
 	UdpHeartbeatServer* m_udpHeartbeatServer;
 };
@@ -3,7 +3,7 @@
 
 #include <QObject>
 #include <QtNetwork/QUdpSocket>
-#include "rendezvous.pb.h"  // Protobuf ɵͷļ
+#include "rendezvous.pb.h"  // Protobuf 生成的头文件
 
 class UdpHeartbeatServer : public QObject {
 	Q_OBJECT
@@ -11,11 +11,11 @@ public:
 	explicit UdpHeartbeatServer(QObject* parent = nullptr);
 	~UdpHeartbeatServer();
 
-	//  UDP ָ˿
+	// 启动 UDP 服务器，绑定指定端口
 	bool start(quint16 port);
 
 signals:
-	// ѡյͻظʱźţ־
+	// 可选：当收到心跳或发送回复时发出信号（方便日志或其他处理）
 	void heartbeatReceived(const QString& address, quint16 port);
 	void heartbeatSent(const QString& address, quint16 port);
 